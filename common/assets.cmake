@@ -0,0 +1,28 @@
+# Build-time asset compilation with tools/assetc.py
+#
+#   kiwi_add_asset(<target> <image|font|palette> <input> <header> [assetc options...])
+#
+# Generates <header> in the target's generated include directory whenever <input> or the
+# compiler changes, and makes the target depend on it.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(KIWI_ASSETC ${CMAKE_CURRENT_LIST_DIR}/../tools/assetc.py)
+
+function(kiwi_add_asset target kind input header)
+    set(output_dir ${CMAKE_CURRENT_BINARY_DIR}/generated)
+    get_filename_component(input ${input} ABSOLUTE)
+    set(output ${output_dir}/${header})
+
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${output_dir}
+        COMMAND ${Python3_EXECUTABLE} ${KIWI_ASSETC} ${kind} ${input} ${output} ${ARGN}
+        DEPENDS ${input} ${KIWI_ASSETC}
+        COMMENT "Compiling asset ${header}"
+        VERBATIM
+    )
+
+    target_sources(${target} PRIVATE ${output})
+    target_include_directories(${target} PRIVATE ${output_dir})
+endfunction()
@@ -0,0 +1,59 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "background.h"
+
+// Decode row y into line, which must be word aligned and hold the full width
+void background_decode_line(const background_t* background, uint32_t y, uint16_t* line)
+{
+    const uint8_t* rle = &background->rle[background->row_offsets[y]];
+    const uint8_t* end = &background->rle[background->row_offsets[y + 1]];
+    uint16_t* dst = line;
+
+    while (rle < end)
+    {
+        uint32_t count = rle[0] + 1;
+        const uint16_t colour = rle[1] | (rle[2] << 8);
+        rle += 3;
+
+        // Align to a word, then store two pixels at a time
+        if (((uintptr_t)dst & 2) != 0)
+        {
+            *dst++ = colour;
+            --count;
+        }
+        uint32_t* words = (uint32_t*)dst;
+        const uint32_t pair = colour * 0x00010001u;
+        for (uint32_t i = count >> 1; i > 0; --i)
+        {
+            *words++ = pair;
+        }
+        dst = (uint16_t*)words;
+        if (count & 1)
+        {
+            *dst++ = colour;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include <stdint.h>
+
+// Flash-resident background layer.
+//
+// An RGB565 image compiled by tools/assetc.py with --rle stays in flash as (count - 1, colour)
+// runs, one independently decodable sequence per row. Each scanline is decoded straight into the
+// line buffer during scanout and dynamic content is drawn over it, so the image needs no RAM and
+// the decode time of a line is bounded by the runs in its row (<NAME>_MAX_ROW_RUNS).
+
+typedef struct
+{
+    const uint8_t* rle;
+    const uint32_t* row_offsets; // Height + 1 entries
+    uint16_t width;
+    uint16_t height;
+} background_t;
+
+// Background from the tables generated for <name>.h
+#define BACKGROUND_ASSET(name, NAME) {name##_rle, name##_row_offsets, NAME##_WIDTH, NAME##_HEIGHT}
+
+// Function declarations
+void background_decode_line(const background_t* background, uint32_t y, uint16_t* line);
+
+#endif // BACKGROUND_H
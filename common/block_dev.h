@@ -0,0 +1,56 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef BLOCK_DEV_H
+#define BLOCK_DEV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Asynchronous block device.
+//
+// Only one command is outstanding at a time: read() or write() starts it and status() is polled
+// until it stops reporting BLOCK_DEV_BUSY. Implemented on top of the TinyUSB mass storage host on
+// the Pico and on an image file on the host.
+
+#define BLOCK_DEV_BLOCK_SIZE 512
+
+typedef enum
+{
+    BLOCK_DEV_IDLE = 0,
+    BLOCK_DEV_BUSY,
+    BLOCK_DEV_ERROR
+} block_dev_status_t;
+
+typedef struct block_dev
+{
+    uint32_t block_count;
+    bool (*read)(struct block_dev* dev, uint32_t lba, void* buffer, uint32_t count);
+    bool (*write)(struct block_dev* dev, uint32_t lba, const void* buffer, uint32_t count);
+    block_dev_status_t (*status)(struct block_dev* dev);
+    void* context;
+} block_dev_t;
+
+#endif // BLOCK_DEV_H
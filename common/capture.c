@@ -0,0 +1,309 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "capture.h"
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value & 0xff;
+    p[1] = value >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t value)
+{
+    put_u16(p, value & 0xffff);
+    put_u16(p + 2, value >> 16);
+}
+
+static uint32_t row_bytes(const capture_t* capture)
+{
+    return capture->width * sizeof(uint16_t);
+}
+
+// BITMAPFILEHEADER, BITMAPINFOHEADER with BI_BITFIELDS, then the RGB565 masks
+static void build_bmp_header(capture_t* capture)
+{
+    uint8_t* h = capture->header;
+    const uint32_t image_size = row_bytes(capture) * capture->height;
+
+    memset(h, 0, CAPTURE_BMP_HEADER_SIZE);
+    h[0] = 'B';
+    h[1] = 'M';
+    put_u32(h + 2, CAPTURE_BMP_HEADER_SIZE + image_size);
+    put_u32(h + 10, CAPTURE_BMP_HEADER_SIZE);
+    put_u32(h + 14, 40);
+    put_u32(h + 18, capture->width);
+    put_u32(h + 22, capture->height); // Positive: rows are stored bottom up
+    put_u16(h + 26, 1);
+    put_u16(h + 28, 16);
+    put_u32(h + 30, 3); // BI_BITFIELDS
+    put_u32(h + 34, image_size);
+    put_u32(h + 38, 2835); // 72 dpi
+    put_u32(h + 42, 2835);
+    put_u32(h + 54, 0xf800);
+    put_u32(h + 58, 0x07e0);
+    put_u32(h + 62, 0x001f);
+}
+
+void capture_init(capture_t* capture, fat_writer_t* writer, const uint16_t* framebuffer, uint16_t width,
+                  uint16_t height, uint32_t* tile_hashes)
+{
+    capture->writer = writer;
+    capture->framebuffer = framebuffer;
+    capture->width = width;
+    capture->height = height;
+    capture->mode = CAPTURE_IDLE;
+    capture->report[0] = '\0';
+    fb_stream_init(&capture->stream, framebuffer, width, height, tile_hashes);
+}
+
+static bool start(capture_t* capture, capture_mode_t mode, const char* prefix, const char* extension,
+                  uint64_t now_us)
+{
+    if (capture->mode != CAPTURE_IDLE || !fat_writer_open(capture->writer, prefix, extension))
+        return false;
+
+    capture->mode = mode;
+    capture->phase = CAPTURE_OPENING;
+    capture->fill = 0;
+    capture->fill_index = 0;
+    capture->start_us = now_us;
+    capture->bytes = 0;
+    return true;
+}
+
+// Start a screenshot. Fails if a capture is already running or no volume is mounted.
+bool capture_screenshot(capture_t* capture, uint64_t now_us)
+{
+    if (!start(capture, CAPTURE_SCREENSHOT, "SHOT", "BMP", now_us))
+        return false;
+
+    build_bmp_header(capture);
+    capture->header_pos = 0;
+    capture->row = capture->height - 1;
+    capture->row_pos = 0;
+    return true;
+}
+
+bool capture_record_start(capture_t* capture, uint64_t now_us)
+{
+    if (!start(capture, CAPTURE_RECORDING, "RECD", "FBS", now_us))
+        return false;
+
+    // A fresh stream, so the recording starts with a keyframe numbered 0
+    fb_stream_init(&capture->stream, capture->framebuffer, capture->width, capture->height,
+                   capture->stream.tile_hashes);
+    capture->packets_len = 0;
+    capture->packets_pos = 0;
+    capture->frames_since_record = CAPTURE_RECORD_FRAME_INTERVAL;
+    capture->frames_recorded = 0;
+    capture->stop_requested = false;
+    return true;
+}
+
+// Finish the frame being encoded and close the recording
+void capture_record_stop(capture_t* capture)
+{
+    if (capture->mode == CAPTURE_RECORDING)
+        capture->stop_requested = true;
+}
+
+// Drop the capture in progress, for when the volume has gone
+void capture_abort(capture_t* capture)
+{
+    if (capture->mode != CAPTURE_IDLE)
+        printf("Capture: aborted\r\n");
+    capture->mode = CAPTURE_IDLE;
+}
+
+// Call once per displayed frame, paces the recording
+void capture_frame(capture_t* capture)
+{
+    ++capture->frames_since_record;
+}
+
+// Copy as much as fits into the chunk being filled
+static uint32_t put(capture_t* capture, const void* data, uint32_t len)
+{
+    const uint32_t room = CAPTURE_CHUNK_SIZE - capture->fill;
+    if (len > room)
+        len = room;
+    memcpy(&capture->chunks[capture->fill_index][capture->fill], data, len);
+    capture->fill += len;
+    return len;
+}
+
+// Fill the chunk from the framebuffer. Returns true once the whole image has been copied.
+static bool produce_screenshot(capture_t* capture)
+{
+    capture->header_pos += put(capture, capture->header + capture->header_pos,
+                               CAPTURE_BMP_HEADER_SIZE - capture->header_pos);
+
+    // RGB565 pixels are stored little-endian in both
+    while (capture->row >= 0 && capture->fill < CAPTURE_CHUNK_SIZE)
+    {
+        const uint8_t* row = (const uint8_t*)&capture->framebuffer[capture->row * capture->width];
+        capture->row_pos += put(capture, row + capture->row_pos, row_bytes(capture) - capture->row_pos);
+        if (capture->row_pos == row_bytes(capture))
+        {
+            capture->row_pos = 0;
+            --capture->row;
+        }
+    }
+    return capture->row < 0;
+}
+
+// Encode a few tiles and copy the packets into the chunk. Returns true once the recording has
+// been stopped and the last frame is in the chunks.
+static bool produce_recording(capture_t* capture)
+{
+    fb_stream_t* stream = &capture->stream;
+
+    if (capture->packets_pos == capture->packets_len)
+    {
+        capture->packets_len = 0;
+        capture->packets_pos = 0;
+
+        if (!fb_stream_busy(stream))
+        {
+            if (capture->stop_requested)
+                return true;
+            if (capture->frames_since_record < CAPTURE_RECORD_FRAME_INTERVAL)
+                return false;
+
+            fb_stream_begin_frame(stream, capture->frames_recorded % CAPTURE_RECORD_KEYFRAME_INTERVAL == 0);
+            capture->frames_since_record = 0;
+            ++capture->frames_recorded;
+        }
+        capture->packets_len =
+            (uint32_t)fb_stream_encode(stream, capture->packets, sizeof(capture->packets), CAPTURE_TILES_PER_POLL);
+    }
+
+    capture->packets_pos +=
+        put(capture, capture->packets + capture->packets_pos, capture->packets_len - capture->packets_pos);
+    return false;
+}
+
+// Hand the chunk being filled to the writer and switch to the other one
+static bool submit_chunk(capture_t* capture)
+{
+    if (fat_writer_busy(capture->writer) ||
+        !fat_writer_append(capture->writer, capture->chunks[capture->fill_index], capture->fill))
+        return false;
+
+    capture->bytes += capture->fill;
+    capture->fill_index ^= 1;
+    capture->fill = 0;
+    return true;
+}
+
+static void finish(capture_t* capture, uint64_t now_us)
+{
+    char name[13];
+    fat_writer_file_name(capture->writer, name);
+
+    const uint32_t elapsed_us = (uint32_t)(now_us - capture->start_us);
+    const uint32_t ms = elapsed_us / 1000;
+    // Bytes per microsecond is MB/s
+    const uint32_t rate = elapsed_us ? (uint32_t)((uint64_t)capture->bytes * 1000 / elapsed_us) : 0;
+
+    char frames[24] = "";
+    if (capture->mode == CAPTURE_RECORDING)
+        snprintf(frames, sizeof(frames), ", %lu frames", (unsigned long)capture->frames_recorded);
+    snprintf(capture->report, sizeof(capture->report), "Capture: %s, %lu bytes%s in %lu ms, %lu.%03lu MB/s", name,
+             (unsigned long)capture->bytes, frames, (unsigned long)ms, (unsigned long)(rate / 1000),
+             (unsigned long)(rate % 1000));
+    capture->mode = CAPTURE_IDLE;
+}
+
+static void fail(capture_t* capture)
+{
+    const char* error = capture->writer->error;
+    snprintf(capture->report, sizeof(capture->report), "Capture: failed, %s", error ? error : "volume not ready");
+    capture->mode = CAPTURE_IDLE;
+}
+
+// Call often, between scanline pushes: advances the FAT writer, then copies or encodes at most
+// one chunk's worth of data
+void capture_poll(capture_t* capture, uint64_t now_us)
+{
+    if (capture->mode == CAPTURE_IDLE)
+        return;
+
+    fat_writer_t* writer = capture->writer;
+    fat_writer_poll(writer);
+
+    switch (capture->phase)
+    {
+    case CAPTURE_OPENING:
+        if (writer->state == FAT_WRITER_OPEN)
+            capture->phase = CAPTURE_WRITING;
+        else if (writer->state != FAT_WRITER_OPENING)
+            fail(capture);
+        break;
+
+    case CAPTURE_WRITING:
+    {
+        if (writer->state != FAT_WRITER_OPEN)
+        {
+            fail(capture);
+            return;
+        }
+
+        // A full chunk waits for the writer to take it before anything more is produced
+        if (capture->fill == CAPTURE_CHUNK_SIZE && !submit_chunk(capture))
+            return;
+
+        const bool done = capture->mode == CAPTURE_SCREENSHOT ? produce_screenshot(capture)
+                                                              : produce_recording(capture);
+        if (capture->fill == CAPTURE_CHUNK_SIZE)
+            submit_chunk(capture);
+
+        // The last partial chunk, then close once it is written
+        if (done && (capture->fill == 0 || submit_chunk(capture)) && fat_writer_close(writer))
+            capture->phase = CAPTURE_CLOSING;
+        break;
+    }
+
+    case CAPTURE_CLOSING:
+        if (writer->state == FAT_WRITER_READY)
+            finish(capture, now_us);
+        else if (writer->state != FAT_WRITER_CLOSING)
+            fail(capture);
+        break;
+    }
+}
+
+// Call between frames: prints the result of a capture that has finished since the last call
+void capture_poll_report(capture_t* capture)
+{
+    if (capture->report[0] == '\0')
+        return;
+    printf("%s\r\n", capture->report);
+    capture->report[0] = '\0';
+}
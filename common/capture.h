@@ -0,0 +1,142 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fat_writer.h"
+#include "fb_stream.h"
+
+// Screenshots and recordings of an RGB565 framebuffer, written to a FAT32 volume.
+//
+// Screenshots are 16-bit BMP files (SHOTnnnn.BMP), the framebuffer rows copied as they are behind
+// a bit-field header. Recordings (RECDnnnn.FBS) hold the same tile delta packet stream as the UART
+// framebuffer stream (see fb_stream.h) and are decoded on the host by tools/fbdecode.
+//
+// Data goes through two chunk buffers: one is being written by the FAT writer while the other is
+// filled from the framebuffer. capture_poll() does a bounded amount of copying or encoding per
+// call and never prints, so it can be called between scanline pushes; the result of a finished
+// capture is printed by capture_poll_report() between frames. The framebuffer is read while the game keeps
+// drawing into it, so a screenshot taken during a move can show both positions of a cell.
+
+// Size of each chunk buffer, a whole number of sectors. The drive completes at most one command
+// per frame, and the FAT writer sends a chunk as a single write when its clusters follow on, so
+// this sets the write rate.
+#ifndef CAPTURE_CHUNK_SIZE
+#define CAPTURE_CHUNK_SIZE 8192
+#endif
+
+// Record one frame out of every CAPTURE_RECORD_FRAME_INTERVAL frames passed to capture_frame()
+#ifndef CAPTURE_RECORD_FRAME_INTERVAL
+#define CAPTURE_RECORD_FRAME_INTERVAL 2
+#endif
+
+// Recorded frames between keyframes
+#ifndef CAPTURE_RECORD_KEYFRAME_INTERVAL
+#define CAPTURE_RECORD_KEYFRAME_INTERVAL 60
+#endif
+
+// Maximum number of tiles encoded per call to capture_poll() while recording
+#ifndef CAPTURE_TILES_PER_POLL
+#define CAPTURE_TILES_PER_POLL 32
+#endif
+
+// Size of a 16-bit BMP header with colour masks
+#define CAPTURE_BMP_HEADER_SIZE 66
+
+// Longest result line kept for capture_poll_report()
+#define CAPTURE_REPORT_SIZE 96
+
+typedef enum
+{
+    CAPTURE_IDLE = 0,
+    CAPTURE_SCREENSHOT,
+    CAPTURE_RECORDING
+} capture_mode_t;
+
+typedef enum
+{
+    CAPTURE_OPENING = 0,
+    CAPTURE_WRITING,
+    CAPTURE_CLOSING
+} capture_phase_t;
+
+typedef struct
+{
+    fat_writer_t* writer;
+    const uint16_t* framebuffer;
+    uint16_t width;
+    uint16_t height;
+    capture_mode_t mode;
+    capture_phase_t phase;
+
+    // Double buffer: chunks[fill_index] is being filled, the other one may be with the writer
+    uint8_t chunks[2][CAPTURE_CHUNK_SIZE];
+    uint32_t fill;
+    uint8_t fill_index;
+
+    // Screenshot progress: BMP header, then rows from the bottom up
+    uint8_t header[CAPTURE_BMP_HEADER_SIZE];
+    uint32_t header_pos;
+    int row;
+    uint32_t row_pos;
+
+    // Recording
+    fb_stream_t stream;
+    uint8_t packets[FB_STREAM_MAX_PACKET * 2];
+    uint32_t packets_len;
+    uint32_t packets_pos;
+    uint32_t frames_since_record;
+    uint32_t frames_recorded;
+    bool stop_requested;
+
+    // Throughput of the capture in progress
+    uint64_t start_us;
+    uint32_t bytes;
+
+    // Result of the last capture, empty once printed
+    char report[CAPTURE_REPORT_SIZE];
+} capture_t;
+
+// Function declarations
+void capture_init(capture_t* capture, fat_writer_t* writer, const uint16_t* framebuffer, uint16_t width,
+                  uint16_t height, uint32_t* tile_hashes);
+bool capture_screenshot(capture_t* capture, uint64_t now_us);
+bool capture_record_start(capture_t* capture, uint64_t now_us);
+void capture_record_stop(capture_t* capture);
+void capture_abort(capture_t* capture);
+void capture_frame(capture_t* capture);
+void capture_poll(capture_t* capture, uint64_t now_us);
+void capture_poll_report(capture_t* capture);
+
+static inline bool capture_busy(const capture_t* capture)
+{
+    return capture->mode != CAPTURE_IDLE;
+}
+
+#endif // CAPTURE_H
@@ -0,0 +1,152 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "console.h"
+#include "display_mode.h"
+#include "renderer.h"
+
+#if PICO_ON_DEVICE
+#include "pico/stdio.h"
+#include "pico/stdio/driver.h"
+#endif
+
+static void clear_strip(const console_t* console, uint16_t* strip)
+{
+    render_fill_rect(strip, 0, 0, FRAME_WIDTH, console->font->height, console->bg);
+}
+
+// Point the console's screen lines at the strips in their current order
+static void map_lines(console_t* console)
+{
+    const int height = console->font->height;
+    for (int row = 0; row < console->rows; ++row)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            console->lines[row * height + y] = console->strips[row] + y * FRAME_WIDTH;
+        }
+    }
+}
+
+// pixels holds rows strips of FRAME_WIDTH x font height pixels, and lines the rows * font height
+// screen line pointers the console takes over. Each strip is drawn with render_fill_rect() and
+// render_glyph() as a framebuffer of font height lines.
+void console_init(console_t* console, const console_font_t* font, uint16_t* pixels, const uint16_t** lines, int rows,
+                  uint16_t fg, uint16_t bg)
+{
+    memset(console, 0, sizeof(*console));
+    console->font = font;
+    console->lines = lines;
+    console->rows = rows < CONSOLE_MAX_ROWS ? rows : CONSOLE_MAX_ROWS;
+    console->columns = FRAME_WIDTH / font->width;
+    console->fg = fg;
+    console->bg = bg;
+    for (int row = 0; row < console->rows; ++row)
+    {
+        console->strips[row] = &pixels[row * font->height * FRAME_WIDTH];
+    }
+    console_clear(console);
+}
+
+void console_clear(console_t* console)
+{
+    for (int row = 0; row < console->rows; ++row)
+    {
+        clear_strip(console, console->strips[row]);
+    }
+    map_lines(console);
+    console->column = 0;
+    console->newline_pending = false;
+}
+
+// Move every text row up by one, reusing the top strip as the new, empty bottom row
+static void scroll(console_t* console)
+{
+    uint16_t* top = console->strips[0];
+    memmove(&console->strips[0], &console->strips[1], (console->rows - 1) * sizeof(console->strips[0]));
+    console->strips[console->rows - 1] = top;
+    clear_strip(console, top);
+    map_lines(console);
+    console->column = 0;
+    ++console->scrolls;
+}
+
+void console_putc(console_t* console, char c)
+{
+    if (c == '\n')
+    {
+        console->newline_pending = true;
+        return;
+    }
+    if (c == '\r')
+        return;
+    if (c == '\t')
+        c = ' ';
+
+    const console_font_t* font = console->font;
+    const int index = (unsigned char)c - font->first_char;
+    if (index < 0 || index >= font->glyph_count)
+        return;
+
+    if (console->newline_pending || console->column == console->columns)
+    {
+        scroll(console);
+        console->newline_pending = false;
+    }
+
+    const uint8_t* glyph = &font->glyphs[index * font->height * font->stride];
+    render_glyph(console->strips[console->rows - 1], glyph, font->stride, font->width, font->height,
+                 console->column * font->width, 0, console->fg, console->bg);
+    ++console->column;
+    ++console->chars;
+}
+
+void console_write(console_t* console, const char* text, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        console_putc(console, text[i]);
+    }
+}
+
+#if PICO_ON_DEVICE
+static console_t* stdio_console;
+
+static void console_out_chars(const char* buf, int length)
+{
+    console_write(stdio_console, buf, length);
+}
+
+static stdio_driver_t console_stdio = {.out_chars = console_out_chars};
+
+// Show everything printed from now on. Output only, input stays with the UART.
+void console_attach_stdio(console_t* console)
+{
+    stdio_console = console;
+    stdio_set_driver_enabled(&console_stdio, true);
+}
+#endif
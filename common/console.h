@@ -0,0 +1,87 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// On-screen log console.
+//
+// The last lines written are drawn into a few text rows at the bottom of the screen. Each text
+// row is a strip of FRAME_WIDTH x font height pixels, and the screen lines of the console point
+// into the strips through the scanline pointer table passed to scanout_push_lines(). A newline
+// moves every strip up one text row by rewriting those pointers and clears the one that comes
+// in at the bottom, so scrolling copies no pixels. Text is drawn one glyph per character as it
+// is written and nothing is redrawn per frame.
+//
+// console_attach_stdio() adds the console as a Pico SDK stdio driver, so everything printed
+// with printf() shows up on screen as well as on the UART.
+
+#ifndef CONSOLE_MAX_ROWS
+#define CONSOLE_MAX_ROWS 8
+#endif
+
+// A 1bpp font compiled by tools/assetc.py
+typedef struct
+{
+    const uint8_t* glyphs;
+    uint8_t width;
+    uint8_t height;
+    uint8_t stride; // Bytes per glyph row
+    uint8_t first_char;
+    uint16_t glyph_count;
+} console_font_t;
+
+// Font from the tables generated for <name>.h
+#define CONSOLE_FONT_ASSET(name, NAME)                                                                                 \
+    {&name##_glyphs[0][0], NAME##_WIDTH, NAME##_HEIGHT, NAME##_STRIDE, NAME##_FIRST_CHAR, NAME##_GLYPH_COUNT}
+
+typedef struct
+{
+    const console_font_t* font;
+    uint16_t* strips[CONSOLE_MAX_ROWS]; // Top text row first
+    const uint16_t** lines;             // Screen line pointers of the console, rows * font height
+    int rows;
+    int columns;
+    int column;           // Cursor in the bottom row
+    bool newline_pending; // Scroll before the next character, so the last line stays in view
+    uint16_t fg;
+    uint16_t bg;
+    uint32_t chars;   // Glyphs drawn
+    uint32_t scrolls; // Newlines and wrapped lines
+} console_t;
+
+// Function declarations
+void console_init(console_t* console, const console_font_t* font, uint16_t* pixels, const uint16_t** lines, int rows,
+                  uint16_t fg, uint16_t bg);
+void console_putc(console_t* console, char c);
+void console_write(console_t* console, const char* text, size_t length);
+void console_clear(console_t* console);
+void console_attach_stdio(console_t* console);
+
+#endif // CONSOLE_H
@@ -0,0 +1,112 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "copper.h"
+
+void copper_init(copper_t* copper, uint16_t width)
+{
+    memset(copper, 0, sizeof(*copper));
+    copper->width = width;
+}
+
+// Start a frame read from framebuffer, with no effects until the first command
+void copper_begin_frame(copper_t* copper, const uint16_t* framebuffer, uint16_t height,
+                        const copper_command_t* commands, uint32_t count)
+{
+    copper->commands = commands;
+    copper->count = count;
+    copper->next = 0;
+    copper->pixels = framebuffer;
+    copper->stride = copper->width;
+    copper->height = height;
+    copper->source_line = 0;
+    copper->scroll_x = 0;
+    copper->scroll_y = 0;
+    copper->from = 0;
+    copper->to = 0;
+}
+
+static void run_command(copper_t* copper, const copper_command_t* command)
+{
+    switch (command->op)
+    {
+    case COPPER_SOURCE:
+        copper->pixels = command->source.pixels;
+        copper->stride = command->source.stride;
+        copper->height = command->source.height;
+        copper->source_line = command->line;
+        break;
+    case COPPER_SCROLL:
+        copper->scroll_x = (command->scroll.x % copper->width + copper->width) % copper->width;
+        copper->scroll_y = command->scroll.y;
+        break;
+    case COPPER_PALETTE:
+        copper->from = command->palette.from;
+        copper->to = command->palette.to;
+        break;
+    }
+}
+
+// Run the commands for screen line y and find its source row. Returns true if the row can be
+// queued as it is (copper->row), false if it has to go through copper_build_line().
+bool copper_line(copper_t* copper, uint32_t y)
+{
+    while (copper->next < copper->count && copper->commands[copper->next].line <= y)
+    {
+        run_command(copper, &copper->commands[copper->next++]);
+    }
+
+    int32_t row = ((int32_t)(y - copper->source_line) + copper->scroll_y) % copper->height;
+    if (row < 0)
+        row += copper->height;
+    copper->row = &copper->pixels[row * copper->stride];
+
+    return copper->scroll_x == 0 && copper->from == copper->to;
+}
+
+// Copy count pixels, showing from as to
+static void copy_span(uint16_t* dst, const uint16_t* src, int count, uint16_t from, uint16_t to)
+{
+    if (from == to)
+    {
+        memcpy(dst, src, count * sizeof(uint16_t));
+        return;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        const uint16_t pixel = src[i];
+        dst[i] = pixel == from ? to : pixel;
+    }
+}
+
+// Build the current line into line, width pixels, scrolled and recoloured
+void copper_build_line(const copper_t* copper, uint16_t* line)
+{
+    const int first = copper->width - copper->scroll_x;
+    copy_span(line, copper->row + copper->scroll_x, first, copper->from, copper->to);
+    copy_span(line + first, copper->row, copper->scroll_x, copper->from, copper->to);
+}
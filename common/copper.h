@@ -0,0 +1,113 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef COPPER_H
+#define COPPER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-scanline raster effects from a command list, after the Amiga's copper.
+//
+// A list of commands, sorted by screen line, is followed as the lines of a frame are queued.
+// Each command changes the beam state from its line to the end of the frame or the next
+// command of the same kind:
+//
+// - COPPER_SOURCE: read the following lines from another buffer, such as a status bar kept
+//   apart from the framebuffer. The buffer's rows repeat after its height.
+// - COPPER_SCROLL: offset the source by (x, y) pixels, wrapping around its width and height.
+// - COPPER_PALETTE: show pixels of one colour as another, the RGB565 counterpart of changing
+//   a palette register. A gradient is one command per band. Setting from == to turns it off.
+//
+// Working out a line costs O(commands on that line). Lines without a horizontal scroll or a
+// colour change are queued straight from their source; the others are built in a scanout line
+// buffer with one pass over the pixels. Effects need no framebuffer memory of their own.
+// The list must not change while a frame is being pushed.
+
+typedef enum
+{
+    COPPER_SOURCE,
+    COPPER_SCROLL,
+    COPPER_PALETTE,
+} copper_op_t;
+
+typedef struct
+{
+    uint16_t line; // Screen line the command takes effect on
+    uint8_t op;    // copper_op_t
+    union
+    {
+        struct
+        {
+            const uint16_t* pixels; // Word aligned, rows of stride pixels
+            uint16_t stride;
+            uint16_t height;
+        } source;
+        struct
+        {
+            int16_t x;
+            int16_t y;
+        } scroll;
+        struct
+        {
+            uint16_t from;
+            uint16_t to;
+        } palette;
+    };
+} copper_command_t;
+
+#define COPPER_SOURCE_AT(y, pixels_, stride_, height_)                                                                \
+    {.line = (y), .op = COPPER_SOURCE, .source = {(pixels_), (stride_), (height_)}}
+#define COPPER_SCROLL_AT(y, x_, y_) {.line = (y), .op = COPPER_SCROLL, .scroll = {(x_), (y_)}}
+#define COPPER_PALETTE_AT(y, from_, to_) {.line = (y), .op = COPPER_PALETTE, .palette = {(from_), (to_)}}
+
+// Beam state while a frame is pushed
+typedef struct
+{
+    const copper_command_t* commands;
+    uint32_t count;
+    uint32_t next; // First command not yet run
+    uint16_t width;
+
+    const uint16_t* pixels; // Current source, and the screen line it starts on
+    uint16_t stride;
+    uint16_t height;
+    uint16_t source_line;
+    int16_t scroll_x; // Kept within 0 .. width - 1
+    int16_t scroll_y;
+    uint16_t from;
+    uint16_t to;
+
+    const uint16_t* row; // Source row of the current line
+} copper_t;
+
+// Function declarations
+void copper_init(copper_t* copper, uint16_t width);
+void copper_begin_frame(copper_t* copper, const uint16_t* framebuffer, uint16_t height,
+                        const copper_command_t* commands, uint32_t count);
+bool copper_line(copper_t* copper, uint32_t y);
+void copper_build_line(const copper_t* copper, uint16_t* line);
+
+#endif // COPPER_H
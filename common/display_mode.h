@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef DISPLAY_MODE_H
+#define DISPLAY_MODE_H
+
+#include <stdint.h>
+
+// Display modes, selected at build time with the DISPLAY_MODE CMake cache variable.
+// All modes use the same 640x480p60 DVI timing; the logical frame is stretched to fit by
+// pixel repetition. libdvi repeats each pixel DVI_SYMBOLS_PER_WORD times horizontally and
+// each line DVI_VERTICAL_REPEAT times vertically, and scanout applies FRAME_H_REPEAT and
+// FRAME_V_REPEAT on top of that in software.
+#define DISPLAY_MODE_160x120 0
+#define DISPLAY_MODE_320x240 1
+#define DISPLAY_MODE_640x480 2
+
+#ifndef DISPLAY_MODE
+#define DISPLAY_MODE DISPLAY_MODE_320x240
+#endif
+
+#if DISPLAY_MODE == DISPLAY_MODE_160x120
+#define FRAME_WIDTH    160
+#define FRAME_HEIGHT   120
+#define FRAME_H_REPEAT 2
+#define FRAME_V_REPEAT 2
+#elif DISPLAY_MODE == DISPLAY_MODE_320x240
+#define FRAME_WIDTH    320
+#define FRAME_HEIGHT   240
+#define FRAME_H_REPEAT 1
+#define FRAME_V_REPEAT 1
+#elif DISPLAY_MODE == DISPLAY_MODE_640x480
+// Native resolution, libdvi must be built with DVI_SYMBOLS_PER_WORD=1 and DVI_VERTICAL_REPEAT=1.
+// A full RGB565 framebuffer does not fit in SRAM at this size.
+#define FRAME_WIDTH    640
+#define FRAME_HEIGHT   480
+#define FRAME_H_REPEAT 1
+#define FRAME_V_REPEAT 1
+#else
+#error "Unknown DISPLAY_MODE"
+#endif
+
+// Size of a line as handed to libdvi, and the number of lines per frame
+#define SCANLINE_WIDTH  (FRAME_WIDTH * FRAME_H_REPEAT)
+#define SCANLINE_HEIGHT (FRAME_HEIGHT * FRAME_V_REPEAT)
+
+// Display mode descriptor
+typedef struct
+{
+    const char* name;
+    uint16_t frame_width;  // Logical framebuffer width in pixels
+    uint16_t frame_height; // Logical framebuffer height in pixels
+    uint8_t h_repeat;      // Software horizontal pixel repeat
+    uint8_t v_repeat;      // Software vertical line repeat
+} display_mode_t;
+
+// Descriptor of the mode this firmware was built for
+extern const display_mode_t display_mode;
+
+// Size of a full RGB565 framebuffer in the current mode, in bytes
+static inline uint32_t display_mode_framebuffer_bytes(const display_mode_t* mode)
+{
+    return (uint32_t)mode->frame_width * mode->frame_height * sizeof(uint16_t);
+}
+
+#endif // DISPLAY_MODE_H
@@ -0,0 +1,694 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "fat_writer.h"
+
+#define ENTRIES_PER_FAT_SECTOR (FAT_WRITER_SECTOR_SIZE / 4)
+#define ENTRIES_PER_DIR_SECTOR (FAT_WRITER_SECTOR_SIZE / 32)
+#define FAT_ENTRY_MASK         0x0fffffffu
+#define FAT_END_OF_CHAIN       0x0ffffff8u
+#define NO_SECTOR              0xffffffffu
+
+#define FSINFO_LEAD_SIGNATURE   0x41615252u
+#define FSINFO_STRUCT_SIGNATURE 0x61417272u
+
+// No clock: files are stamped 2024-01-01 00:00
+#define FILE_DATE (((2024 - 1980) << 9) | (1 << 5) | 1)
+
+enum
+{
+    STEP_NONE = 0,
+    STEP_MBR,    // Sector 0 read, a FAT32 boot sector or a partition table
+    STEP_BOOT,   // Partition boot sector read
+    STEP_FSINFO, // FSInfo sector read
+    STEP_DIR_READ,
+    STEP_DIR_SCAN,
+    STEP_DIR_NEXT, // FAT sector with the next root directory cluster read
+    STEP_DATA,
+    STEP_ALLOC,
+    STEP_FLUSH, // Writing a FAT sector to each copy of the FAT
+    STEP_CLOSE,
+    STEP_CLOSE_DIR_READ,
+    STEP_CLOSE_DIR,
+    STEP_CLOSE_FSINFO_READ,
+    STEP_CLOSE_FSINFO,
+    STEP_CLOSE_DONE
+};
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value & 0xff;
+    p[1] = value >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t value)
+{
+    put_u16(p, value & 0xffff);
+    put_u16(p + 2, value >> 16);
+}
+
+// Errors that leave the volume unusable until it is mounted again
+static void fail(fat_writer_t* writer, const char* error)
+{
+    writer->error = error;
+    writer->state = FAT_WRITER_ERROR;
+    writer->step = STEP_NONE;
+}
+
+// Errors that only affect the file being opened or written
+static void fail_file(fat_writer_t* writer, const char* error)
+{
+    writer->error = error;
+    writer->state = FAT_WRITER_READY;
+    writer->step = STEP_NONE;
+    writer->data_sectors = 0;
+    writer->data_in_flight = 0;
+}
+
+static void read_sector(fat_writer_t* writer, uint32_t lba, uint8_t* buffer, uint8_t next)
+{
+    writer->step = next;
+    if (!writer->dev->read(writer->dev, lba, buffer, 1))
+    {
+        fail(writer, "read failed");
+        return;
+    }
+    writer->pending = true;
+    ++writer->commands;
+}
+
+static void write_sectors(fat_writer_t* writer, uint32_t lba, const uint8_t* buffer, uint32_t count, uint8_t next)
+{
+    writer->step = next;
+    if (!writer->dev->write(writer->dev, lba, buffer, count))
+    {
+        fail(writer, "write failed");
+        return;
+    }
+    writer->pending = true;
+    ++writer->commands;
+}
+
+static uint32_t cluster_lba(const fat_writer_t* writer, uint32_t cluster)
+{
+    return writer->data_start + (cluster - 2) * writer->sectors_per_cluster;
+}
+
+// Write one cached FAT sector to every copy of the FAT, then continue with next
+static void flush(fat_writer_t* writer, uint8_t buffer, uint8_t next)
+{
+    writer->flush_buffer = buffer;
+    writer->flush_copy = 0;
+    writer->after_flush = next;
+    writer->step = STEP_FLUSH;
+}
+
+static bool is_fat32_boot_sector(const uint8_t* s)
+{
+    const uint8_t per_cluster = s[13];
+    return (s[0] == 0xeb || s[0] == 0xe9) && s[510] == 0x55 && s[511] == 0xaa &&
+           get_u16(s + 11) == FAT_WRITER_SECTOR_SIZE && per_cluster != 0 && (per_cluster & (per_cluster - 1)) == 0 &&
+           s[16] != 0 && get_u16(s + 17) == 0 && get_u16(s + 22) == 0 && get_u32(s + 36) != 0;
+}
+
+static void parse_boot_sector(fat_writer_t* writer, uint32_t start)
+{
+    const uint8_t* s = writer->sector;
+    const uint32_t reserved = get_u16(s + 14);
+    const uint32_t total = get_u16(s + 19) ? get_u16(s + 19) : get_u32(s + 32);
+
+    writer->volume_start = start;
+    writer->sectors_per_cluster = s[13];
+    writer->num_fats = s[16];
+    writer->fat_sectors = get_u32(s + 36);
+    writer->root_cluster = get_u32(s + 44);
+    writer->fsinfo_sector = get_u16(s + 48);
+    writer->fat_start = start + reserved;
+    writer->data_start = writer->fat_start + writer->num_fats * writer->fat_sectors;
+
+    const uint32_t used = writer->data_start - start;
+    if (total <= used)
+    {
+        fail(writer, "bad boot sector");
+        return;
+    }
+    writer->max_cluster = (total - used) / writer->sectors_per_cluster + 1;
+    if (writer->max_cluster > writer->fat_sectors * ENTRIES_PER_FAT_SECTOR - 1)
+    {
+        writer->max_cluster = writer->fat_sectors * ENTRIES_PER_FAT_SECTOR - 1;
+    }
+    writer->next_free = 2;
+
+    if (writer->fsinfo_sector != 0 && writer->fsinfo_sector < reserved)
+    {
+        read_sector(writer, start + writer->fsinfo_sector, writer->sector, STEP_FSINFO);
+    }
+    else
+    {
+        writer->fsinfo_sector = 0;
+        writer->state = FAT_WRITER_READY;
+        writer->step = STEP_NONE;
+    }
+}
+
+static bool fsinfo_valid(const uint8_t* s)
+{
+    return get_u32(s) == FSINFO_LEAD_SIGNATURE && get_u32(s + 484) == FSINFO_STRUCT_SIGNATURE;
+}
+
+// Return the FAT buffer holding a FAT sector, or -1
+static int fat_buffer_for(const fat_writer_t* writer, uint32_t sector)
+{
+    if (writer->fat_buffer_sector[writer->tail_buffer] == sector)
+        return writer->tail_buffer;
+    if (writer->fat_buffer_sector[writer->tail_buffer ^ 1] == sector)
+        return writer->tail_buffer ^ 1;
+    return -1;
+}
+
+// Load a FAT sector into the buffer that is not holding unwritten changes and repeat the step.
+// Returns the buffer if the sector is already cached.
+static int load_fat_sector(fat_writer_t* writer, uint32_t sector)
+{
+    const int cached = fat_buffer_for(writer, sector);
+    if (cached >= 0)
+        return cached;
+
+    const uint8_t buffer = writer->tail_buffer ^ 1;
+    writer->fat_buffer_sector[buffer] = sector;
+    read_sector(writer, writer->fat_start + sector, writer->fat_buffer[buffer], writer->step);
+    return -1;
+}
+
+static void scan_directory_sector(fat_writer_t* writer)
+{
+    for (uint8_t i = 0; i < ENTRIES_PER_DIR_SECTOR; ++i)
+    {
+        const uint8_t* entry = writer->sector + 32 * i;
+        const bool end = entry[0] == 0x00;
+
+        if ((end || entry[0] == 0xe5) && !writer->entry_found)
+        {
+            writer->entry_sector = cluster_lba(writer, writer->dir_cluster) + writer->dir_sector;
+            writer->entry_index = i;
+            writer->entry_found = true;
+        }
+        if (end)
+        {
+            writer->dir_cluster = 0;
+            return;
+        }
+        if (entry[0] == 0xe5 || entry[11] == 0x0f)
+            continue; // Deleted or part of a long name
+
+        // PREFnnnn.EXT: remember the highest number in use
+        if (memcmp(entry, writer->name, 4) == 0 && memcmp(entry + 8, writer->name + 8, 3) == 0)
+        {
+            uint32_t number = 0;
+            int digit = 4;
+            for (; digit < 8 && entry[digit] >= '0' && entry[digit] <= '9'; ++digit)
+            {
+                number = number * 10 + (entry[digit] - '0');
+            }
+            if (digit == 8 && number > writer->number)
+                writer->number = number;
+        }
+    }
+}
+
+static void finish_open(fat_writer_t* writer)
+{
+    if (!writer->entry_found)
+    {
+        fail_file(writer, "root directory full");
+        return;
+    }
+    if (writer->number >= 9999)
+    {
+        fail_file(writer, "out of file numbers");
+        return;
+    }
+
+    uint32_t number = writer->number + 1;
+    for (int digit = 7; digit >= 4; --digit)
+    {
+        writer->name[digit] = '0' + number % 10;
+        number /= 10;
+    }
+
+    writer->first_cluster = 0;
+    writer->cluster = 0;
+    writer->run_sectors = 0; // The first write allocates a cluster
+    writer->next_run_lba = 0;
+    writer->size = 0;
+    writer->search_start = writer->next_free;
+    writer->search_wrapped = false;
+    writer->state = FAT_WRITER_OPEN;
+    writer->step = STEP_NONE;
+}
+
+// Find a free cluster from the hint onwards and chain it to the end of the file
+static void allocate_cluster(fat_writer_t* writer)
+{
+    uint32_t cluster = writer->next_free;
+    if (cluster > writer->max_cluster)
+    {
+        cluster = 2;
+        writer->search_wrapped = true;
+    }
+    if (writer->search_wrapped && cluster >= writer->search_start)
+    {
+        fail_file(writer, "disk full");
+        return;
+    }
+    writer->next_free = cluster;
+
+    const uint32_t sector = cluster / ENTRIES_PER_FAT_SECTOR;
+    const int buffer = load_fat_sector(writer, sector);
+    if (buffer < 0)
+        return;
+
+    uint8_t* fat = writer->fat_buffer[buffer];
+    for (uint32_t i = cluster % ENTRIES_PER_FAT_SECTOR; i < ENTRIES_PER_FAT_SECTOR; ++i, ++cluster)
+    {
+        if (cluster > writer->max_cluster)
+            break;
+
+        const uint32_t entry = get_u32(fat + 4 * i);
+        if ((entry & FAT_ENTRY_MASK) != 0)
+            continue;
+
+        put_u32(fat + 4 * i, (entry & ~FAT_ENTRY_MASK) | FAT_ENTRY_MASK);
+        writer->next_free = cluster + 1;
+
+        uint8_t next = STEP_DATA;
+        if (writer->first_cluster == 0)
+        {
+            writer->first_cluster = cluster;
+        }
+        else
+        {
+            // The previous last cluster is in the tail buffer
+            uint8_t* link = writer->fat_buffer[writer->tail_buffer] + 4 * (writer->cluster % ENTRIES_PER_FAT_SECTOR);
+            put_u32(link, (get_u32(link) & ~FAT_ENTRY_MASK) | cluster);
+            if (buffer != writer->tail_buffer)
+            {
+                // The file moved on to the next FAT sector, the previous one is complete
+                flush(writer, writer->tail_buffer, STEP_DATA);
+                next = STEP_FLUSH;
+            }
+        }
+
+        // Extend the run of sectors to write when the cluster follows on
+        const uint32_t lba = cluster_lba(writer, cluster);
+        if (writer->run_sectors == 0)
+        {
+            writer->run_lba = lba;
+            writer->run_sectors = writer->sectors_per_cluster;
+        }
+        else if (lba == writer->run_lba + writer->run_sectors)
+        {
+            writer->run_sectors += writer->sectors_per_cluster;
+        }
+        else
+        {
+            writer->next_run_lba = lba;
+        }
+
+        writer->tail_buffer = buffer;
+        writer->tail_dirty = true;
+        writer->cluster = cluster;
+        writer->step = next;
+        return;
+    }
+
+    // Nothing free in this FAT sector, carry on with the next
+    writer->next_free = (sector + 1) * ENTRIES_PER_FAT_SECTOR;
+}
+
+static void write_data(fat_writer_t* writer)
+{
+    // Account for the write that just completed
+    writer->data += writer->data_in_flight * FAT_WRITER_SECTOR_SIZE;
+    writer->data_sectors -= writer->data_in_flight;
+    writer->run_lba += writer->data_in_flight;
+    writer->run_sectors -= writer->data_in_flight;
+    writer->data_in_flight = 0;
+
+    if (writer->data_sectors == 0)
+    {
+        writer->step = writer->close_requested ? STEP_CLOSE : STEP_NONE;
+        return;
+    }
+    if (writer->run_sectors == 0 && writer->next_run_lba != 0)
+    {
+        writer->run_lba = writer->next_run_lba;
+        writer->run_sectors = writer->sectors_per_cluster;
+        writer->next_run_lba = 0;
+    }
+
+    // Allocate ahead so the whole append goes out as one command while the clusters follow on.
+    // Only a cluster that does not follow on splits it.
+    if (writer->run_sectors < writer->data_sectors && writer->next_run_lba == 0)
+    {
+        writer->step = STEP_ALLOC;
+        return;
+    }
+
+    uint32_t count = writer->run_sectors;
+    if (count > writer->data_sectors)
+        count = writer->data_sectors;
+
+    writer->data_in_flight = count;
+    writer->sectors_written += count;
+    write_sectors(writer, writer->run_lba, writer->data, count, STEP_DATA);
+}
+
+static void write_directory_entry(fat_writer_t* writer)
+{
+    uint8_t* entry = writer->sector + 32 * writer->entry_index;
+    memset(entry, 0, 32);
+    memcpy(entry, writer->name, 11);
+    entry[11] = 0x20; // Archive
+    put_u16(entry + 16, FILE_DATE);
+    put_u16(entry + 18, FILE_DATE);
+    put_u16(entry + 20, writer->first_cluster >> 16);
+    put_u16(entry + 24, FILE_DATE);
+    put_u16(entry + 26, writer->first_cluster & 0xffff);
+    put_u32(entry + 28, writer->size);
+    write_sectors(writer, writer->entry_sector, writer->sector, 1, STEP_CLOSE_FSINFO_READ);
+}
+
+static void step(fat_writer_t* writer)
+{
+    switch (writer->step)
+    {
+    case STEP_MBR:
+        if (is_fat32_boot_sector(writer->sector))
+        {
+            parse_boot_sector(writer, 0);
+            return;
+        }
+        if (writer->sector[510] == 0x55 && writer->sector[511] == 0xaa)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                const uint8_t* partition = writer->sector + 446 + 16 * i;
+                if (partition[4] == 0x0b || partition[4] == 0x0c)
+                {
+                    writer->volume_start = get_u32(partition + 8);
+                    read_sector(writer, writer->volume_start, writer->sector, STEP_BOOT);
+                    return;
+                }
+            }
+        }
+        fail(writer, "no FAT32 volume");
+        break;
+
+    case STEP_BOOT:
+        if (!is_fat32_boot_sector(writer->sector))
+        {
+            fail(writer, "no FAT32 volume");
+            return;
+        }
+        parse_boot_sector(writer, writer->volume_start);
+        break;
+
+    case STEP_FSINFO:
+        if (fsinfo_valid(writer->sector))
+        {
+            const uint32_t hint = get_u32(writer->sector + 492);
+            if (hint >= 2 && hint <= writer->max_cluster)
+                writer->next_free = hint;
+        }
+        else
+        {
+            writer->fsinfo_sector = 0;
+        }
+        writer->state = FAT_WRITER_READY;
+        writer->step = STEP_NONE;
+        break;
+
+    case STEP_DIR_READ:
+        read_sector(writer, cluster_lba(writer, writer->dir_cluster) + writer->dir_sector, writer->sector,
+                    STEP_DIR_SCAN);
+        break;
+
+    case STEP_DIR_SCAN:
+        scan_directory_sector(writer);
+        if (writer->dir_cluster == 0)
+        {
+            finish_open(writer);
+        }
+        else if (++writer->dir_sector < writer->sectors_per_cluster)
+        {
+            writer->step = STEP_DIR_READ;
+        }
+        else
+        {
+            writer->step = STEP_DIR_NEXT;
+        }
+        break;
+
+    case STEP_DIR_NEXT:
+    {
+        const int buffer = load_fat_sector(writer, writer->dir_cluster / ENTRIES_PER_FAT_SECTOR);
+        if (buffer < 0)
+            return;
+
+        const uint8_t* fat = writer->fat_buffer[buffer];
+        const uint32_t next = get_u32(fat + 4 * (writer->dir_cluster % ENTRIES_PER_FAT_SECTOR)) & FAT_ENTRY_MASK;
+        if (next < 2 || next >= FAT_END_OF_CHAIN || next > writer->max_cluster)
+        {
+            finish_open(writer);
+            return;
+        }
+        writer->dir_cluster = next;
+        writer->dir_sector = 0;
+        writer->step = STEP_DIR_READ;
+        break;
+    }
+
+    case STEP_DATA:
+        write_data(writer);
+        break;
+
+    case STEP_ALLOC:
+        allocate_cluster(writer);
+        break;
+
+    case STEP_FLUSH:
+        if (writer->flush_copy == writer->num_fats)
+        {
+            writer->step = writer->after_flush;
+            return;
+        }
+        write_sectors(writer,
+                      writer->fat_start + writer->flush_copy * writer->fat_sectors +
+                          writer->fat_buffer_sector[writer->flush_buffer],
+                      writer->fat_buffer[writer->flush_buffer], 1, STEP_FLUSH);
+        ++writer->flush_copy;
+        break;
+
+    case STEP_CLOSE:
+        if (writer->tail_dirty)
+        {
+            writer->tail_dirty = false;
+            flush(writer, writer->tail_buffer, STEP_CLOSE_DIR_READ);
+            return;
+        }
+        writer->step = STEP_CLOSE_DIR_READ;
+        break;
+
+    case STEP_CLOSE_DIR_READ:
+        read_sector(writer, writer->entry_sector, writer->sector, STEP_CLOSE_DIR);
+        break;
+
+    case STEP_CLOSE_DIR:
+        write_directory_entry(writer);
+        break;
+
+    case STEP_CLOSE_FSINFO_READ:
+        if (writer->fsinfo_sector == 0)
+        {
+            writer->step = STEP_CLOSE_DONE;
+            return;
+        }
+        read_sector(writer, writer->volume_start + writer->fsinfo_sector, writer->sector, STEP_CLOSE_FSINFO);
+        break;
+
+    case STEP_CLOSE_FSINFO:
+        if (!fsinfo_valid(writer->sector))
+        {
+            writer->step = STEP_CLOSE_DONE;
+            return;
+        }
+        // Let the host recount free clusters, but keep the hint
+        put_u32(writer->sector + 488, 0xffffffffu);
+        put_u32(writer->sector + 492, writer->next_free);
+        write_sectors(writer, writer->volume_start + writer->fsinfo_sector, writer->sector, 1, STEP_CLOSE_DONE);
+        break;
+
+    case STEP_CLOSE_DONE:
+        writer->state = FAT_WRITER_READY;
+        writer->step = STEP_NONE;
+        break;
+
+    default:
+        writer->step = STEP_NONE;
+        break;
+    }
+}
+
+void fat_writer_mount(fat_writer_t* writer, block_dev_t* dev)
+{
+    writer->dev = dev;
+    writer->state = FAT_WRITER_MOUNTING;
+    writer->error = NULL;
+    writer->pending = false;
+    writer->fat_buffer_sector[0] = NO_SECTOR;
+    writer->fat_buffer_sector[1] = NO_SECTOR;
+    writer->tail_buffer = 0;
+    writer->tail_dirty = false;
+    writer->data_sectors = 0;
+    writer->data_in_flight = 0;
+    writer->close_requested = false;
+    writer->sectors_written = 0;
+    writer->commands = 0;
+    read_sector(writer, 0, writer->sector, STEP_MBR);
+}
+
+// Forget the volume, for when the device has gone. An open file is lost.
+void fat_writer_unmount(fat_writer_t* writer)
+{
+    writer->state = FAT_WRITER_UNMOUNTED;
+    writer->step = STEP_NONE;
+    writer->pending = false;
+    writer->data_sectors = 0;
+    writer->data_in_flight = 0;
+    writer->dev = NULL;
+}
+
+// Start creating the next PREFnnnn.EXT file, prefix and extension in upper case. The file is
+// open once the state is FAT_WRITER_OPEN; back at FAT_WRITER_READY means it failed.
+bool fat_writer_open(fat_writer_t* writer, const char* prefix, const char* extension)
+{
+    if (writer->state != FAT_WRITER_READY || strlen(prefix) != 4 || strlen(extension) != 3)
+        return false;
+
+    memcpy(writer->name, prefix, 4);
+    memset(writer->name + 4, '0', 4);
+    memcpy(writer->name + 8, extension, 3);
+    writer->error = NULL;
+    writer->number = 0;
+    writer->entry_found = false;
+    writer->dir_cluster = writer->root_cluster;
+    writer->dir_sector = 0;
+    writer->close_requested = false;
+    writer->state = FAT_WRITER_OPENING;
+    writer->step = STEP_DIR_READ;
+    return true;
+}
+
+// Append data to the open file. The buffer must stay untouched until fat_writer_busy() is false.
+// Every append but the last before closing must be a whole number of sectors.
+bool fat_writer_append(fat_writer_t* writer, const void* data, uint32_t bytes)
+{
+    if (writer->state != FAT_WRITER_OPEN || writer->data_sectors > 0 || writer->size % FAT_WRITER_SECTOR_SIZE != 0)
+        return false;
+    if (bytes == 0)
+        return true;
+
+    writer->data = data;
+    writer->data_sectors = (bytes + FAT_WRITER_SECTOR_SIZE - 1) / FAT_WRITER_SECTOR_SIZE;
+    writer->data_in_flight = 0;
+    writer->size += bytes;
+    writer->step = STEP_DATA;
+    return true;
+}
+
+// Finish writing, then update the FAT, the directory entry and FSInfo. The file is complete
+// once the state is back at FAT_WRITER_READY.
+bool fat_writer_close(fat_writer_t* writer)
+{
+    if (writer->state != FAT_WRITER_OPEN)
+        return false;
+
+    writer->close_requested = true;
+    writer->state = FAT_WRITER_CLOSING;
+    if (writer->step == STEP_NONE)
+        writer->step = STEP_CLOSE;
+    return true;
+}
+
+// Advance the state machine. Call often: each call completes at most FAT_WRITER_STEPS_PER_POLL
+// steps and returns as soon as a command is still in progress.
+void fat_writer_poll(fat_writer_t* writer)
+{
+    for (int i = 0; i < FAT_WRITER_STEPS_PER_POLL; ++i)
+    {
+        if (writer->dev == NULL)
+            return;
+
+        if (writer->pending)
+        {
+            const block_dev_status_t status = writer->dev->status(writer->dev);
+            if (status == BLOCK_DEV_BUSY)
+                return;
+
+            writer->pending = false;
+            if (status == BLOCK_DEV_ERROR)
+            {
+                fail(writer, "I/O error");
+                return;
+            }
+        }
+
+        if (writer->step == STEP_NONE)
+            return;
+        step(writer);
+    }
+}
+
+// Name of the file being written or last written, as PREFnnnn.EXT
+void fat_writer_file_name(const fat_writer_t* writer, char* out)
+{
+    memcpy(out, writer->name, 8);
+    out[8] = '.';
+    memcpy(out + 9, writer->name + 8, 3);
+    out[12] = '\0';
+}
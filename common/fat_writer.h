@@ -0,0 +1,149 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef FAT_WRITER_H
+#define FAT_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block_dev.h"
+
+// Append-only file writer for FAT32 volumes.
+//
+// Creates numbered files (PREFnnnn.EXT) in the root directory of a FAT32 volume, either a whole
+// disk or the first FAT32 partition, and appends data to the one open file. Everything runs as a
+// state machine driven by fat_writer_poll(), which issues at most one block device command per
+// step and never waits for one, so writing can be spread over the main loop without holding up
+// the scanline feed. Clusters are taken from the free cluster hint in FSInfo onwards; the FAT is
+// updated one sector at a time as the file grows, and the directory entry and FSInfo when it is
+// closed. There is no long file name support and the root directory is not extended.
+
+#define FAT_WRITER_SECTOR_SIZE BLOCK_DEV_BLOCK_SIZE
+
+// Block device commands completed per call to fat_writer_poll() when the device is fast enough
+#ifndef FAT_WRITER_STEPS_PER_POLL
+#define FAT_WRITER_STEPS_PER_POLL 4
+#endif
+
+typedef enum
+{
+    FAT_WRITER_UNMOUNTED = 0,
+    FAT_WRITER_MOUNTING,
+    FAT_WRITER_READY,   // Mounted, no file open
+    FAT_WRITER_OPENING, // Scanning the root directory for a free entry and the next file number
+    FAT_WRITER_OPEN,
+    FAT_WRITER_CLOSING,
+    FAT_WRITER_ERROR
+} fat_writer_state_t;
+
+typedef struct
+{
+    block_dev_t* dev;
+    fat_writer_state_t state;
+    const char* error; // Reason for FAT_WRITER_ERROR
+
+    // Current step of the state machine and the one to continue with after a FAT flush
+    uint8_t step;
+    uint8_t after_flush;
+    uint8_t flush_buffer;
+    uint8_t flush_copy;
+    bool pending; // A block device command is outstanding
+
+    // Volume layout
+    uint32_t volume_start;
+    uint32_t fat_start;
+    uint32_t fat_sectors;
+    uint32_t data_start;
+    uint32_t max_cluster;
+    uint32_t root_cluster;
+    uint32_t fsinfo_sector;
+    uint8_t num_fats;
+    uint8_t sectors_per_cluster;
+
+    // Free cluster search
+    uint32_t next_free;
+    uint32_t search_start;
+    bool search_wrapped;
+
+    // Two cached FAT sectors: the one holding the file's last cluster, which may be dirty, and
+    // the one being searched for the next free cluster
+    uint8_t fat_buffer[2][FAT_WRITER_SECTOR_SIZE];
+    uint32_t fat_buffer_sector[2];
+    uint8_t tail_buffer;
+    bool tail_dirty;
+
+    // Directory and boot sector reads
+    uint8_t sector[FAT_WRITER_SECTOR_SIZE];
+
+    // Root directory scan while opening
+    char name[11];
+    uint32_t dir_cluster;
+    uint8_t dir_sector;
+    uint32_t entry_sector; // Sector and index of the free directory entry found for the file
+    uint8_t entry_index;
+    bool entry_found;
+    uint32_t number;
+
+    // Open file
+    uint32_t first_cluster;
+    uint32_t cluster; // Last cluster allocated to the file
+    uint32_t run_lba; // Allocated sectors not written yet, contiguous from run_lba
+    uint32_t run_sectors;
+    uint32_t next_run_lba; // Start of an allocated cluster that does not follow the run, 0 if none
+    uint32_t size;
+
+    // Data submitted with fat_writer_append() and not written yet
+    const uint8_t* data;
+    uint32_t data_sectors;
+    uint32_t data_in_flight; // Sectors of data in the outstanding write
+    bool close_requested;
+
+    // Statistics
+    uint32_t sectors_written;
+    uint32_t commands;
+} fat_writer_t;
+
+// Function declarations
+void fat_writer_mount(fat_writer_t* writer, block_dev_t* dev);
+void fat_writer_unmount(fat_writer_t* writer);
+bool fat_writer_open(fat_writer_t* writer, const char* prefix, const char* extension);
+bool fat_writer_append(fat_writer_t* writer, const void* data, uint32_t bytes);
+bool fat_writer_close(fat_writer_t* writer);
+void fat_writer_poll(fat_writer_t* writer);
+void fat_writer_file_name(const fat_writer_t* writer, char* out);
+
+static inline bool fat_writer_ready(const fat_writer_t* writer)
+{
+    return writer->state == FAT_WRITER_READY;
+}
+
+// True while data passed to fat_writer_append() is still being written
+static inline bool fat_writer_busy(const fat_writer_t* writer)
+{
+    return writer->data_sectors > 0 || writer->state == FAT_WRITER_OPENING || writer->state == FAT_WRITER_CLOSING;
+}
+
+#endif // FAT_WRITER_H
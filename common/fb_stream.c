@@ -0,0 +1,203 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "fb_stream.h"
+
+void fb_stream_init(fb_stream_t* stream, const uint16_t* framebuffer, uint16_t width, uint16_t height,
+                    uint32_t* tile_hashes)
+{
+    stream->framebuffer = framebuffer;
+    stream->width = width;
+    stream->height = height;
+    stream->tiles_x = width / FB_STREAM_TILE_SIZE;
+    stream->tiles_y = height / FB_STREAM_TILE_SIZE;
+    stream->tile_hashes = tile_hashes;
+    stream->frame = 0;
+    stream->next_tile = 0;
+    stream->tiles_sent = 0;
+    stream->keyframe = true;
+    stream->state = FB_STREAM_IDLE;
+}
+
+void fb_stream_begin_frame(fb_stream_t* stream, bool keyframe)
+{
+    // The first frame is always a keyframe, the host has nothing to apply deltas to
+    stream->keyframe = keyframe || stream->frame == 0;
+    stream->next_tile = 0;
+    stream->tiles_sent = 0;
+    stream->state = FB_STREAM_START;
+}
+
+uint8_t fb_stream_crc8(uint8_t crc, const uint8_t* data, size_t len)
+{
+    // CRC-8, polynomial 0x07
+    for (size_t i = 0; i < len; ++i)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t* put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value & 0xff;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t* put_u32(uint8_t* p, uint32_t value)
+{
+    p = put_u16(p, value & 0xffff);
+    return put_u16(p, value >> 16);
+}
+
+// Write the packet header, returning where the payload goes
+static uint8_t* begin_packet(uint8_t* out, fb_stream_packet_t type)
+{
+    out[0] = FB_STREAM_SYNC_0;
+    out[1] = FB_STREAM_SYNC_1;
+    out[2] = type;
+    return out + 5;
+}
+
+// Fill in the payload length and checksum, returning the packet size
+static size_t end_packet(uint8_t* out, const uint8_t* payload_end)
+{
+    const size_t payload_len = payload_end - (out + 5);
+    put_u16(&out[3], payload_len);
+    out[5 + payload_len] = fb_stream_crc8(0, &out[2], 3 + payload_len);
+    return 5 + payload_len + 1;
+}
+
+static uint32_t hash_tile(const fb_stream_t* stream, uint32_t tile)
+{
+    const uint32_t tx = tile % stream->tiles_x;
+    const uint32_t ty = tile / stream->tiles_x;
+    const uint16_t* src = &stream->framebuffer[ty * FB_STREAM_TILE_SIZE * stream->width + tx * FB_STREAM_TILE_SIZE];
+
+    // FNV-1a over pixel pairs
+    uint32_t hash = 2166136261u;
+    for (uint32_t y = 0; y < FB_STREAM_TILE_SIZE; ++y)
+    {
+        const uint32_t* row = (const uint32_t*)&src[y * stream->width];
+        for (uint32_t x = 0; x < FB_STREAM_TILE_SIZE / 2; ++x)
+        {
+            hash = (hash ^ row[x]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static size_t encode_tile(const fb_stream_t* stream, uint32_t tile, uint8_t* out)
+{
+    const uint32_t tx = tile % stream->tiles_x;
+    const uint32_t ty = tile / stream->tiles_x;
+    const uint16_t* src = &stream->framebuffer[ty * FB_STREAM_TILE_SIZE * stream->width + tx * FB_STREAM_TILE_SIZE];
+
+    uint8_t* p = begin_packet(out, FB_STREAM_PACKET_TILE);
+    p = put_u16(p, tile);
+
+    uint16_t run_color = src[0];
+    uint32_t run_length = 0;
+    for (uint32_t y = 0; y < FB_STREAM_TILE_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x < FB_STREAM_TILE_SIZE; ++x)
+        {
+            const uint16_t color = src[y * stream->width + x];
+            if (color != run_color || run_length == 256)
+            {
+                *p++ = run_length - 1;
+                p = put_u16(p, run_color);
+                run_color = color;
+                run_length = 0;
+            }
+            ++run_length;
+        }
+    }
+    *p++ = run_length - 1;
+    p = put_u16(p, run_color);
+
+    return end_packet(out, p);
+}
+
+size_t fb_stream_encode(fb_stream_t* stream, uint8_t* out, size_t size, uint32_t max_tiles)
+{
+    size_t used = 0;
+    const uint32_t tile_count = (uint32_t)stream->tiles_x * stream->tiles_y;
+
+    while (stream->state != FB_STREAM_IDLE && size - used >= FB_STREAM_MAX_PACKET)
+    {
+        uint8_t* packet = &out[used];
+        uint8_t* p;
+
+        switch (stream->state)
+        {
+        case FB_STREAM_START:
+            p = begin_packet(packet, FB_STREAM_PACKET_FRAME_START);
+            p = put_u32(p, stream->frame);
+            p = put_u16(p, stream->width);
+            p = put_u16(p, stream->height);
+            *p++ = stream->keyframe;
+            used += end_packet(packet, p);
+            stream->state = FB_STREAM_TILES;
+            break;
+
+        case FB_STREAM_TILES:
+            if (max_tiles == 0)
+                return used;
+            --max_tiles;
+
+            const uint32_t tile = stream->next_tile++;
+            const uint32_t hash = hash_tile(stream, tile);
+            if (stream->keyframe || hash != stream->tile_hashes[tile])
+            {
+                stream->tile_hashes[tile] = hash;
+                used += encode_tile(stream, tile, packet);
+                ++stream->tiles_sent;
+            }
+            if (stream->next_tile == tile_count)
+                stream->state = FB_STREAM_END;
+            break;
+
+        case FB_STREAM_END:
+            p = begin_packet(packet, FB_STREAM_PACKET_FRAME_END);
+            p = put_u32(p, stream->frame);
+            p = put_u16(p, stream->tiles_sent);
+            used += end_packet(packet, p);
+            ++stream->frame;
+            stream->state = FB_STREAM_IDLE;
+            break;
+
+        default:
+            stream->state = FB_STREAM_IDLE;
+            break;
+        }
+    }
+    return used;
+}
@@ -0,0 +1,100 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef FB_STREAM_H
+#define FB_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Framebuffer stream encoder.
+//
+// Frames are split into square tiles and a hash of every tile is kept from the previous
+// frame, so only tiles that changed are sent. Each changed tile is run-length encoded.
+// The first frame, and every keyframe after it, sends all tiles. Encoding is incremental:
+// each call examines a bounded number of tiles, so it can be spread over many main loop
+// iterations without holding up the scanline feed.
+//
+// Packet layout, multi-byte fields are little-endian:
+//   0xa5 0x5a, type, payload length (2 bytes), payload, CRC-8 of type, length and payload
+// Payloads:
+//   FRAME_START: frame number (4), width (2), height (2), keyframe flag (1)
+//   TILE:        tile index (2), runs of (count - 1 (1), RGB565 colour (2)) in row-major order
+//   FRAME_END:   frame number (4), number of tiles sent (2)
+
+#define FB_STREAM_TILE_SIZE 8
+#define FB_STREAM_SYNC_0    0xa5
+#define FB_STREAM_SYNC_1    0x5a
+
+// Largest packet: a tile whose every pixel differs from the previous one
+#define FB_STREAM_MAX_PACKET (5 + 2 + FB_STREAM_TILE_SIZE * FB_STREAM_TILE_SIZE * 3 + 1)
+
+typedef enum
+{
+    FB_STREAM_PACKET_FRAME_START = 1,
+    FB_STREAM_PACKET_TILE = 2,
+    FB_STREAM_PACKET_FRAME_END = 3
+} fb_stream_packet_t;
+
+typedef enum
+{
+    FB_STREAM_IDLE = 0,
+    FB_STREAM_START,
+    FB_STREAM_TILES,
+    FB_STREAM_END
+} fb_stream_state_t;
+
+typedef struct
+{
+    const uint16_t* framebuffer;
+    uint16_t width;
+    uint16_t height;
+    uint16_t tiles_x;
+    uint16_t tiles_y;
+    uint32_t* tile_hashes; // One entry per tile, provided by the caller
+    uint32_t frame;        // Number of the frame being encoded
+    uint32_t next_tile;    // Next tile to examine
+    uint16_t tiles_sent;   // Tiles sent in the current frame
+    bool keyframe;
+    fb_stream_state_t state;
+} fb_stream_t;
+
+// Number of tile hashes needed for a framebuffer of the given size
+#define FB_STREAM_TILE_COUNT(width, height) (((width) / FB_STREAM_TILE_SIZE) * ((height) / FB_STREAM_TILE_SIZE))
+
+// Function declarations
+void fb_stream_init(fb_stream_t* stream, const uint16_t* framebuffer, uint16_t width, uint16_t height,
+                    uint32_t* tile_hashes);
+void fb_stream_begin_frame(fb_stream_t* stream, bool keyframe);
+size_t fb_stream_encode(fb_stream_t* stream, uint8_t* out, size_t size, uint32_t max_tiles);
+uint8_t fb_stream_crc8(uint8_t crc, const uint8_t* data, size_t len);
+
+static inline bool fb_stream_busy(const fb_stream_t* stream)
+{
+    return stream->state != FB_STREAM_IDLE;
+}
+
+#endif // FB_STREAM_H
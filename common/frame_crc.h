@@ -0,0 +1,52 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef FRAME_CRC_H
+#define FRAME_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frame signatures: the CRC-32 of a frame's RGB565 pixels, row by row, low byte first. This is
+// the standard CRC-32 of the raw framebuffer (zlib.crc32() over its bytes on a little-endian
+// machine), so two renderers that draw the same pixels give the same signature. With
+// -DFRAME_CRC=ON scanout signs every frame as its lines are queued, see scanout_poll_crc().
+
+// Signature being built line by line
+typedef struct
+{
+    uint32_t crc;
+    uint32_t lines;
+} frame_crc_t;
+
+// Function declarations
+void frame_crc_init(void);
+uint32_t frame_crc_update(uint32_t crc, const uint16_t* pixels, size_t count);
+void frame_crc_begin(frame_crc_t* sig);
+void frame_crc_line(frame_crc_t* sig, const uint16_t* line, uint32_t width);
+uint32_t frame_crc_end(const frame_crc_t* sig);
+uint32_t frame_crc_frame(const uint16_t* framebuffer, uint32_t width, uint32_t height);
+
+#endif // FRAME_CRC_H
@@ -0,0 +1,108 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "frame_id.h"
+
+// CRC-8 with polynomial 0x07 over the frame number, least significant byte first
+uint8_t frame_id_checksum(uint32_t frame)
+{
+    uint8_t crc = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        crc ^= (uint8_t)(frame >> (8 * i));
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// The frame number, most significant bit first, followed by its checksum
+static inline int frame_id_bit(uint32_t frame, uint8_t checksum, int index)
+{
+    if (index < 32)
+        return (frame >> (31 - index)) & 1;
+    return (checksum >> (39 - index)) & 1;
+}
+
+// Encode the strip as one 1bpp row of width pixels, leftmost pixel in the most significant
+// bit and 1 for white. The width must be a multiple of 8 and of FRAME_ID_CELLS.
+void frame_id_encode(uint32_t frame, uint8_t* row, int width)
+{
+    const uint8_t checksum = frame_id_checksum(frame);
+    const int cell_width = width / FRAME_ID_CELLS;
+
+    memset(row, 0, width / 8);
+    for (int i = 0; i < FRAME_ID_BITS; ++i)
+    {
+        // The white cell comes first for a 1 and second for a 0
+        const int cell = 2 * i + (frame_id_bit(frame, checksum, i) ? 0 : 1);
+        for (int x = cell * cell_width; x < (cell + 1) * cell_width; ++x)
+        {
+            row[x >> 3] |= 0x80 >> (x & 7);
+        }
+    }
+}
+
+// Decode a row of 8-bit luma samples spanning the full frame width. Returns false unless
+// every cell pair is a valid Manchester symbol and the checksum matches.
+bool frame_id_decode(const uint8_t* luma, int width, uint32_t* frame)
+{
+    uint8_t cells[FRAME_ID_CELLS];
+    uint8_t lo = 255;
+    uint8_t hi = 0;
+
+    for (int i = 0; i < FRAME_ID_CELLS; ++i)
+    {
+        cells[i] = luma[(2 * i + 1) * width / (2 * FRAME_ID_CELLS)];
+        if (cells[i] < lo)
+            lo = cells[i];
+        if (cells[i] > hi)
+            hi = cells[i];
+    }
+    if (hi - lo < 64)
+        return false;
+
+    const int threshold = (lo + hi) / 2;
+    uint64_t bits = 0;
+    for (int i = 0; i < FRAME_ID_BITS; ++i)
+    {
+        const bool first = cells[2 * i] > threshold;
+        const bool second = cells[2 * i + 1] > threshold;
+        if (first == second)
+            return false;
+        bits = (bits << 1) | first;
+    }
+
+    const uint32_t value = (uint32_t)(bits >> 8);
+    if (frame_id_checksum(value) != (uint8_t)bits)
+        return false;
+
+    *frame = value;
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef FRAME_ID_H
+#define FRAME_ID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Machine-readable frame number.
+//
+// A 32-bit frame number and a CRC-8 of it are drawn as a strip of black and white cells
+// across the full width of the frame, once at the top and once at the bottom. Each of the
+// 40 bits is Manchester coded into two cells, white then black for a 1 and black then white
+// for a 0, so the strip carries its own threshold and clock and every cell pair can be
+// checked. Because the strip spans the whole width, a capture at any resolution can be
+// decoded by sampling the centre of each cell. A frame whose top and bottom strips differ
+// was torn.
+//
+// This file is shared by the firmware and the host analyser.
+
+#define FRAME_ID_BITS  40
+#define FRAME_ID_CELLS (2 * FRAME_ID_BITS)
+
+// Strip height in framebuffer lines
+#ifndef FRAME_ID_HEIGHT
+#define FRAME_ID_HEIGHT 4
+#endif
+
+// Function declarations
+uint8_t frame_id_checksum(uint32_t frame);
+void frame_id_encode(uint32_t frame, uint8_t* row, int width);
+bool frame_id_decode(const uint8_t* luma, int width, uint32_t* frame);
+
+#endif // FRAME_ID_H
@@ -0,0 +1,131 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "governor.h"
+
+static const char* const level_names[GOVERNOR_LEVELS] = {"normal", "defer logs", "spread repaints", "shed frames"};
+
+void governor_init(governor_t* governor, uint32_t budget_us)
+{
+    memset(governor, 0, sizeof(*governor));
+    governor->budget_us = budget_us;
+}
+
+// Account for the work done between two frames and return the level for the next one
+governor_level_t governor_frame(governor_t* governor, uint32_t work_us, uint32_t late_scanlines)
+{
+    ++governor->frames;
+    governor->total_us += work_us;
+    if (work_us > governor->max_us)
+        governor->max_us = work_us;
+    governor->late_scanlines += late_scanlines;
+
+    const bool over = work_us > governor->budget_us;
+    if (over)
+        ++governor->overruns;
+
+    if (over || late_scanlines)
+    {
+        governor->calm_frames = 0;
+        if (governor->level + 1 < GOVERNOR_LEVELS)
+            ++governor->entered[++governor->level];
+    }
+    else if (governor->level != GOVERNOR_NORMAL && ++governor->calm_frames == GOVERNOR_CALM_FRAMES)
+    {
+        governor->calm_frames = 0;
+        --governor->level;
+    }
+
+    ++governor->frames_at[governor->level];
+    return governor->level;
+}
+
+void governor_print(const governor_t* governor)
+{
+    if (governor->frames == 0)
+    {
+        printf("Governor: no frames\r\n");
+        return;
+    }
+
+    printf("Governor: %lu frames, mean %lu us, max %lu us, budget %lu us, %lu overruns, %lu late scanlines, "
+           "level %s\r\n",
+           (unsigned long)governor->frames, (unsigned long)(governor->total_us / governor->frames),
+           (unsigned long)governor->max_us, (unsigned long)governor->budget_us, (unsigned long)governor->overruns,
+           (unsigned long)governor->late_scanlines, level_names[governor->level]);
+    for (int level = 0; level < GOVERNOR_LEVELS; ++level)
+    {
+        printf("  %s: %lu frames", level_names[level], (unsigned long)governor->frames_at[level]);
+        if (level != GOVERNOR_NORMAL)
+            printf(", entered %lu times", (unsigned long)governor->entered[level]);
+        printf("\r\n");
+    }
+    printf("  log: %lu bytes waiting, %lu lines dropped\r\n",
+           (unsigned long)(governor->log_head - governor->log_tail), (unsigned long)governor->log_dropped);
+}
+
+// Start a new report period, the level and the log are kept
+void governor_reset_stats(governor_t* governor)
+{
+    governor->frames = 0;
+    governor->total_us = 0;
+    governor->max_us = 0;
+    governor->overruns = 0;
+    governor->late_scanlines = 0;
+    memset(governor->entered, 0, sizeof(governor->entered));
+    memset(governor->frames_at, 0, sizeof(governor->frames_at));
+}
+
+// Format a log line into the ring, or drop it if the ring is too full
+void governor_vlog(governor_t* governor, const char* format, va_list args)
+{
+    char line[GOVERNOR_LOG_LINE];
+    int length = vsnprintf(line, sizeof(line), format, args);
+    if (length < 0)
+        return;
+    if (length >= (int)sizeof(line))
+        length = sizeof(line) - 1;
+
+    if (governor->log_head - governor->log_tail + length > GOVERNOR_LOG_BYTES)
+    {
+        ++governor->log_dropped;
+        return;
+    }
+    for (int i = 0; i < length; ++i)
+    {
+        governor->log[governor->log_head++ % GOVERNOR_LOG_BYTES] = line[i];
+    }
+}
+
+// Next character of queued log text, or -1 when there is none
+int governor_log_next(governor_t* governor)
+{
+    if (governor->log_tail == governor->log_head)
+        return -1;
+    return (unsigned char)governor->log[governor->log_tail++ % GOVERNOR_LOG_BYTES];
+}
@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Load governor.
+//
+// The firmware reports the time it spent between two frames and the late scanlines libdvi
+// counted meanwhile. A frame over budget, or any late scanline, raises the degradation level
+// by one; GOVERNOR_CALM_FRAMES frames in a row within budget lower it by one. Each level keeps
+// what the levels below it shed, and the firmware decides what that means for it. Log lines
+// are queued here in any case and only written out at the normal level, as far as the UART
+// FIFO takes them without blocking. This file is portable.
+
+typedef enum
+{
+    GOVERNOR_NORMAL = 0,      // Everything runs every frame
+    GOVERNOR_DEFER_LOGS,      // Log output and periodic reports wait for a quieter frame
+    GOVERNOR_SPREAD_REPAINTS, // Large repaints are drawn a few rows per frame
+    GOVERNOR_SHED_FRAMES,     // Per-frame extras, such as smooth motion, run every other frame
+    GOVERNOR_LEVELS
+} governor_level_t;
+
+// Frames in a row within budget before the level goes down by one
+#define GOVERNOR_CALM_FRAMES 60
+
+// Log text waiting to be written, a line that does not fit is dropped whole
+#define GOVERNOR_LOG_BYTES 512
+#define GOVERNOR_LOG_LINE  128
+
+typedef struct
+{
+    uint32_t budget_us;
+    governor_level_t level;
+    uint32_t calm_frames;
+
+    // Since the last report
+    uint32_t frames;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t overruns;
+    uint32_t late_scanlines;
+    uint32_t entered[GOVERNOR_LEVELS];   // Times each level was raised to
+    uint32_t frames_at[GOVERNOR_LEVELS]; // Frames spent at each level
+
+    // Log ring, head and tail count bytes since boot
+    char log[GOVERNOR_LOG_BYTES];
+    uint32_t log_head;
+    uint32_t log_tail;
+    uint32_t log_dropped; // Lines, since boot
+} governor_t;
+
+// Function declarations
+void governor_init(governor_t* governor, uint32_t budget_us);
+governor_level_t governor_frame(governor_t* governor, uint32_t work_us, uint32_t late_scanlines);
+void governor_print(const governor_t* governor);
+void governor_reset_stats(governor_t* governor);
+void governor_vlog(governor_t* governor, const char* format, va_list args);
+int governor_log_next(governor_t* governor);
+
+#endif // GOVERNOR_H
@@ -0,0 +1,156 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "latency.h"
+#include "pico/stdlib.h"
+#include "scanout.h"
+
+#if LATENCY_MARKER_X + LATENCY_MARKER_SIZE > FRAME_WIDTH || LATENCY_MARKER_Y + LATENCY_MARKER_SIZE > FRAME_HEIGHT
+#error "Latency marker must lie inside the frame"
+#endif
+
+static bool key_pending;     // A key arrived and has not been shown yet
+static uint64_t key_time_us; // When it arrived
+
+static uint32_t histogram[LATENCY_BUCKET_COUNT];
+static uint32_t sample_count;
+static uint64_t sample_total_us;
+static uint32_t sample_min_us;
+static uint32_t sample_max_us;
+
+void latency_init(void)
+{
+    key_pending = false;
+    memset(histogram, 0, sizeof(histogram));
+    sample_count = 0;
+    sample_total_us = 0;
+    sample_min_us = UINT32_MAX;
+    sample_max_us = 0;
+}
+
+// Called from the HID report callback. Only the first key before a frame is measured,
+// later ones would be shown by the same frame.
+void latency_key_event(void)
+{
+    if (!key_pending)
+    {
+        key_time_us = time_us_64();
+        key_pending = true;
+    }
+}
+
+static void invert_marker(uint16_t* framebuffer)
+{
+    for (int y = LATENCY_MARKER_Y; y < LATENCY_MARKER_Y + LATENCY_MARKER_SIZE; ++y)
+    {
+        for (int x = LATENCY_MARKER_X; x < LATENCY_MARKER_X + LATENCY_MARKER_SIZE; ++x)
+        {
+            framebuffer[y * FRAME_WIDTH + x] ^= 0xFFFF;
+        }
+    }
+}
+
+// Called once the frame has been pushed
+static void add_sample(uint64_t scanout_us)
+{
+    const uint32_t latency_us = (uint32_t)(scanout_us - key_time_us);
+    uint32_t bucket = latency_us / LATENCY_BUCKET_US;
+    if (bucket >= LATENCY_BUCKET_COUNT)
+        bucket = LATENCY_BUCKET_COUNT - 1;
+
+    ++histogram[bucket];
+    ++sample_count;
+    sample_total_us += latency_us;
+    if (latency_us < sample_min_us)
+        sample_min_us = latency_us;
+    if (latency_us > sample_max_us)
+        sample_max_us = latency_us;
+
+    // One line per key, with absolute times for correlating with a capture
+    printf("LATENCY key=%llu scanout=%llu delta=%lu us\r\n", key_time_us, scanout_us, (unsigned long)latency_us);
+
+    if (sample_count % LATENCY_REPORT_INTERVAL == 0)
+        latency_report();
+}
+
+// Replacement for scanout_push_frame(). When a key is pending the frame goes out with the
+// marker inverted, and the first line is timed when core 1 hands its buffer back, which
+// happens one line time before it is shown. Lines come back in order, so the resolution
+// is about one line time as well.
+void latency_push_frame(uint16_t* framebuffer)
+{
+    if (!key_pending)
+    {
+        scanout_push_frame(framebuffer);
+        return;
+    }
+
+    invert_marker(framebuffer);
+
+    // Only the time is taken while lines are being pushed, printing could hold up the feed
+    const uint32_t first_line = scanout_lines_queued();
+    bool timed = false;
+    uint64_t scanout_us = 0;
+    for (uint y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        scanout_push_line(&framebuffer[y * FRAME_WIDTH]);
+        if (!timed && (int32_t)(scanout_lines_returned() - first_line) > 0)
+        {
+            scanout_us = time_us_64();
+            timed = true;
+        }
+    }
+
+    // The marker lines have long been encoded, restore them for the next frame
+    invert_marker(framebuffer);
+    if (timed)
+        add_sample(scanout_us);
+    key_pending = false;
+}
+
+void latency_report(void)
+{
+    if (sample_count == 0)
+    {
+        printf("Latency: no samples\r\n");
+        return;
+    }
+
+    printf("Latency: %lu samples, min %lu us, mean %lu us, max %lu us\r\n", (unsigned long)sample_count,
+           (unsigned long)sample_min_us, (unsigned long)(sample_total_us / sample_count), (unsigned long)sample_max_us);
+    for (uint i = 0; i < LATENCY_BUCKET_COUNT; ++i)
+    {
+        if (histogram[i] == 0)
+            continue;
+        if (i == LATENCY_BUCKET_COUNT - 1)
+            printf("  >=%5u us: %lu\r\n", i * LATENCY_BUCKET_US, (unsigned long)histogram[i]);
+        else
+            printf("  %5u-%5u us: %lu\r\n", i * LATENCY_BUCKET_US, (i + 1) * LATENCY_BUCKET_US,
+                   (unsigned long)histogram[i]);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+// Input-to-photon latency test. A key report is timestamped when it arrives, the next frame
+// is scanned out with the marker region inverted, and the time from the report to the first
+// scanline of that frame leaving the line queue is collected in a histogram and reported
+// over UART. A capture of the DVI output shows the marker flash, so the host can add the
+// capture side of the latency.
+
+// Size and position of the marker region, in framebuffer pixels
+#ifndef LATENCY_MARKER_X
+#define LATENCY_MARKER_X 0
+#endif
+#ifndef LATENCY_MARKER_Y
+#define LATENCY_MARKER_Y 0
+#endif
+#ifndef LATENCY_MARKER_SIZE
+#define LATENCY_MARKER_SIZE 16
+#endif
+
+// Histogram bucket width and count, the last bucket collects everything above
+#define LATENCY_BUCKET_US    250
+#define LATENCY_BUCKET_COUNT 64
+
+// Print the histogram after this many measurements
+#ifndef LATENCY_REPORT_INTERVAL
+#define LATENCY_REPORT_INTERVAL 16
+#endif
+
+// Function declarations
+void latency_init(void);
+void latency_key_event(void);
+void latency_push_frame(uint16_t* framebuffer);
+void latency_report(void);
+
+#endif // LATENCY_H
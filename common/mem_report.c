@@ -0,0 +1,146 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "mem_report.h"
+#include "pico/stdlib.h"
+
+// Linker symbols from the Pico SDK memory map. The core 0 stack is at the top of SCRATCH_Y,
+// the core 1 stack used by multicore_launch_core1() at the top of SCRATCH_X, and the heap
+// runs from the end of .bss to the end of main RAM.
+extern uint32_t __data_start__[], __data_end__[];
+extern uint32_t __bss_start__[], __bss_end__[];
+extern uint32_t __end__[], __StackLimit[];
+extern uint32_t __StackBottom[], __StackTop[];
+extern uint32_t __StackOneBottom[], __StackOneTop[];
+
+static uint32_t* const stack_bottom[2] = {__StackBottom, __StackOneBottom};
+static uint32_t* const stack_top[2] = {__StackTop, __StackOneTop};
+
+static uint32_t stack_peak[2];
+static bool stack_warned[2];
+static uint64_t next_scan_us;
+
+static void paint(uint32_t* from, uint32_t* to)
+{
+    for (uint32_t* p = from; p < to; ++p)
+    {
+        *p = MEM_REPORT_STACK_PAINT;
+    }
+}
+
+// Paint both stacks. Must run on core 0 before core 1 is launched. The core 0 stack is only
+// painted below the current frame, with some margin for interrupts taken while painting.
+void mem_report_init(void)
+{
+    volatile uint32_t here;
+    uint32_t* const frame = (uint32_t*)&here - 64;
+    if (frame > __StackBottom && frame < __StackTop)
+        paint(__StackBottom, frame);
+    paint(__StackOneBottom, __StackOneTop);
+
+    stack_peak[0] = stack_peak[1] = 0;
+    stack_warned[0] = stack_warned[1] = false;
+    next_scan_us = 0;
+}
+
+// Stacks grow down, so the words still holding the paint at the bottom were never used
+static uint32_t stack_used(int core)
+{
+    const uint32_t* p = stack_bottom[core];
+    while (p < stack_top[core] && *p == MEM_REPORT_STACK_PAINT)
+    {
+        ++p;
+    }
+    return (uint32_t)((const uint8_t*)stack_top[core] - (const uint8_t*)p);
+}
+
+void mem_report_scan(void)
+{
+    for (int core = 0; core < 2; ++core)
+    {
+        const uint32_t size = (uint32_t)((uint8_t*)stack_top[core] - (uint8_t*)stack_bottom[core]);
+        stack_peak[core] = stack_used(core);
+        if (!stack_warned[core] && size - stack_peak[core] < MEM_REPORT_STACK_WARN_BYTES)
+        {
+            printf("Warning: core %d stack has only %lu bytes left\r\n", core,
+                   (unsigned long)(size - stack_peak[core]));
+            stack_warned[core] = true;
+        }
+    }
+}
+
+void mem_report_get(mem_report_t* report)
+{
+    const struct mallinfo info = mallinfo();
+    const uint8_t* heap_end = sbrk(0);
+    const uint32_t unclaimed = (uint32_t)((const uint8_t*)__StackLimit - heap_end);
+
+    report->data_bytes = (uint32_t)((uint8_t*)__data_end__ - (uint8_t*)__data_start__);
+    report->bss_bytes = (uint32_t)((uint8_t*)__bss_end__ - (uint8_t*)__bss_start__);
+    report->heap_used_bytes = info.uordblks;
+    report->heap_free_bytes = info.fordblks + unclaimed;
+
+    // The free chunk at the top of the arena joins the space the heap has not claimed yet.
+    // Free chunks lower down can only be smaller than everything that is free.
+    report->largest_free_bytes = info.keepcost + unclaimed;
+
+    for (int core = 0; core < 2; ++core)
+    {
+        report->stack_size[core] = (uint32_t)((uint8_t*)stack_top[core] - (uint8_t*)stack_bottom[core]);
+        report->stack_peak[core] = stack_peak[core];
+    }
+}
+
+void mem_report_print(void)
+{
+    mem_report_scan();
+
+    mem_report_t report;
+    mem_report_get(&report);
+    printf("Memory: .data %lu B, .bss %lu B, heap %lu B used, %lu B free, largest free block %lu B\r\n",
+           (unsigned long)report.data_bytes, (unsigned long)report.bss_bytes, (unsigned long)report.heap_used_bytes,
+           (unsigned long)report.heap_free_bytes, (unsigned long)report.largest_free_bytes);
+    for (int core = 0; core < 2; ++core)
+    {
+        printf("Stack core %d: peak %lu of %lu B\r\n", core, (unsigned long)report.stack_peak[core],
+               (unsigned long)report.stack_size[core]);
+    }
+}
+
+// Call from the main loop: scans the stacks periodically. The report is printed by the "mem"
+// command, see uart_command.h.
+void mem_report_poll(void)
+{
+    const uint64_t now = time_us_64();
+    if (now >= next_scan_us)
+    {
+        mem_report_scan();
+        next_scan_us = now + MEM_REPORT_SCAN_INTERVAL_MS * 1000;
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <stdint.h>
+
+// RAM usage and stack high-water marks.
+//
+// Both core stacks are painted with a known pattern at boot, and a periodic scan finds how
+// much of each has been overwritten. Together with the static (.data/.bss) and heap usage
+// from the linker symbols and the allocator, this shows how much RAM is left before adding
+// buffers. Send "m" or "mem" over the UART command channel to print the report.
+
+#define MEM_REPORT_STACK_PAINT 0xa5a5a5a5u
+
+// Milliseconds between high-water-mark scans
+#ifndef MEM_REPORT_SCAN_INTERVAL_MS
+#define MEM_REPORT_SCAN_INTERVAL_MS 1000
+#endif
+
+// Warn once when a stack has less than this many bytes left
+#ifndef MEM_REPORT_STACK_WARN_BYTES
+#define MEM_REPORT_STACK_WARN_BYTES 256
+#endif
+
+typedef struct
+{
+    uint32_t data_bytes;
+    uint32_t bss_bytes;
+    uint32_t heap_used_bytes;    // Allocated by malloc
+    uint32_t heap_free_bytes;    // Free, in the arena and above it
+    uint32_t largest_free_bytes; // Largest block malloc can return without fragmentation getting in the way
+    uint32_t stack_size[2];
+    uint32_t stack_peak[2]; // Deepest stack use seen by the scans, per core
+} mem_report_t;
+
+// Function declarations
+void mem_report_init(void);
+void mem_report_scan(void);
+void mem_report_get(mem_report_t* report);
+void mem_report_print(void);
+void mem_report_poll(void);
+
+#endif // MEM_REPORT_H
@@ -0,0 +1,76 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "renderer.hpp"
+
+extern "C"
+{
+#include "display_mode.h"
+#include "renderer.h"
+}
+
+using Screen = kiwi::Framebuffer<kiwi::PixelFormat::rgb565, FRAME_WIDTH, FRAME_HEIGHT>;
+
+void render_fill_rect(uint16_t* framebuffer, int x, int y, int w, int h, uint16_t colour)
+{
+    Screen::fill_rect(framebuffer, x, y, w, h, colour);
+}
+
+void render_fill_cell(uint16_t* framebuffer, int cell_x, int cell_y, int size, uint16_t colour)
+{
+    switch (size)
+    {
+    case 8:
+        Screen::fill_cell<8>(framebuffer, cell_x, cell_y, colour);
+        break;
+    case 16:
+        Screen::fill_cell<16>(framebuffer, cell_x, cell_y, colour);
+        break;
+    default:
+        Screen::fill_rect(framebuffer, cell_x * size, cell_y * size, size, size, colour);
+        break;
+    }
+}
+
+void render_glyph(uint16_t* framebuffer, const uint8_t* glyph, int stride, int w, int h, int x, int y, uint16_t fg,
+                  uint16_t bg)
+{
+    if (w == 8 && h == 16)
+        Screen::blit_glyph<8, 16>(framebuffer, glyph, stride, x, y, fg, bg);
+    else if (w == 8 && h == 8)
+        Screen::blit_glyph<8, 8>(framebuffer, glyph, stride, x, y, fg, bg);
+    else
+        Screen::blit_glyph_generic(framebuffer, glyph, stride, w, h, x, y, fg, bg);
+}
+
+// Integer scale factor, drawn as row-replicated spans
+void render_glyph_scaled(uint16_t* framebuffer, const uint8_t* glyph, int stride, int w, int h, int x, int y,
+                         int scale, uint16_t fg, uint16_t bg)
+{
+    if (scale == 1)
+        render_glyph(framebuffer, glyph, stride, w, h, x, y, fg, bg);
+    else
+        Screen::blit_glyph_scaled(framebuffer, glyph, stride, w, h, x, y, scale, fg, bg);
+}
@@ -0,0 +1,51 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <stdint.h>
+
+// C interface to the compile-time specialised renderer in renderer.hpp, for RGB565
+// framebuffers of FRAME_WIDTH x FRAME_HEIGHT pixels. Cell and glyph sizes used by the apps
+// go to dedicated instances, anything else to the generic code.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+void render_fill_rect(uint16_t* framebuffer, int x, int y, int w, int h, uint16_t colour);
+void render_fill_cell(uint16_t* framebuffer, int cell_x, int cell_y, int size, uint16_t colour);
+void render_glyph(uint16_t* framebuffer, const uint8_t* glyph, int stride, int w, int h, int x, int y, uint16_t fg,
+                  uint16_t bg);
+void render_glyph_scaled(uint16_t* framebuffer, const uint8_t* glyph, int stride, int w, int h, int x, int y,
+                         int scale, uint16_t fg, uint16_t bg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RENDERER_H
@@ -0,0 +1,407 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// Header-only renderer specialised at compile time.
+//
+// Pixel format, frame size and block or glyph size are template parameters, so every
+// primitive is generated for exactly one case: loop bounds are constants, rows are unrolled,
+// and pixels are written a 32-bit word at a time wherever the alignment is known. Glyphs are
+// expanded through lookup tables built by constexpr functions. The C code reaches it through
+// renderer.h.
+
+namespace kiwi
+{
+
+enum class PixelFormat
+{
+    rgb565,   // 16-bit colour, one pixel per uint16_t
+    indexed8, // 8-bit palette index, one pixel per byte
+    mono1     // 1 bit per pixel, leftmost pixel in the most significant bit
+};
+
+template <PixelFormat Format> struct PixelTraits;
+
+template <> struct PixelTraits<PixelFormat::rgb565>
+{
+    using Storage = uint16_t;
+    static constexpr int pixels_per_word = 2;
+    static constexpr uint32_t replicate(uint32_t colour)
+    {
+        return colour * 0x00010001u;
+    }
+};
+
+template <> struct PixelTraits<PixelFormat::indexed8>
+{
+    using Storage = uint8_t;
+    static constexpr int pixels_per_word = 4;
+    static constexpr uint32_t replicate(uint32_t colour)
+    {
+        return colour * 0x01010101u;
+    }
+};
+
+template <> struct PixelTraits<PixelFormat::mono1>
+{
+    using Storage = uint8_t;
+    static constexpr int pixels_per_word = 32;
+    static constexpr uint32_t replicate(uint32_t colour)
+    {
+        return colour ? 0xffffffffu : 0;
+    }
+};
+
+// Call f(0) ... f(N - 1) with compile-time indices, fully unrolled
+template <typename F, std::size_t... I> constexpr void unroll_impl(F&& f, std::index_sequence<I...>)
+{
+    (f(std::integral_constant<std::size_t, I>{}), ...);
+}
+
+template <std::size_t N, typename F> constexpr void unroll(F&& f)
+{
+    unroll_impl(f, std::make_index_sequence<N>{});
+}
+
+// Masks selecting the pixels of a word that are set in a group of glyph bits. The leftmost
+// pixel is the most significant glyph bit and the lowest address, so it is the least
+// significant part of the little-endian word.
+constexpr std::array<uint32_t, 4> make_rgb565_expand()
+{
+    std::array<uint32_t, 4> lut{};
+    for (uint32_t bits = 0; bits < 4; ++bits)
+    {
+        lut[bits] = ((bits & 2) ? 0x0000ffffu : 0) | ((bits & 1) ? 0xffff0000u : 0);
+    }
+    return lut;
+}
+
+constexpr std::array<uint32_t, 16> make_indexed8_expand()
+{
+    std::array<uint32_t, 16> lut{};
+    for (uint32_t bits = 0; bits < 16; ++bits)
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (bits & (8 >> i))
+                lut[bits] |= 0xffu << (8 * i);
+        }
+    }
+    return lut;
+}
+
+// RGB565 colour of each RGB332 palette index, with the channels scaled to full range
+constexpr std::array<uint16_t, 256> make_rgb332_palette()
+{
+    std::array<uint16_t, 256> lut{};
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        const uint32_t r = (i >> 5) & 7, g = (i >> 2) & 7, b = i & 3;
+        lut[i] = (uint16_t)(((r * 31 + 3) / 7) << 11 | ((g * 63 + 3) / 7) << 5 | ((b * 31 + 1) / 3));
+    }
+    return lut;
+}
+
+inline constexpr std::array<uint32_t, 4> rgb565_expand = make_rgb565_expand();
+inline constexpr std::array<uint32_t, 16> indexed8_expand = make_indexed8_expand();
+inline constexpr std::array<uint16_t, 256> rgb332_palette = make_rgb332_palette();
+
+static_assert(rgb565_expand[2] == 0x0000ffffu, "leftmost pixel is the low halfword");
+static_assert(indexed8_expand[8] == 0x000000ffu, "leftmost pixel is the low byte");
+static_assert(rgb332_palette[0xff] == 0xffff && rgb332_palette[0xe0] == 0xf800, "RGB332 scales to full range");
+
+template <PixelFormat Format, int Width, int Height> struct Framebuffer
+{
+    using Traits = PixelTraits<Format>;
+    using Storage = typename Traits::Storage;
+
+    static constexpr int width = Width;
+    static constexpr int height = Height;
+    static constexpr int stride = Format == PixelFormat::mono1 ? Width / 8 : Width; // Storage units per row
+
+    static_assert(Format != PixelFormat::mono1 || Width % 8 == 0, "1bpp rows must be whole bytes");
+    static_assert(Width % Traits::pixels_per_word == 0 || Format == PixelFormat::mono1,
+                  "rows must be whole words");
+
+    static Storage* row(Storage* fb, int y)
+    {
+        return fb + y * stride;
+    }
+
+    static void set_pixel(Storage* fb, int x, int y, uint32_t colour)
+    {
+        if constexpr (Format == PixelFormat::mono1)
+        {
+            uint8_t* p = row(fb, y) + (x >> 3);
+            const uint8_t bit = 0x80 >> (x & 7);
+            *p = colour ? (*p | bit) : (*p & ~bit);
+        }
+        else
+        {
+            row(fb, y)[x] = (Storage)colour;
+        }
+    }
+
+    // Fill w pixels of a row starting at x, with word stores between the unaligned ends
+    static void fill_span(Storage* line, int x, int w, uint32_t colour)
+    {
+        if constexpr (Format == PixelFormat::mono1)
+        {
+            const uint8_t fill = colour ? 0xff : 0x00;
+            while (w > 0 && (x & 7))
+            {
+                set_pixel(line, x++, 0, colour);
+                --w;
+            }
+            for (; w >= 8; w -= 8, x += 8)
+            {
+                line[x >> 3] = fill;
+            }
+            while (w-- > 0)
+            {
+                set_pixel(line, x++, 0, colour);
+            }
+        }
+        else
+        {
+            constexpr int per_word = Traits::pixels_per_word;
+            const uint32_t word = Traits::replicate(colour);
+            Storage* p = line + x;
+            while (w > 0 && ((uintptr_t)p & 3))
+            {
+                *p++ = (Storage)colour;
+                --w;
+            }
+            uint32_t* words = (uint32_t*)p;
+            for (; w >= per_word; w -= per_word)
+            {
+                *words++ = word;
+            }
+            p = (Storage*)words;
+            while (w-- > 0)
+            {
+                *p++ = (Storage)colour;
+            }
+        }
+    }
+
+    static void fill_rect(Storage* fb, int x, int y, int w, int h, uint32_t colour)
+    {
+        for (int i = 0; i < h; ++i)
+        {
+            fill_span(row(fb, y + i), x, w, colour);
+        }
+    }
+
+    // Fill the square cell (cell_x, cell_y) of a grid of Size x Size cells. The cell's
+    // alignment is known at compile time, so each row is a fixed, unrolled run of word stores.
+    template <int Size> static void fill_cell(Storage* fb, int cell_x, int cell_y, uint32_t colour)
+    {
+        Storage* first = row(fb, cell_y * Size);
+        if constexpr (Format == PixelFormat::mono1 && Size % 8 == 0)
+        {
+            const uint8_t fill = colour ? 0xff : 0x00;
+            unroll<Size>([&](auto i) {
+                uint8_t* p = first + i * stride + cell_x * (Size / 8);
+                unroll<Size / 8>([&](auto j) { p[j] = fill; });
+            });
+        }
+        else if constexpr (Format != PixelFormat::mono1 && (Size * sizeof(Storage)) % 4 == 0)
+        {
+            constexpr int words_per_row = Size * sizeof(Storage) / 4;
+            const uint32_t word = Traits::replicate(colour);
+            unroll<Size>([&](auto i) {
+                uint32_t* p = (uint32_t*)(first + i * stride + cell_x * Size);
+                unroll<words_per_row>([&](auto j) { p[j] = word; });
+            });
+        }
+        else
+        {
+            fill_rect(fb, cell_x * Size, cell_y * Size, Size, Size, colour);
+        }
+    }
+
+    // Draw a GlyphWidth x GlyphHeight 1bpp glyph with stride bytes per row, a stride of 0
+    // repeating the first row. Set bits are drawn in fg and clear bits in bg.
+    template <int GlyphWidth, int GlyphHeight>
+    static void blit_glyph(Storage* fb, const uint8_t* glyph, int glyph_stride, int x, int y, uint32_t fg,
+                           uint32_t bg)
+    {
+        static_assert(GlyphWidth % 8 == 0, "glyph rows must be whole bytes");
+        constexpr int bytes = GlyphWidth / 8;
+
+        if constexpr (Format == PixelFormat::rgb565)
+        {
+            if (x & 1)
+            {
+                blit_glyph_generic(fb, glyph, glyph_stride, GlyphWidth, GlyphHeight, x, y, fg, bg);
+                return;
+            }
+            const uint32_t bg_word = Traits::replicate(bg);
+            const uint32_t diff = bg_word ^ Traits::replicate(fg);
+            for (int i = 0; i < GlyphHeight; ++i)
+            {
+                const uint8_t* src = glyph + i * glyph_stride;
+                uint32_t* dst = (uint32_t*)(row(fb, y + i) + x);
+                unroll<bytes>([&](auto b) {
+                    const uint32_t bits = src[b];
+                    unroll<4>([&](auto k) {
+                        dst[b * 4 + k] = bg_word ^ (diff & rgb565_expand[(bits >> (6 - 2 * k)) & 3]);
+                    });
+                });
+            }
+        }
+        else if constexpr (Format == PixelFormat::indexed8)
+        {
+            if (x & 3)
+            {
+                blit_glyph_generic(fb, glyph, glyph_stride, GlyphWidth, GlyphHeight, x, y, fg, bg);
+                return;
+            }
+            const uint32_t bg_word = Traits::replicate(bg);
+            const uint32_t diff = bg_word ^ Traits::replicate(fg);
+            for (int i = 0; i < GlyphHeight; ++i)
+            {
+                const uint8_t* src = glyph + i * glyph_stride;
+                uint32_t* dst = (uint32_t*)(row(fb, y + i) + x);
+                unroll<bytes>([&](auto b) {
+                    const uint32_t bits = src[b];
+                    dst[b * 2] = bg_word ^ (diff & indexed8_expand[bits >> 4]);
+                    dst[b * 2 + 1] = bg_word ^ (diff & indexed8_expand[bits & 15]);
+                });
+            }
+        }
+        else
+        {
+            if (x & 7)
+            {
+                blit_glyph_generic(fb, glyph, glyph_stride, GlyphWidth, GlyphHeight, x, y, fg, bg);
+                return;
+            }
+            // Set bits become fg and clear bits bg: copy, invert or fill
+            const uint8_t set = fg ? 0xff : 0x00;
+            const uint8_t clear = bg ? 0xff : 0x00;
+            for (int i = 0; i < GlyphHeight; ++i)
+            {
+                const uint8_t* src = glyph + i * glyph_stride;
+                uint8_t* dst = row(fb, y + i) + (x >> 3);
+                unroll<bytes>([&](auto b) { dst[b] = (src[b] & set) | (~src[b] & clear); });
+            }
+        }
+    }
+
+    // Draw a 1bpp glyph scaled up by an integer factor, for large digits. Each glyph row is
+    // drawn once as runs of equal bits, one fill_span() of run * scale pixels per run, and the
+    // line is then copied to the scale - 1 lines under it.
+    static void blit_glyph_scaled(Storage* fb, const uint8_t* glyph, int glyph_stride, int w, int h, int x, int y,
+                                  int scale, uint32_t fg, uint32_t bg)
+    {
+        for (int i = 0; i < h; ++i)
+        {
+            const uint8_t* src = glyph + i * glyph_stride;
+            const auto draw_row = [&](Storage* line) {
+                for (int j = 0; j < w;)
+                {
+                    const bool set = src[j >> 3] & (0x80 >> (j & 7));
+                    int run = 1;
+                    while (j + run < w && bool(src[(j + run) >> 3] & (0x80 >> ((j + run) & 7))) == set)
+                        ++run;
+                    fill_span(line, x + j * scale, run * scale, set ? fg : bg);
+                    j += run;
+                }
+            };
+
+            Storage* first = row(fb, y + i * scale);
+            draw_row(first);
+            for (int k = 1; k < scale; ++k)
+            {
+                // 1bpp spans need not start on a byte, so those rows are drawn again
+                if constexpr (Format == PixelFormat::mono1)
+                    draw_row(row(fb, y + i * scale + k));
+                else
+                    memcpy(row(fb, y + i * scale + k) + x, first + x, w * scale * sizeof(Storage));
+            }
+        }
+    }
+
+    // Any size and position, one pixel at a time
+    static void blit_glyph_generic(Storage* fb, const uint8_t* glyph, int glyph_stride, int w, int h, int x, int y,
+                                   uint32_t fg, uint32_t bg)
+    {
+        for (int i = 0; i < h; ++i)
+        {
+            const uint8_t* src = glyph + i * glyph_stride;
+            for (int j = 0; j < w; ++j)
+            {
+                set_pixel(fb, x + j, y + i, (src[j >> 3] & (0x80 >> (j & 7))) ? fg : bg);
+            }
+        }
+    }
+
+    // Convert one row to RGB565 for scanout. Indexed rows go through the palette, which
+    // can be rgb332_palette, and 1bpp rows use palette[0] and palette[1].
+    static void expand_row(const Storage* src, uint16_t* dst, const uint16_t* palette)
+    {
+        if constexpr (Format == PixelFormat::rgb565)
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                dst[x] = src[x];
+            }
+        }
+        else if constexpr (Format == PixelFormat::indexed8)
+        {
+            for (int x = 0; x < Width; ++x)
+            {
+                dst[x] = palette[src[x]];
+            }
+        }
+        else
+        {
+            const uint32_t bg_word = PixelTraits<PixelFormat::rgb565>::replicate(palette[0]);
+            const uint32_t diff = bg_word ^ PixelTraits<PixelFormat::rgb565>::replicate(palette[1]);
+            uint32_t* out = (uint32_t*)dst;
+            for (int b = 0; b < Width / 8; ++b)
+            {
+                const uint32_t bits = src[b];
+                unroll<4>([&](auto k) {
+                    out[b * 4 + k] = bg_word ^ (diff & rgb565_expand[(bits >> (6 - 2 * k)) & 3]);
+                });
+            }
+        }
+    }
+};
+
+} // namespace kiwi
+
+#endif // RENDERER_HPP
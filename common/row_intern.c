@@ -0,0 +1,238 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "row_intern.h"
+
+#define NO_BUFFER 0xffff
+
+static uint16_t* buffer(const row_intern_t* intern, uint32_t index)
+{
+    return &intern->pool[index * intern->width];
+}
+
+static void set_row(row_intern_t* intern, uint32_t y, uint16_t index)
+{
+    intern->rows[y] = index;
+    intern->lines[y] = buffer(intern, index);
+}
+
+static void release(row_intern_t* intern, uint16_t index)
+{
+    if (--intern->refs[index] == 0)
+    {
+        intern->interned[index] = false;
+        --intern->stats.rows_in_use;
+    }
+}
+
+// FNV-1a over the row's words
+static uint32_t hash_row(const uint16_t* row, uint32_t width)
+{
+    const uint32_t* words = (const uint32_t*)row;
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < width / 2; ++i)
+    {
+        hash = (hash ^ words[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void row_intern_init(row_intern_t* intern, uint16_t* pool, uint16_t* refs, uint32_t* hashes, bool* interned,
+                     uint16_t* rows, bool* dirty, const uint16_t** lines, uint16_t width, uint16_t height,
+                     uint16_t pool_size, uint16_t colour)
+{
+    intern->width = width;
+    intern->height = height;
+    intern->pool_size = pool_size;
+    intern->next_free = 1;
+    intern->pool = pool;
+    intern->refs = refs;
+    intern->hashes = hashes;
+    intern->interned = interned;
+    intern->rows = rows;
+    intern->dirty = dirty;
+    intern->lines = lines;
+    intern->dirty_cursor = 0;
+    memset(&intern->stats, 0, sizeof(intern->stats));
+    memset(refs, 0, pool_size * sizeof(refs[0]));
+    memset(interned, 0, pool_size * sizeof(interned[0]));
+    memset(dirty, 0, height * sizeof(dirty[0]));
+
+    // Every row starts out as one shared buffer filled with colour
+    uint16_t* first = buffer(intern, 0);
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        first[x] = colour;
+    }
+    refs[0] = height;
+    hashes[0] = hash_row(first, width);
+    interned[0] = true;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        set_row(intern, y, 0);
+    }
+    intern->stats.rows_in_use = 1;
+    intern->stats.high_water = 1;
+}
+
+static uint16_t find_free(row_intern_t* intern)
+{
+    for (uint32_t i = 0; i < intern->pool_size; ++i)
+    {
+        const uint16_t index = (intern->next_free + i) % intern->pool_size;
+        if (intern->refs[index] == 0)
+        {
+            intern->next_free = (index + 1) % intern->pool_size;
+            return index;
+        }
+    }
+    return NO_BUFFER;
+}
+
+// Share row y with an identical interned buffer, or intern its own buffer
+static void intern_row(row_intern_t* intern, uint32_t y)
+{
+    const uint16_t index = intern->rows[y];
+    const uint16_t* row = buffer(intern, index);
+    const uint32_t hash = hash_row(row, intern->width);
+    intern->dirty[y] = false;
+
+    for (uint16_t other = 0; other < intern->pool_size; ++other)
+    {
+        if (other == index || !intern->interned[other] || intern->hashes[other] != hash)
+            continue;
+        if (memcmp(buffer(intern, other), row, intern->width * sizeof(uint16_t)) != 0)
+            continue;
+
+        ++intern->refs[other];
+        set_row(intern, y, other);
+        release(intern, index);
+        ++intern->stats.merges;
+        return;
+    }
+
+    intern->hashes[index] = hash;
+    intern->interned[index] = true;
+}
+
+// Return row y for drawing, copying it first if it is shared. Returns NULL if the pool is full
+// even after merging every row drawn into so far.
+uint16_t* row_intern_write(row_intern_t* intern, uint32_t y)
+{
+    const uint16_t index = intern->rows[y];
+    intern->dirty[y] = true;
+
+    if (intern->refs[index] == 1)
+    {
+        // Private already, but its contents are about to change
+        intern->interned[index] = false;
+        return buffer(intern, index);
+    }
+
+    uint16_t copy = find_free(intern);
+    if (copy == NO_BUFFER)
+    {
+        row_intern_collect(intern, intern->height);
+        if (intern->rows[y] != index)
+            return row_intern_write(intern, y); // Row y itself was merged
+        copy = find_free(intern);
+        if (copy == NO_BUFFER)
+        {
+            intern->dirty[y] = false;
+            ++intern->stats.alloc_failures;
+            return NULL;
+        }
+    }
+
+    memcpy(buffer(intern, copy), buffer(intern, index), intern->width * sizeof(uint16_t));
+    intern->refs[copy] = 1;
+    intern->interned[copy] = false;
+    --intern->refs[index];
+    set_row(intern, y, copy);
+
+    ++intern->stats.copies;
+    if (++intern->stats.rows_in_use > intern->stats.high_water)
+        intern->stats.high_water = intern->stats.rows_in_use;
+    return buffer(intern, copy);
+}
+
+// Fill a rectangle, clipped to the screen, copying the rows it covers where they are shared
+void row_intern_fill(row_intern_t* intern, int x, int y, int width, int height, uint16_t colour)
+{
+    if (x < 0)
+    {
+        width += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        height += y;
+        y = 0;
+    }
+    if (x + width > intern->width)
+        width = intern->width - x;
+    if (y + height > intern->height)
+        height = intern->height - y;
+
+    for (int row = y; row < y + height && width > 0; ++row)
+    {
+        uint16_t* pixels = row_intern_write(intern, row);
+        if (pixels == NULL)
+            continue;
+        for (int i = x; i < x + width; ++i)
+        {
+            pixels[i] = colour;
+        }
+    }
+}
+
+// Merge up to max_rows of the rows drawn into since the last call with identical buffers
+void row_intern_collect(row_intern_t* intern, uint32_t max_rows)
+{
+    for (uint32_t i = 0; i < intern->height && max_rows > 0; ++i)
+    {
+        const uint32_t y = intern->dirty_cursor;
+        intern->dirty_cursor = (intern->dirty_cursor + 1) % intern->height;
+        if (intern->dirty[y])
+        {
+            intern_row(intern, y);
+            --max_rows;
+        }
+    }
+}
+
+void row_intern_print(const row_intern_t* intern)
+{
+    const row_intern_stats_t* s = &intern->stats;
+    const uint32_t row_bytes = intern->width * sizeof(uint16_t);
+    printf("Rows: %u rows in %lu buffers, %lu of %lu bytes, high water %lu of %u buffers\r\n", intern->height,
+           (unsigned long)s->rows_in_use, (unsigned long)(s->rows_in_use * row_bytes),
+           (unsigned long)(intern->height * row_bytes), (unsigned long)s->high_water, intern->pool_size);
+    printf("Rows: %lu copies, %lu merges, %lu dropped draws\r\n", (unsigned long)s->copies,
+           (unsigned long)s->merges, (unsigned long)s->alloc_failures);
+}
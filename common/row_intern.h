@@ -0,0 +1,93 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef ROW_INTERN_H
+#define ROW_INTERN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Interned framebuffer rows.
+//
+// Screen rows are references into a fixed pool of row buffers, and identical rows share one
+// reference-counted buffer. Drawing into a row goes through row_intern_write(), which copies a
+// shared row into a free buffer first (copy on write). Rows that have been drawn into are
+// hashed and merged with an identical buffer again by row_intern_collect(), a bounded number per
+// call. Memory then follows the number of distinct rows rather than the screen height: a snake
+// screen is mostly border rows, empty playfield rows and rows crossed by the same few cells.
+// Scanout reads the rows through the line pointer table, see scanout_push_lines().
+
+typedef struct
+{
+    uint32_t rows_in_use;   // Distinct row buffers referenced by the screen
+    uint32_t high_water;    // Most buffers in use at once, including rows waiting to be merged
+    uint32_t copies;        // Shared rows copied before drawing
+    uint32_t merges;        // Rows found identical to another buffer and shared again
+    uint32_t alloc_failures; // Draws dropped because the pool was full
+} row_intern_stats_t;
+
+typedef struct
+{
+    uint16_t width;
+    uint16_t height;
+    uint16_t pool_size;
+    uint16_t next_free; // Where the search for a free buffer starts
+
+    uint16_t* pool;         // pool_size * width pixels
+    uint16_t* refs;         // References to each buffer, 0 when free
+    uint32_t* hashes;       // Hash of each interned buffer
+    bool* interned;         // Buffer contents are hashed and may be shared
+    uint16_t* rows;         // Buffer index of each screen row
+    bool* dirty;            // Screen row drawn into since it was last interned
+    const uint16_t** lines; // Start of each screen row, for scanout
+    uint16_t dirty_cursor;
+
+    row_intern_stats_t stats;
+} row_intern_t;
+
+// Storage for a screen of the given size with pool_size row buffers, declared by the caller
+#define ROW_INTERN_STORAGE(name, width, height, pool_size)                                                            \
+    static uint16_t name##_pool[(pool_size) * (width)] __attribute__((aligned(4)));                                    \
+    static uint16_t name##_refs[pool_size];                                                                            \
+    static uint32_t name##_hashes[pool_size];                                                                          \
+    static bool name##_interned[pool_size];                                                                            \
+    static uint16_t name##_rows[height];                                                                               \
+    static bool name##_dirty[height];                                                                                  \
+    static const uint16_t* name##_lines[height]
+
+#define ROW_INTERN_INIT(intern, name, width, height, pool_size, colour)                                                \
+    row_intern_init(intern, name##_pool, name##_refs, name##_hashes, name##_interned, name##_rows, name##_dirty,       \
+                    name##_lines, width, height, pool_size, colour)
+
+// Function declarations
+void row_intern_init(row_intern_t* intern, uint16_t* pool, uint16_t* refs, uint32_t* hashes, bool* interned,
+                     uint16_t* rows, bool* dirty, const uint16_t** lines, uint16_t width, uint16_t height,
+                     uint16_t pool_size, uint16_t colour);
+uint16_t* row_intern_write(row_intern_t* intern, uint32_t y);
+void row_intern_fill(row_intern_t* intern, int x, int y, int width, int height, uint16_t colour);
+void row_intern_collect(row_intern_t* intern, uint32_t max_rows);
+void row_intern_print(const row_intern_t* intern);
+
+#endif // ROW_INTERN_H
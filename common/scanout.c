@@ -0,0 +1,407 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "scanout.h"
+#include "tmds_encode.h"
+
+#if SCANOUT_STATS
+static scanout_stats_t stats;
+static uint32_t line_period_ns; // Time core 1 takes to consume one queued line
+static uint32_t late_scanlines_base;
+#endif
+
+#if FRAME_CRC
+// Signature of the frame being queued, and of the last complete one
+static frame_crc_t frame_sig;
+static uint32_t signed_frames;
+static uint32_t last_crc;
+static uint32_t reported_frames;
+#endif
+
+#if TMDS_CACHE
+#if TMDS_CACHE_ENTRIES <= DVI_N_TMDS_BUFFERS
+#error "The TMDS cache needs more entries than libdvi has lines in flight"
+#endif
+
+// Encoded lines and the pixels they came from. libdvi encodes each pixel into one word of two
+// symbols, so a line is three channels of SCANLINE_WIDTH words.
+#define TMDS_CACHE_LINE_WORDS (3 * SCANLINE_WIDTH)
+static tmds_cache_t tmds_cache;
+static uint16_t tmds_cache_pixels[TMDS_CACHE_ENTRIES * SCANLINE_WIDTH] __attribute__((aligned(4)));
+static uint32_t tmds_cache_symbols[TMDS_CACHE_ENTRIES * TMDS_CACHE_LINE_WORDS];
+static tmds_cache_stats_t tmds_cache_reported; // Counters at the last report
+static uint32_t tmds_cache_report_lines;       // lines_queued at the last report
+#endif
+
+static struct dvi_inst* scanout_dvi;
+
+// Background work run between lines while a frame is pushed
+static void (*line_poll)(void);
+
+// Number of lines added to q_colour_valid and taken back from q_colour_free so far.
+// Lines come back in the order they were queued, so comparing the two tells whether
+// a given line has been encoded by core 1.
+static uint32_t lines_queued;
+static uint32_t lines_returned;
+
+#if FRAME_H_REPEAT > 2
+#error "Scanout only widens lines by a factor of 2"
+#endif
+
+// Line buffers for lines rendered on the fly and for widened framebuffer lines
+static uint16_t line_buffers[SCANOUT_LINE_BUFFERS][SCANLINE_WIDTH];
+static uint32_t line_buffer_release[SCANOUT_LINE_BUFFERS]; // lines_queued after the last use of each buffer
+static uint next_line_buffer;
+
+// Beam state for scanout_push_copper()
+static copper_t copper;
+
+#if TMDS_CACHE
+// Encode the three channels of a line the way libdvi's dvi_scanbuf_main_16bpp() does
+static void __not_in_flash_func(encode_line)(const uint16_t* line, uint32_t* tmds)
+{
+    const uint pixwidth = scanout_dvi->timing->h_active_pixels;
+    const uint words_per_channel = pixwidth / DVI_SYMBOLS_PER_WORD;
+    const uint32_t* pixels = (const uint32_t*)line;
+    tmds_encode_data_channel_16bpp(pixels, tmds + 0 * words_per_channel, pixwidth / 2, DVI_16BPP_BLUE_MSB,
+                                   DVI_16BPP_BLUE_LSB);
+    tmds_encode_data_channel_16bpp(pixels, tmds + 1 * words_per_channel, pixwidth / 2, DVI_16BPP_GREEN_MSB,
+                                   DVI_16BPP_GREEN_LSB);
+    tmds_encode_data_channel_16bpp(pixels, tmds + 2 * words_per_channel, pixwidth / 2, DVI_16BPP_RED_MSB,
+                                   DVI_16BPP_RED_LSB);
+}
+#endif
+
+void scanout_init(struct dvi_inst* inst)
+{
+    scanout_dvi = inst;
+    lines_queued = 0;
+    lines_returned = 0;
+    next_line_buffer = 0;
+    memset(line_buffer_release, 0, sizeof(line_buffer_release));
+    copper_init(&copper, FRAME_WIDTH);
+
+#if TMDS_CACHE
+    tmds_cache_init(&tmds_cache, tmds_cache_pixels, tmds_cache_symbols, SCANLINE_WIDTH, TMDS_CACHE_LINE_WORDS,
+                    encode_line);
+    memset(&tmds_cache_reported, 0, sizeof(tmds_cache_reported));
+    tmds_cache_report_lines = 0;
+#endif
+
+#if FRAME_CRC
+    frame_crc_init();
+    frame_crc_begin(&frame_sig);
+    signed_frames = 0;
+    reported_frames = 0;
+#endif
+
+#if SCANOUT_STATS
+    // Each queued line is shown DVI_VERTICAL_REPEAT times by libdvi
+    const struct dvi_timing* t = inst->timing;
+    const uint32_t h_total = t->h_front_porch + t->h_sync_width + t->h_back_porch + t->h_active_pixels;
+    line_period_ns = (uint32_t)((uint64_t)h_total * 10000000u * DVI_VERTICAL_REPEAT / t->bit_clk_khz);
+    scanout_stats_reset(&stats);
+    late_scanlines_base = inst->late_scanline_ctr;
+#endif
+}
+
+static void reclaim_lines(void)
+{
+#if SCANOUT_STATS
+    scanout_stats_reclaim(&stats, queue_get_level(&scanout_dvi->q_colour_free));
+#endif
+    const uint16_t* line;
+    while (queue_try_remove_u32(&scanout_dvi->q_colour_free, &line))
+    {
+        ++lines_returned;
+    }
+}
+
+#if FRAME_CRC
+// Add a line to the frame signature, as it is queued and before any widening
+static void sign_line(const uint16_t* line)
+{
+    frame_crc_line(&frame_sig, line, FRAME_WIDTH);
+    if (frame_sig.lines == FRAME_HEIGHT)
+    {
+        last_crc = frame_crc_end(&frame_sig);
+        ++signed_frames;
+        frame_crc_begin(&frame_sig);
+    }
+}
+#endif
+
+static void queue_line(const uint16_t* line)
+{
+#if SCANOUT_STATS
+    scanout_stats_line(&stats, queue_get_level(&scanout_dvi->q_colour_valid));
+#endif
+    queue_add_blocking_u32(&scanout_dvi->q_colour_valid, &line);
+    ++lines_queued;
+#if SCANOUT_STATS
+    if (lines_queued % (FRAME_HEIGHT * FRAME_V_REPEAT) == 0)
+        scanout_stats_frame(&stats);
+#endif
+    reclaim_lines();
+}
+
+// Return the next line buffer, waiting until core 1 is done with its previous contents.
+// The caller renders FRAME_WIDTH pixels into it and hands it back with scanout_commit_line().
+uint16_t* scanout_acquire_line(void)
+{
+    const uint index = next_line_buffer;
+    next_line_buffer = (next_line_buffer + 1) % SCANOUT_LINE_BUFFERS;
+
+    while ((int32_t)(lines_returned - line_buffer_release[index]) < 0)
+    {
+        const uint16_t* returned;
+        queue_remove_blocking_u32(&scanout_dvi->q_colour_free, &returned);
+        ++lines_returned;
+    }
+    line_buffer_release[index] = lines_queued + FRAME_V_REPEAT;
+    return line_buffers[index];
+}
+
+void scanout_commit_line(uint16_t* line)
+{
+#if FRAME_CRC
+    sign_line(line);
+#endif
+#if FRAME_H_REPEAT > 1
+    // Widen in place from the end, writing each pixel twice with a single word store
+    uint32_t* dst = (uint32_t*)line;
+    for (int x = FRAME_WIDTH - 1; x >= 0; --x)
+    {
+        dst[x] = line[x] * 0x00010001u;
+    }
+#endif
+    for (uint i = 0; i < FRAME_V_REPEAT; ++i)
+    {
+        queue_line(line);
+    }
+}
+
+void scanout_push_line(const uint16_t* line)
+{
+#if FRAME_H_REPEAT > 1
+    uint16_t* buffer = scanout_acquire_line();
+    memcpy(buffer, line, FRAME_WIDTH * sizeof(uint16_t));
+    scanout_commit_line(buffer);
+#else
+    for (uint i = 0; i < FRAME_V_REPEAT; ++i)
+    {
+        queue_line(line);
+    }
+#if FRAME_CRC
+    // Core 1 only reads the line, so sign it while it waits in the queue
+    sign_line(line);
+#endif
+#endif
+}
+
+void scanout_push_frame(const uint16_t* framebuffer)
+{
+    for (uint y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        scanout_push_line(&framebuffer[y * FRAME_WIDTH]);
+        if (line_poll && y % SCANOUT_POLL_LINES == SCANOUT_POLL_LINES - 1)
+        {
+            line_poll();
+        }
+    }
+}
+
+// Push a frame whose lines are anywhere in memory, one pointer per line, such as a scrolling
+// framebuffer (see scroll_ring.h)
+void scanout_push_lines(const uint16_t* const* lines)
+{
+    for (uint y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        scanout_push_line(lines[y]);
+        if (line_poll && y % SCANOUT_POLL_LINES == SCANOUT_POLL_LINES - 1)
+        {
+            line_poll();
+        }
+    }
+}
+
+// Push a frame through a copper list (see copper.h), sorted by line. Lines the list leaves
+// alone are queued straight from their source, the others are built in a line buffer.
+void scanout_push_copper(const uint16_t* framebuffer, const copper_command_t* commands, uint32_t count)
+{
+    copper_begin_frame(&copper, framebuffer, FRAME_HEIGHT, commands, count);
+    for (uint y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        if (copper_line(&copper, y))
+        {
+            scanout_push_line(copper.row);
+        }
+        else
+        {
+            uint16_t* line = scanout_acquire_line();
+            copper_build_line(&copper, line);
+            scanout_commit_line(line);
+        }
+        if (line_poll && y % SCANOUT_POLL_LINES == SCANOUT_POLL_LINES - 1)
+        {
+            line_poll();
+        }
+    }
+}
+
+// Run poll every SCANOUT_POLL_LINES lines of scanout_push_frame(), or never if NULL. It runs
+// while core 1 works through the queued lines, so it has to return well within the time the
+// line queue lasts.
+void scanout_set_line_poll(void (*poll)(void))
+{
+    line_poll = poll;
+}
+
+// Sequence numbers for timing individual lines: a line queued when scanout_lines_queued()
+// returned n has been encoded by core 1 once scanout_lines_returned() is past n
+uint32_t scanout_lines_queued(void)
+{
+    return lines_queued;
+}
+
+uint32_t scanout_lines_returned(void)
+{
+    reclaim_lines();
+    return lines_returned;
+}
+
+#if SCANOUT_STATS
+void scanout_get_stats(scanout_stats_t* out)
+{
+    *out = stats;
+    out->late_scanlines = scanout_dvi->late_scanline_ctr - late_scanlines_base;
+}
+
+void scanout_reset_stats(void)
+{
+    scanout_stats_reset(&stats);
+    late_scanlines_base = scanout_dvi->late_scanline_ctr;
+}
+
+uint32_t scanout_line_period_ns(void)
+{
+    return line_period_ns;
+}
+
+// Call between frames. Prints and restarts the statistics every SCANOUT_STATS_REPORT_FRAMES
+// frames. The printf itself delays the next frame, so it shows up in the following report.
+void scanout_poll_stats(void)
+{
+    if (stats.frames < SCANOUT_STATS_REPORT_FRAMES)
+        return;
+
+    scanout_stats_t report;
+    scanout_get_stats(&report);
+    scanout_reset_stats();
+    scanout_stats_print(&report, line_period_ns);
+}
+#endif
+
+#if FRAME_CRC
+// Number and signature of the last frame queued in full. Returns false before the first one.
+bool scanout_frame_crc(uint32_t* frame, uint32_t* crc)
+{
+    if (signed_frames == 0)
+        return false;
+    *frame = signed_frames - 1;
+    *crc = last_crc;
+    return true;
+}
+
+// Call between frames. Prints the signature of every new frame as "CRC <frame> <crc>", the
+// format of the golden files checked by tools/golden_frames, so a log can be compared with them.
+void scanout_poll_crc(void)
+{
+    uint32_t frame, crc;
+    if (!scanout_frame_crc(&frame, &crc) || signed_frames == reported_frames)
+        return;
+
+    if (signed_frames - reported_frames > 1)
+        printf("CRC skipped %lu frames\r\n", (unsigned long)(signed_frames - reported_frames - 1));
+    printf("CRC %lu %08lx\r\n", (unsigned long)frame, (unsigned long)crc);
+    reported_frames = signed_frames;
+}
+#endif
+
+#if TMDS_CACHE
+// Core 1 loop in place of dvi_scanbuf_main_16bpp(). Lines are sent from the TMDS cache instead of
+// libdvi's own TMDS buffers, which are left unused. Buffers come back on q_tmds_free once the
+// DMA has sent them, and as in libdvi at most DVI_N_TMDS_BUFFERS lines are queued at a time.
+void __not_in_flash_func(scanout_tmds_cache_main)(struct dvi_inst* inst)
+{
+    uint in_flight = 0;
+    while (true)
+    {
+        const uint16_t* line;
+        queue_remove_blocking_u32(&inst->q_colour_valid, &line);
+
+        const uint32_t* sent;
+        while (queue_try_remove_u32(&inst->q_tmds_free, &sent))
+        {
+            in_flight -= tmds_cache_release(&tmds_cache, sent);
+        }
+        while (in_flight >= DVI_N_TMDS_BUFFERS)
+        {
+            queue_remove_blocking_u32(&inst->q_tmds_free, &sent);
+            in_flight -= tmds_cache_release(&tmds_cache, sent);
+        }
+
+        uint32_t* tmds = tmds_cache_get(&tmds_cache, line);
+        ++in_flight;
+        queue_add_blocking_u32(&inst->q_tmds_valid, &tmds);
+        queue_add_blocking_u32(&inst->q_colour_free, &line);
+    }
+}
+
+void scanout_get_tmds_cache_stats(tmds_cache_stats_t* out)
+{
+    *out = *(const tmds_cache_stats_t*)&tmds_cache.stats;
+}
+
+// Call between frames. Prints the hit rate over the last SCANOUT_STATS_REPORT_FRAMES frames.
+void scanout_poll_tmds_cache(void)
+{
+    const uint32_t frame_lines = FRAME_HEIGHT * FRAME_V_REPEAT;
+    if (lines_queued - tmds_cache_report_lines < SCANOUT_STATS_REPORT_FRAMES * frame_lines)
+        return;
+
+    tmds_cache_stats_t now, period;
+    scanout_get_tmds_cache_stats(&now);
+    period.lines = now.lines - tmds_cache_reported.lines;
+    period.hits = now.hits - tmds_cache_reported.hits;
+    period.evictions = now.evictions - tmds_cache_reported.evictions;
+    tmds_cache_print(&period, (lines_queued - tmds_cache_report_lines) / frame_lines);
+    tmds_cache_reported = now;
+    tmds_cache_report_lines = lines_queued;
+}
+#endif
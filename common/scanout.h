@@ -0,0 +1,96 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SCANOUT_H
+#define SCANOUT_H
+
+#include "copper.h"
+#include "display_mode.h"
+#include "dvi.h"
+#include "frame_crc.h"
+#include "scanout_stats.h"
+#include "tmds_cache.h"
+
+// Number of line buffers for lines rendered just in time or widened when FRAME_H_REPEAT > 1
+#ifndef SCANOUT_LINE_BUFFERS
+#define SCANOUT_LINE_BUFFERS 2
+#endif
+
+// Lines pushed by scanout_push_frame() between calls to the line poll function
+#ifndef SCANOUT_POLL_LINES
+#define SCANOUT_POLL_LINES 16
+#endif
+
+// Queue occupancy and slack statistics, enabled with -DSCANOUT_STATS=ON. See scanout_stats.h.
+#ifndef SCANOUT_STATS
+#define SCANOUT_STATS 0
+#endif
+
+// Frames between statistics reports from scanout_poll_stats()
+#ifndef SCANOUT_STATS_REPORT_FRAMES
+#define SCANOUT_STATS_REPORT_FRAMES 600
+#endif
+
+// Frame signatures, enabled with -DFRAME_CRC=ON. See frame_crc.h.
+#ifndef FRAME_CRC
+#define FRAME_CRC 0
+#endif
+
+// Cache of TMDS-encoded lines on core 1, enabled with -DTMDS_CACHE=ON. See tmds_cache.h.
+#ifndef TMDS_CACHE
+#define TMDS_CACHE 0
+#endif
+
+// Function declarations
+void scanout_init(struct dvi_inst* inst);
+void scanout_push_line(const uint16_t* line);
+void scanout_push_frame(const uint16_t* framebuffer);
+void scanout_push_lines(const uint16_t* const* lines);
+void scanout_push_copper(const uint16_t* framebuffer, const copper_command_t* commands, uint32_t count);
+void scanout_set_line_poll(void (*poll)(void));
+uint16_t* scanout_acquire_line(void);
+void scanout_commit_line(uint16_t* line);
+uint32_t scanout_lines_queued(void);
+uint32_t scanout_lines_returned(void);
+
+#if SCANOUT_STATS
+void scanout_get_stats(scanout_stats_t* stats);
+void scanout_reset_stats(void);
+uint32_t scanout_line_period_ns(void);
+void scanout_poll_stats(void);
+#endif
+
+#if FRAME_CRC
+bool scanout_frame_crc(uint32_t* frame, uint32_t* crc);
+void scanout_poll_crc(void);
+#endif
+
+#if TMDS_CACHE
+void scanout_tmds_cache_main(struct dvi_inst* inst);
+void scanout_get_tmds_cache_stats(tmds_cache_stats_t* stats);
+void scanout_poll_tmds_cache(void);
+#endif
+
+#endif // SCANOUT_H
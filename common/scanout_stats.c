@@ -0,0 +1,101 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "scanout_stats.h"
+
+static inline uint32_t bucket(uint32_t level)
+{
+    return level < SCANOUT_STATS_MAX_LEVEL ? level : SCANOUT_STATS_MAX_LEVEL;
+}
+
+void scanout_stats_reset(scanout_stats_t* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->min_slack = UINT32_MAX;
+    stats->current_frame_slack = UINT32_MAX;
+}
+
+void scanout_stats_line(scanout_stats_t* stats, uint32_t valid_level)
+{
+    ++stats->lines;
+    ++stats->valid_level[bucket(valid_level)];
+    stats->total_slack += valid_level;
+    if (valid_level == 0)
+        ++stats->empty_queue;
+    if (valid_level < stats->min_slack)
+        stats->min_slack = valid_level;
+    if (valid_level < stats->current_frame_slack)
+        stats->current_frame_slack = valid_level;
+}
+
+void scanout_stats_reclaim(scanout_stats_t* stats, uint32_t free_level)
+{
+    ++stats->free_level[bucket(free_level)];
+}
+
+// Called after the last line of every frame has been queued
+void scanout_stats_frame(scanout_stats_t* stats)
+{
+    ++stats->frames;
+    if (stats->current_frame_slack != UINT32_MAX)
+        ++stats->frame_slack[bucket(stats->current_frame_slack)];
+    stats->current_frame_slack = UINT32_MAX;
+}
+
+static void print_histogram(const char* name, const uint32_t* histogram)
+{
+    printf("  %s:", name);
+    for (int i = 0; i <= SCANOUT_STATS_MAX_LEVEL; ++i)
+    {
+        if (histogram[i])
+            printf(" %d%s=%lu", i, i == SCANOUT_STATS_MAX_LEVEL ? "+" : "", (unsigned long)histogram[i]);
+    }
+    printf("\r\n");
+}
+
+// Slack is printed in lines and in microseconds, with line_period_ns the time core 1 takes
+// to consume one queued line
+void scanout_stats_print(const scanout_stats_t* stats, uint32_t line_period_ns)
+{
+    if (stats->lines == 0)
+    {
+        printf("Scanout: no lines\r\n");
+        return;
+    }
+
+    const uint32_t mean_x10 = (uint32_t)(stats->total_slack * 10 / stats->lines);
+    printf("Scanout: %lu frames, %lu lines, %lu queued into an empty queue, %lu late scanlines\r\n",
+           (unsigned long)stats->frames, (unsigned long)stats->lines, (unsigned long)stats->empty_queue,
+           (unsigned long)stats->late_scanlines);
+    printf("  slack: min %lu lines (%lu us), mean %lu.%lu lines (%lu us)\r\n", (unsigned long)stats->min_slack,
+           (unsigned long)(stats->min_slack * line_period_ns / 1000), (unsigned long)(mean_x10 / 10),
+           (unsigned long)(mean_x10 % 10), (unsigned long)((uint64_t)mean_x10 * line_period_ns / 10000));
+    print_histogram("valid queue", stats->valid_level);
+    print_histogram("free queue", stats->free_level);
+    print_histogram("frame min slack", stats->frame_slack);
+}
@@ -0,0 +1,65 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SCANOUT_STATS_H
+#define SCANOUT_STATS_H
+
+#include <stdint.h>
+
+// Scanline queue statistics.
+//
+// Every time a line is queued for core 1, the number of lines already waiting in
+// q_colour_valid is recorded. That number is the line's slack: how many scanline periods
+// ahead of being needed it was queued. A line queued into an empty queue means core 1 may
+// have been starved, which libdvi shows by repeating a line and counting it in
+// late_scanline_ctr. The occupancy of q_colour_free is sampled whenever returned lines are
+// reclaimed. This file is portable so the same accounting runs against the simulated
+// consumer in tools/scanout_sim.
+
+// Occupancy histogram buckets, deeper levels count in the last bucket
+#define SCANOUT_STATS_MAX_LEVEL 16
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t lines;
+    uint32_t valid_level[SCANOUT_STATS_MAX_LEVEL + 1]; // q_colour_valid occupancy as each line was queued
+    uint32_t free_level[SCANOUT_STATS_MAX_LEVEL + 1];  // q_colour_free occupancy when lines were reclaimed
+    uint32_t frame_slack[SCANOUT_STATS_MAX_LEVEL + 1]; // Smallest slack of each frame, in lines
+    uint32_t empty_queue;                              // Lines queued while core 1 had nothing left
+    uint32_t min_slack;                                // Smallest slack of any line, in lines
+    uint64_t total_slack;
+    uint32_t late_scanlines; // Reported by libdvi, filled in by the firmware
+    uint32_t current_frame_slack;
+} scanout_stats_t;
+
+// Function declarations
+void scanout_stats_reset(scanout_stats_t* stats);
+void scanout_stats_line(scanout_stats_t* stats, uint32_t valid_level);
+void scanout_stats_reclaim(scanout_stats_t* stats, uint32_t free_level);
+void scanout_stats_frame(scanout_stats_t* stats);
+void scanout_stats_print(const scanout_stats_t* stats, uint32_t line_period_ns);
+
+#endif // SCANOUT_STATS_H
@@ -0,0 +1,153 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "scroll_ring.h"
+
+static void update_lines(scroll_ring_t* ring)
+{
+    uint32_t start = ring->origin;
+    for (uint32_t y = 0; y < ring->height; ++y)
+    {
+        ring->lines[y] = &ring->pixels[start];
+        start += ring->width;
+        if (start >= ring->size)
+            start -= ring->size;
+    }
+}
+
+void scroll_ring_init(scroll_ring_t* ring, uint16_t* pixels, const uint16_t** lines, uint16_t width,
+                      uint16_t height)
+{
+    ring->pixels = pixels;
+    ring->lines = lines;
+    ring->width = width;
+    ring->height = height;
+    ring->size = (uint32_t)width * height;
+    ring->origin = 0;
+    ring->scroll_x = 0;
+    ring->scroll_y = 0;
+    update_lines(ring);
+}
+
+// Fill count pixels from ring address start, keeping the mirrored first line in step
+static void fill_span(scroll_ring_t* ring, uint32_t start, uint32_t count, uint16_t colour)
+{
+    uint16_t* pixels = ring->pixels;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        pixels[start + i] = colour;
+    }
+    if (start < ring->width)
+    {
+        const uint32_t mirrored = start + count < ring->width ? count : ring->width - start;
+        for (uint32_t i = 0; i < mirrored; ++i)
+        {
+            pixels[ring->size + start + i] = colour;
+        }
+    }
+}
+
+// Fill a rectangle in screen coordinates, clipped to the screen
+void scroll_ring_fill(scroll_ring_t* ring, int x, int y, int width, int height, uint16_t colour)
+{
+    if (x < 0)
+    {
+        width += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        height += y;
+        y = 0;
+    }
+    if (x + width > ring->width)
+        width = ring->width - x;
+    if (y + height > ring->height)
+        height = ring->height - y;
+    if (width <= 0 || height <= 0)
+        return;
+
+    for (int row = y; row < y + height; ++row)
+    {
+        // A screen line can wrap around the end of the ring
+        const uint32_t start = (uint32_t)(ring->lines[row] - ring->pixels) + x;
+        if (start >= ring->size)
+        {
+            fill_span(ring, start - ring->size, width, colour);
+        }
+        else if (start + width > ring->size)
+        {
+            fill_span(ring, start, ring->size - start, colour);
+            fill_span(ring, 0, start + width - ring->size, colour);
+        }
+        else
+        {
+            fill_span(ring, start, width, colour);
+        }
+    }
+}
+
+// Move the screen to a new world position. Only the origin and the line table change; redraw is
+// called for the strips along the edges that scrolled into view.
+void scroll_ring_scroll_to(scroll_ring_t* ring, int32_t scroll_x, int32_t scroll_y, scroll_ring_redraw_t redraw,
+                           void* user)
+{
+    const int32_t dx = scroll_x - ring->scroll_x;
+    const int32_t dy = scroll_y - ring->scroll_y;
+    if (dx == 0 && dy == 0)
+        return;
+
+    const int64_t shift = (int64_t)dy * ring->width + dx;
+    int64_t origin = ((int64_t)ring->origin + shift) % ring->size;
+    if (origin < 0)
+        origin += ring->size;
+    ring->origin = (uint32_t)origin;
+    ring->scroll_x = scroll_x;
+    ring->scroll_y = scroll_y;
+    update_lines(ring);
+
+    const int w = ring->width;
+    const int h = ring->height;
+    if (dx >= w || -dx >= w || dy >= h || -dy >= h)
+    {
+        redraw(ring, 0, 0, w, h, user);
+        return;
+    }
+
+    // Columns that came in on the left or right. Moving the origin sideways also shifts the
+    // whole image by one line at the wrap, which is exactly these columns.
+    if (dx > 0)
+        redraw(ring, w - dx, 0, dx, h, user);
+    else if (dx < 0)
+        redraw(ring, 0, 0, -dx, h, user);
+
+    // Lines that came in at the top or bottom, less the corner already redrawn
+    const int x = dx < 0 ? -dx : 0;
+    const int width = w - (dx < 0 ? -dx : dx);
+    if (dy > 0)
+        redraw(ring, x, h - dy, width, dy, user);
+    else if (dy < 0)
+        redraw(ring, x, 0, width, -dy, user);
+}
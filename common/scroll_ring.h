@@ -0,0 +1,67 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SCROLL_RING_H
+#define SCROLL_RING_H
+
+#include <stdint.h>
+
+// Scrolling framebuffer addressed through a scanline pointer table.
+//
+// The screen is a window onto a larger world. Its pixels live in a ring of width * height
+// pixels where screen pixel (x, y) is at (origin + y * width + x) modulo the ring size. Scrolling
+// by (dx, dy) only moves the origin by dy * width + dx: every pixel still on screen keeps its
+// address, and the addresses of pixels that scrolled off are exactly those of the strips that
+// scrolled in, which the caller redraws. A line is width contiguous pixels from its start
+// address; one more line after the ring mirrors the first, so a line that runs past the end of
+// the ring can still be read in one piece. Lines are queued straight from the pointer table,
+// so scrolling never copies the framebuffer.
+//
+// libdvi reads 16bpp lines a word at a time, so with lines scanned out directly the width and
+// every horizontal scroll step have to be even to keep the line pointers word aligned.
+
+typedef struct
+{
+    uint16_t* pixels; // width * (height + 1) pixels, the last line mirrors the first
+    uint16_t width;
+    uint16_t height;
+    uint32_t size;   // width * height
+    uint32_t origin; // Ring address of screen pixel (0, 0)
+    int32_t scroll_x; // World position of screen pixel (0, 0)
+    int32_t scroll_y;
+    const uint16_t** lines; // Start of every screen line, height entries
+} scroll_ring_t;
+
+// Called with a screen rectangle whose contents are stale after a scroll
+typedef void (*scroll_ring_redraw_t)(scroll_ring_t* ring, int x, int y, int width, int height, void* user);
+
+// Function declarations
+void scroll_ring_init(scroll_ring_t* ring, uint16_t* pixels, const uint16_t** lines, uint16_t width,
+                      uint16_t height);
+void scroll_ring_fill(scroll_ring_t* ring, int x, int y, int width, int height, uint16_t colour);
+void scroll_ring_scroll_to(scroll_ring_t* ring, int32_t scroll_x, int32_t scroll_y, scroll_ring_redraw_t redraw,
+                           void* user);
+
+#endif // SCROLL_RING_H
@@ -0,0 +1,138 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tmds_cache.h"
+
+// Runs on core 1 once per line, keep it out of flash on the Pico
+#if PICO_ON_DEVICE
+#include "pico.h"
+#define CACHE_FUNC(name) __not_in_flash_func(name)
+#else
+#define CACHE_FUNC(name) name
+#endif
+
+// pixels holds TMDS_CACHE_ENTRIES lines of line_pixels and tmds TMDS_CACHE_ENTRIES buffers of
+// tmds_words, both word aligned
+void tmds_cache_init(tmds_cache_t* cache, uint16_t* pixels, uint32_t* tmds, uint32_t line_pixels, uint32_t tmds_words,
+                     tmds_cache_encode_t encode)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->line_pixels = line_pixels;
+    cache->tmds_words = tmds_words;
+    cache->encode = encode;
+    for (uint32_t i = 0; i < TMDS_CACHE_ENTRIES; ++i)
+    {
+        cache->entries[i].pixels = &pixels[i * line_pixels];
+        cache->entries[i].tmds = &tmds[i * tmds_words];
+    }
+}
+
+// FNV-1a over the line's words
+static uint32_t CACHE_FUNC(hash_line)(const uint16_t* line, uint32_t pixels)
+{
+    const uint32_t* words = (const uint32_t*)line;
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < pixels / 2; ++i)
+    {
+        hash = (hash ^ words[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool CACHE_FUNC(same_line)(const uint16_t* a, const uint16_t* b, uint32_t pixels)
+{
+    const uint32_t* wa = (const uint32_t*)a;
+    const uint32_t* wb = (const uint32_t*)b;
+    for (uint32_t i = 0; i < pixels / 2; ++i)
+    {
+        if (wa[i] != wb[i])
+            return false;
+    }
+    return true;
+}
+
+// Return the encoded symbols for line, encoding it into the least recently used entry that is
+// not being sent if it is not cached. The entry counts as in flight until tmds_cache_release().
+// There must be more entries than lines in flight.
+uint32_t* CACHE_FUNC(tmds_cache_get)(tmds_cache_t* cache, const uint16_t* line)
+{
+    const uint32_t hash = hash_line(line, cache->line_pixels);
+    tmds_cache_entry_t* victim = NULL;
+    ++cache->clock;
+    ++cache->stats.lines;
+
+    for (uint32_t i = 0; i < TMDS_CACHE_ENTRIES; ++i)
+    {
+        tmds_cache_entry_t* entry = &cache->entries[i];
+        if (entry->valid && entry->hash == hash && same_line(entry->pixels, line, cache->line_pixels))
+        {
+            ++cache->stats.hits;
+            entry->last_used = cache->clock;
+            ++entry->in_flight;
+            return entry->tmds;
+        }
+        if (entry->in_flight == 0 && (victim == NULL || !entry->valid ||
+                                      (victim->valid && entry->last_used < victim->last_used)))
+            victim = entry;
+    }
+
+    if (victim->valid)
+        ++cache->stats.evictions;
+    memcpy(victim->pixels, line, cache->line_pixels * sizeof(uint16_t));
+    cache->encode(line, victim->tmds);
+    victim->hash = hash;
+    victim->valid = true;
+    victim->last_used = cache->clock;
+    victim->in_flight = 1;
+    return victim->tmds;
+}
+
+// The DMA is done with a buffer returned by tmds_cache_get(). Returns false if it is not one of
+// the cache's buffers.
+bool CACHE_FUNC(tmds_cache_release)(tmds_cache_t* cache, const uint32_t* tmds)
+{
+    for (uint32_t i = 0; i < TMDS_CACHE_ENTRIES; ++i)
+    {
+        if (cache->entries[i].tmds == tmds)
+        {
+            --cache->entries[i].in_flight;
+            return true;
+        }
+    }
+    return false;
+}
+
+void tmds_cache_print(const tmds_cache_stats_t* stats, uint32_t frames)
+{
+    const uint32_t misses = stats->lines - stats->hits;
+    printf("TMDS cache: %lu lines, %lu.%lu%% hits, %lu encoded per frame, %lu evictions, %u entries\r\n",
+           (unsigned long)stats->lines, (unsigned long)(stats->lines ? stats->hits * 100ull / stats->lines : 0),
+           (unsigned long)(stats->lines ? stats->hits * 1000ull / stats->lines % 10 : 0),
+           (unsigned long)(frames ? misses / frames : 0), (unsigned long)stats->evictions, TMDS_CACHE_ENTRIES);
+}
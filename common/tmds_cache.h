@@ -0,0 +1,87 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef TMDS_CACHE_H
+#define TMDS_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Cache of TMDS-encoded scanlines.
+//
+// Core 1 normally encodes every line it is given. Most lines are the same from one frame to the
+// next, and many are the same as their neighbours: empty playfield rows, the eight rows of a
+// cell, the black rows around frameDisplay's digits. The cache keeps the encoded symbols of
+// recently seen lines together with a copy of their pixels. A line that matches an entry is
+// sent from that entry, and only new lines are encoded. Entries are found by a hash of the
+// pixels and confirmed by comparing the copy, so a hit never changes the output. Entries the
+// DMA is still sending are never evicted.
+//
+// This file is portable. The libdvi core 1 loop that uses it is scanout_tmds_cache_main().
+
+// Cached lines. Each takes the TMDS buffer (three channels of SCANLINE_WIDTH words) plus a copy
+// of the line, about 4.4 KB at 320x240. There must be more than libdvi's DVI_N_TMDS_BUFFERS.
+#ifndef TMDS_CACHE_ENTRIES
+#define TMDS_CACHE_ENTRIES 8
+#endif
+
+// Encodes a line of pixels into TMDS symbols
+typedef void (*tmds_cache_encode_t)(const uint16_t* line, uint32_t* tmds);
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t last_used;
+    uint16_t in_flight; // Times queued to the DMA and not yet returned
+    bool valid;
+    uint16_t* pixels;
+    uint32_t* tmds;
+} tmds_cache_entry_t;
+
+typedef struct
+{
+    uint32_t lines;
+    uint32_t hits;
+    uint32_t evictions; // Misses that replaced a valid entry
+} tmds_cache_stats_t;
+
+typedef struct
+{
+    tmds_cache_entry_t entries[TMDS_CACHE_ENTRIES];
+    uint32_t line_pixels;
+    uint32_t tmds_words;
+    tmds_cache_encode_t encode;
+    uint32_t clock;
+    volatile tmds_cache_stats_t stats;
+} tmds_cache_t;
+
+// Function declarations
+void tmds_cache_init(tmds_cache_t* cache, uint16_t* pixels, uint32_t* tmds, uint32_t line_pixels, uint32_t tmds_words,
+                     tmds_cache_encode_t encode);
+uint32_t* tmds_cache_get(tmds_cache_t* cache, const uint16_t* line);
+bool tmds_cache_release(tmds_cache_t* cache, const uint32_t* tmds);
+void tmds_cache_print(const tmds_cache_stats_t* stats, uint32_t frames);
+
+#endif // TMDS_CACHE_H
@@ -0,0 +1,342 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if PICO_ON_DEVICE
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#endif
+
+#include "mem_report.h"
+#include "uart_command.h"
+
+#if UART_COMMAND_RX_BUFFER & (UART_COMMAND_RX_BUFFER - 1)
+#error "UART_COMMAND_RX_BUFFER must be a power of two"
+#endif
+#if UART_COMMAND_QUEUE & (UART_COMMAND_QUEUE - 1)
+#error "UART_COMMAND_QUEUE must be a power of two"
+#endif
+
+static uart_inst_t* command_uart;
+static const uart_command_t* app_commands;
+static uint32_t app_command_count;
+
+// Written by the interrupt at head, read by uart_command_poll() at tail. Both only ever grow,
+// so head - tail is the number of bytes waiting.
+static uint8_t rx_ring[UART_COMMAND_RX_BUFFER];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+
+// The line being received
+static char line[UART_COMMAND_MAX_LINE + 1];
+static uint32_t line_len;
+static bool line_too_long;
+
+typedef enum
+{
+    LINE_COMMAND,
+    LINE_TOO_LONG,
+    LINE_LOST // Stands in for the lines that arrived while the queue was full
+} line_kind_t;
+
+typedef struct
+{
+    uint8_t kind;
+    uint32_t lost;
+    char text[UART_COMMAND_MAX_LINE + 1];
+} queued_line_t;
+
+// Complete lines waiting to run, added at queue_head and run from queue_tail like the ring
+static queued_line_t queue[UART_COMMAND_QUEUE];
+static uint32_t queue_head;
+static uint32_t queue_tail;
+
+static volatile uart_command_stats_t stats;
+
+static uint32_t ring_put(uint32_t head, uint8_t c)
+{
+    ++stats.bytes;
+    if (head - rx_tail < UART_COMMAND_RX_BUFFER)
+        rx_ring[head++ % UART_COMMAND_RX_BUFFER] = c;
+    else
+        ++stats.dropped;
+    return head;
+}
+
+static void ring_update(uint32_t head)
+{
+    rx_head = head;
+    if (head - rx_tail > stats.max_fill)
+        stats.max_fill = head - rx_tail;
+}
+
+#if PICO_ON_DEVICE
+static void on_uart_rx(void)
+{
+    uart_hw_t* hw = uart_get_hw(command_uart);
+    uint32_t head = rx_head;
+
+    while (uart_is_readable(command_uart))
+    {
+        const uint32_t data = hw->dr;
+        if (data & UART_UARTDR_OE_BITS)
+            ++stats.fifo_overruns;
+        head = ring_put(head, (uint8_t)data);
+    }
+
+    ring_update(head);
+}
+#else
+// Host builds have no UART: data goes into the ring as the interrupt would have put it
+void uart_command_receive(const void* data, uint32_t length)
+{
+    uint32_t head = rx_head;
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        head = ring_put(head, ((const uint8_t*)data)[i]);
+    }
+    ring_update(head);
+}
+#endif
+
+static bool command_help(int argc, char** argv);
+
+static bool command_mem(int argc, char** argv)
+{
+    mem_report_print();
+    return true;
+}
+
+static const uart_command_t builtin_commands[] = {
+    {"help", "", command_help},
+    {"mem", "", command_mem},
+    {"m", "", command_mem},
+};
+
+static void print_commands(const uart_command_t* commands, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        printf("  %s %s\r\n", commands[i].name, commands[i].usage);
+    }
+}
+
+static bool command_help(int argc, char** argv)
+{
+    print_commands(builtin_commands, sizeof(builtin_commands) / sizeof(builtin_commands[0]));
+    print_commands(app_commands, app_command_count);
+    return true;
+}
+
+static const uart_command_t* find_command(const char* name)
+{
+    for (uint32_t i = 0; i < app_command_count; ++i)
+    {
+        if (strcmp(app_commands[i].name, name) == 0)
+            return &app_commands[i];
+    }
+    for (uint32_t i = 0; i < sizeof(builtin_commands) / sizeof(builtin_commands[0]); ++i)
+    {
+        if (strcmp(builtin_commands[i].name, name) == 0)
+            return &builtin_commands[i];
+    }
+    return NULL;
+}
+
+static void run_line(char* text)
+{
+    char* argv[UART_COMMAND_MAX_ARGS];
+    int argc = 0;
+    for (char* word = strtok(text, " \t"); word != NULL; word = strtok(NULL, " \t"))
+    {
+        if (argc == UART_COMMAND_MAX_ARGS)
+        {
+            ++stats.errors;
+            printf("ERR too many arguments\r\n");
+            return;
+        }
+        argv[argc++] = word;
+    }
+    if (argc == 0)
+        return;
+
+    const uart_command_t* command = find_command(argv[0]);
+    if (command == NULL)
+    {
+        ++stats.errors;
+        printf("ERR unknown command %s, try help\r\n", argv[0]);
+    }
+    else if (!command->handler(argc, argv))
+    {
+        ++stats.errors;
+        printf("ERR usage: %s %s\r\n", command->name, command->usage);
+    }
+    else
+    {
+        ++stats.commands;
+        printf("OK\r\n");
+    }
+}
+
+// Start receiving commands on uart, which must already be set up. The application's commands
+// are looked up before the built-in ones.
+void uart_command_init(uart_inst_t* uart, const uart_command_t* commands, uint32_t count)
+{
+    command_uart = uart;
+    app_commands = commands;
+    app_command_count = count;
+    rx_head = 0;
+    rx_tail = 0;
+    line_len = 0;
+    line_too_long = false;
+    queue_head = 0;
+    queue_tail = 0;
+
+#if PICO_ON_DEVICE
+    const uint irq = uart == uart0 ? UART0_IRQ : UART1_IRQ;
+    irq_set_exclusive_handler(irq, on_uart_rx);
+    irq_set_enabled(irq, true);
+    uart_set_irq_enables(uart, true, false);
+#endif
+}
+
+static void queue_line(line_kind_t kind)
+{
+    const uint32_t waiting = queue_head - queue_tail;
+    if (waiting == UART_COMMAND_QUEUE)
+    {
+        // The last slot already stands in for lost lines
+        ++queue[(queue_head - 1) % UART_COMMAND_QUEUE].lost;
+        ++stats.lost;
+        return;
+    }
+
+    queued_line_t* entry = &queue[queue_head++ % UART_COMMAND_QUEUE];
+    if (waiting == UART_COMMAND_QUEUE - 1)
+    {
+        entry->kind = LINE_LOST;
+        entry->lost = 1;
+        ++stats.lost;
+        return;
+    }
+    entry->kind = kind;
+    memcpy(entry->text, line, line_len + 1);
+}
+
+// Move everything waiting in the ring into the line being received and the queue
+static void take_lines(void)
+{
+    const uint32_t head = rx_head;
+    while (rx_tail != head)
+    {
+        const char c = (char)rx_ring[rx_tail % UART_COMMAND_RX_BUFFER];
+        ++rx_tail;
+
+        if (c == '\r' || c == '\n')
+        {
+            line[line_len] = '\0';
+            if (line_too_long)
+                queue_line(LINE_TOO_LONG);
+            else if (line_len > 0)
+                queue_line(LINE_COMMAND);
+            line_len = 0;
+            line_too_long = false;
+        }
+        else if (c == '\b' || c == 0x7f)
+        {
+            if (line_len > 0)
+                --line_len;
+        }
+        else if (line_len < UART_COMMAND_MAX_LINE)
+        {
+            line[line_len++] = c;
+        }
+        else
+        {
+            line_too_long = true;
+        }
+    }
+}
+
+// Call from the main loop between frames. Takes what has arrived and runs the first queued
+// line, if any.
+void uart_command_poll(void)
+{
+    take_lines();
+    if (queue_tail == queue_head)
+        return;
+
+    queued_line_t* entry = &queue[queue_tail % UART_COMMAND_QUEUE];
+    switch (entry->kind)
+    {
+    case LINE_COMMAND:
+        run_line(entry->text);
+        break;
+    case LINE_TOO_LONG:
+        ++stats.errors;
+        printf("ERR line too long\r\n");
+        break;
+    case LINE_LOST:
+        ++stats.errors;
+        printf("ERR command queue full, %lu lines lost\r\n", (unsigned long)entry->lost);
+        break;
+    }
+    ++queue_tail;
+}
+
+// Parse a decimal or 0x-prefixed integer in [min, max]
+bool uart_command_parse_int(const char* text, int32_t min, int32_t max, int32_t* value)
+{
+    char* end;
+    const long parsed = strtol(text, &end, 0);
+    if (end == text || *end != '\0' || parsed < min || parsed > max)
+        return false;
+    *value = (int32_t)parsed;
+    return true;
+}
+
+void uart_command_get_stats(uart_command_stats_t* out)
+{
+#if PICO_ON_DEVICE
+    const uint32_t irq = save_and_disable_interrupts();
+#endif
+    *out = *(const uart_command_stats_t*)&stats;
+#if PICO_ON_DEVICE
+    restore_interrupts(irq);
+#endif
+}
+
+void uart_command_print_stats(void)
+{
+    uart_command_stats_t s;
+    uart_command_get_stats(&s);
+    printf("UART: %lu bytes, %lu commands, %lu errors, %lu lines lost, %lu dropped, %lu FIFO overruns, ring peak %lu "
+           "of %u\r\n",
+           (unsigned long)s.bytes, (unsigned long)s.commands, (unsigned long)s.errors, (unsigned long)s.lost,
+           (unsigned long)s.dropped, (unsigned long)s.fifo_overruns, (unsigned long)s.max_fill, UART_COMMAND_RX_BUFFER);
+}
@@ -0,0 +1,96 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef UART_COMMAND_H
+#define UART_COMMAND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if PICO_ON_DEVICE
+#include "hardware/uart.h"
+#else
+typedef struct uart_inst uart_inst_t;
+#endif
+
+// Line-based command channel over the UART, for test rigs and the Kiwi terminal.
+//
+// The RX interrupt drains the UART FIFO into a ring buffer, so bursts are kept even while the
+// main loop is busy pushing a frame. uart_command_poll() takes everything waiting in the ring
+// and splits it into lines, then runs at most one queued line per call, so a long script cannot
+// hold up the scanline feed. A command is a line of space-separated words. It is answered with
+// "OK", or with "ERR" and a reason, after anything the command prints itself. Lines that arrive
+// while the queue is full are answered with a single "ERR" in their place. Built in are "help"
+// and "mem" (or "m"), which prints the memory report.
+
+// RX ring buffer size in bytes, a power of two. It only has to hold what arrives between two
+// polls: 1024 bytes is 89 ms at 115200 baud, over five frames, enough to cover a command that
+// prints a long report over the same UART.
+#ifndef UART_COMMAND_RX_BUFFER
+#define UART_COMMAND_RX_BUFFER 1024
+#endif
+
+// Longest command line, and most words in one
+#define UART_COMMAND_MAX_LINE 64
+#define UART_COMMAND_MAX_ARGS 6
+
+// Complete lines waiting to run, a power of two. The last slot is kept for the reply to lines
+// that did not fit, so a pasted script of up to 15 lines runs whole, one line per frame.
+#ifndef UART_COMMAND_QUEUE
+#define UART_COMMAND_QUEUE 16
+#endif
+
+// Handles argv[0] with its arguments, returns false if they are not valid
+typedef bool (*uart_command_handler_t)(int argc, char** argv);
+
+typedef struct
+{
+    const char* name;
+    const char* usage; // Arguments, shown by help and when the handler fails
+    uart_command_handler_t handler;
+} uart_command_t;
+
+typedef struct
+{
+    uint32_t bytes;         // Received
+    uint32_t dropped;       // Lost because the ring buffer was full
+    uint32_t fifo_overruns; // Lost in the UART FIFO before the interrupt could run
+    uint32_t max_fill;      // Most bytes waiting in the ring buffer
+    uint32_t commands;      // Lines run
+    uint32_t errors;        // Lines rejected
+    uint32_t lost;          // Lines dropped because the queue was full
+} uart_command_stats_t;
+
+// Function declarations
+void uart_command_init(uart_inst_t* uart, const uart_command_t* commands, uint32_t count);
+void uart_command_poll(void);
+bool uart_command_parse_int(const char* text, int32_t min, int32_t max, int32_t* value);
+void uart_command_get_stats(uart_command_stats_t* stats);
+void uart_command_print_stats(void);
+#if !PICO_ON_DEVICE
+void uart_command_receive(const void* data, uint32_t length);
+#endif
+
+#endif // UART_COMMAND_H
@@ -0,0 +1,161 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include "uart_stream.h"
+#include "display_mode.h"
+#include "fb_stream.h"
+#include "hardware/dma.h"
+#include "hardware/uart.h"
+
+#if LIB_PICO_STDIO_UART
+#include "pico/stdio.h"
+#include "pico/stdio/driver.h"
+#include "pico/stdio_uart.h"
+#endif
+
+static fb_stream_t stream;
+static uint32_t tile_hashes[FB_STREAM_TILE_COUNT(FRAME_WIDTH, FRAME_HEIGHT)];
+
+// One buffer is being sent by DMA while the other is filled by the encoder
+static uint8_t tx_buffers[2][UART_STREAM_BUFFER_SIZE];
+static size_t tx_fill;
+static uint tx_index;
+static int dma_channel = -1;
+
+static bool streaming = false;
+static uint frames_since_stream;
+static uint streamed_frames;
+
+// While streaming, stdio's UART driver is swapped for one that queues text here, and
+// uart_stream_poll() copies it into the transmit buffer between packets. The DMA is then the
+// only writer to the UART, so log lines cannot end up inside a packet.
+static char text_ring[UART_STREAM_TEXT_SIZE];
+static volatile uint32_t text_head; // Bytes queued since boot
+static uint32_t text_tail;          // Bytes taken since boot
+static bool text_captured;
+
+#if LIB_PICO_STDIO_UART
+static void stream_out_chars(const char* buf, int length)
+{
+    for (int i = 0; i < length && text_head - text_tail < UART_STREAM_TEXT_SIZE; ++i)
+    {
+        text_ring[text_head % UART_STREAM_TEXT_SIZE] = buf[i];
+        ++text_head;
+    }
+}
+
+static stdio_driver_t stream_stdio = {.out_chars = stream_out_chars};
+#endif
+
+static void capture_stdio(bool capture)
+{
+#if LIB_PICO_STDIO_UART
+    if (capture == text_captured)
+        return;
+    stdio_set_driver_enabled(&stream_stdio, capture);
+    stdio_set_driver_enabled(&stdio_uart, !capture);
+#endif
+    text_captured = capture;
+}
+
+// Copy queued text into the transmit buffer
+static size_t take_text(uint8_t* out, size_t room)
+{
+    size_t taken = 0;
+    while (taken < room && text_tail != text_head)
+    {
+        out[taken++] = (uint8_t)text_ring[text_tail++ % UART_STREAM_TEXT_SIZE];
+    }
+    return taken;
+}
+
+void uart_stream_init(const uint16_t* framebuffer)
+{
+    fb_stream_init(&stream, framebuffer, FRAME_WIDTH, FRAME_HEIGHT, tile_hashes);
+
+    dma_channel = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, uart_get_dreq(uart0, true));
+    dma_channel_configure(dma_channel, &config, &uart_get_hw(uart0)->dr, NULL, 0, false);
+}
+
+void uart_stream_set_enabled(bool enabled)
+{
+    if (enabled && !streaming)
+    {
+        // Restart with a keyframe so the host can sync up
+        streamed_frames = 0;
+        frames_since_stream = UART_STREAM_FRAME_INTERVAL;
+        capture_stdio(true);
+    }
+    // On disabling, stdio goes back to the UART once the last frame and text have been sent
+    streaming = enabled;
+}
+
+bool uart_stream_enabled(void)
+{
+    return streaming;
+}
+
+// Call once per frame from the main loop. Never blocks: the UART is fed by DMA and the
+// encoder only does a bounded amount of work per call.
+void uart_stream_poll(void)
+{
+    if (dma_channel < 0)
+        return;
+
+    ++frames_since_stream;
+
+    // Hand the filled buffer to the DMA once the previous transfer is done
+    if (tx_fill > 0 && !dma_channel_is_busy(dma_channel))
+    {
+        dma_channel_transfer_from_buffer_now(dma_channel, tx_buffers[tx_index], tx_fill);
+        tx_index ^= 1;
+        tx_fill = 0;
+    }
+
+    // The buffer always ends on a packet boundary here
+    tx_fill += take_text(&tx_buffers[tx_index][tx_fill], UART_STREAM_BUFFER_SIZE - tx_fill);
+
+    if (!streaming && !fb_stream_busy(&stream))
+    {
+        if (tx_fill == 0 && text_tail == text_head && !dma_channel_is_busy(dma_channel))
+            capture_stdio(false);
+        return;
+    }
+
+    if (!fb_stream_busy(&stream) && frames_since_stream >= UART_STREAM_FRAME_INTERVAL)
+    {
+        fb_stream_begin_frame(&stream, streamed_frames % UART_STREAM_KEYFRAME_INTERVAL == 0);
+        frames_since_stream = 0;
+        ++streamed_frames;
+    }
+
+    tx_fill += fb_stream_encode(&stream, &tx_buffers[tx_index][tx_fill], UART_STREAM_BUFFER_SIZE - tx_fill,
+                                UART_STREAM_TILES_PER_POLL);
+}
@@ -0,0 +1,57 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef UART_STREAM_H
+#define UART_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Stream one frame out of every UART_STREAM_FRAME_INTERVAL main loop frames
+#ifndef UART_STREAM_FRAME_INTERVAL
+#define UART_STREAM_FRAME_INTERVAL 6
+#endif
+
+// Send every tile, not just changed ones, once every UART_STREAM_KEYFRAME_INTERVAL streamed frames
+#ifndef UART_STREAM_KEYFRAME_INTERVAL
+#define UART_STREAM_KEYFRAME_INTERVAL 100
+#endif
+
+// Maximum number of tiles hashed per call to uart_stream_poll()
+#define UART_STREAM_TILES_PER_POLL 128
+
+// Size of each of the two DMA transmit buffers
+#define UART_STREAM_BUFFER_SIZE 512
+
+// Text printed while streaming is queued here and sent between packets, what does not fit is dropped
+#define UART_STREAM_TEXT_SIZE 1024
+
+// Function declarations
+void uart_stream_init(const uint16_t* framebuffer);
+void uart_stream_set_enabled(bool enabled);
+bool uart_stream_enabled(void);
+void uart_stream_poll(void);
+
+#endif // UART_STREAM_H
@@ -1,224 +0,0 @@
-/*
- * The MIT License (MIT)
- *
- * Copyright (c) 2024, Cytrence Technologies
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- *
- */
-
-#ifndef DIGITS_BITMAPS_H
-#define DIGITS_BITMAPS_H
-
-#define DIGIT_WIDTH   8
-#define DIGIT_HEIGHT  16
-#define DIGIT_SPACING 1
-
-static const uint8_t digit_bitmaps[11][DIGIT_HEIGHT][DIGIT_WIDTH] = {
-    // Digit 0
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 1
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 1, 1, 1, 0, 0, 0},
-     {0, 1, 1, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 2
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 1, 1, 0},
-     {0, 0, 0, 0, 1, 1, 0, 0},
-     {0, 0, 0, 1, 1, 0, 0, 0},
-     {0, 0, 1, 1, 0, 0, 0, 0},
-     {0, 1, 1, 0, 0, 0, 0, 0},
-     {1, 1, 0, 0, 0, 0, 0, 0},
-     {1, 1, 1, 1, 1, 1, 1, 1},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 3
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 1, 1, 0},
-     {0, 0, 0, 1, 1, 1, 0, 0},
-     {0, 0, 0, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 1, 1, 0},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 4
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 1, 1, 0, 0},
-     {0, 0, 0, 1, 1, 1, 0, 0},
-     {0, 0, 1, 1, 0, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 0, 0},
-     {1, 1, 0, 0, 0, 1, 0, 0},
-     {1, 1, 0, 0, 0, 1, 0, 0},
-     {1, 1, 0, 0, 0, 1, 0, 0},
-     {1, 1, 1, 1, 1, 1, 1, 1},
-     {0, 0, 0, 0, 0, 1, 0, 0},
-     {0, 0, 0, 0, 0, 1, 0, 0},
-     {0, 0, 0, 0, 0, 1, 0, 0},
-     {0, 0, 0, 0, 0, 1, 0, 0},
-     {0, 0, 0, 0, 0, 1, 0, 0},
-     {0, 0, 0, 0, 0, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 5
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {1, 1, 1, 1, 1, 1, 1, 1},
-     {1, 1, 1, 1, 1, 1, 1, 1},
-     {1, 1, 0, 0, 0, 0, 0, 0},
-     {1, 1, 0, 0, 0, 0, 0, 0},
-     {1, 1, 0, 0, 0, 0, 0, 0},
-     {1, 1, 0, 0, 0, 0, 0, 0},
-     {1, 1, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 1, 1, 0},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 6
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 0, 0},
-     {1, 1, 0, 0, 0, 0, 0, 0},
-     {1, 1, 1, 1, 1, 1, 0, 0},
-     {1, 1, 0, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 7
-    {
-        {0, 0, 0, 0, 0, 0, 0, 0},
-        {1, 1, 1, 1, 1, 1, 1, 1},
-        {1, 1, 1, 1, 1, 1, 1, 1},
-        {0, 0, 0, 0, 0, 0, 1, 1},
-        {0, 0, 0, 0, 0, 0, 1, 1},
-        {0, 0, 0, 0, 0, 1, 1, 0},
-        {0, 0, 0, 0, 0, 1, 1, 0},
-        {0, 0, 0, 0, 1, 1, 0, 0},
-        {0, 0, 0, 0, 1, 1, 0, 0},
-        {0, 0, 0, 1, 1, 0, 0, 0},
-        {0, 0, 0, 1, 1, 0, 0, 0},
-        {0, 0, 1, 1, 0, 0, 0, 0},
-        {0, 0, 1, 1, 0, 0, 0, 0},
-        {0, 1, 1, 0, 0, 0, 0, 0},
-        {0, 1, 1, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0},
-    },
-    // Digit 8
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Digit 9
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 1},
-     {0, 0, 1, 1, 1, 1, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {0, 0, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {1, 1, 0, 0, 0, 0, 1, 1},
-     {0, 1, 1, 0, 0, 1, 1, 0},
-     {0, 0, 1, 1, 1, 1, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}},
-    // Space
-    {{0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0},
-     {0, 0, 0, 0, 0, 0, 0, 0}}};
-
-#endif // DIGITS_BITMAPS_H
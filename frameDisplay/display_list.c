@@ -0,0 +1,214 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "display_list.h"
+#include "scanout.h"
+
+#define NO_COMMAND 0xff
+
+// A fill-rect command has no bitmap, a glyph command has a 1bpp bitmap with stride bytes per row
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+    int16_t stride;
+    uint16_t color;
+    uint16_t background;
+    const uint8_t* bitmap;
+    uint8_t scale;      // Of a glyph, w and h are its size on screen
+    uint8_t next_start; // Next command starting on the same line
+    uint8_t next_end;   // Next command ending on the same line
+} display_list_command_t;
+
+static display_list_command_t commands[DISPLAY_LIST_MAX_COMMANDS];
+static uint command_count;
+static uint16_t background_color;
+
+// Commands bucketed by their first and last line
+static uint8_t start_bucket[FRAME_HEIGHT];
+static uint8_t end_bucket[FRAME_HEIGHT];
+
+void display_list_init(void)
+{
+    memset(start_bucket, NO_COMMAND, sizeof(start_bucket));
+    memset(end_bucket, NO_COMMAND, sizeof(end_bucket));
+    command_count = 0;
+    background_color = 0;
+}
+
+void display_list_clear(uint16_t background)
+{
+    // Only the buckets that are in use need to be emptied
+    for (uint i = 0; i < command_count; ++i)
+    {
+        start_bucket[commands[i].y] = NO_COMMAND;
+        end_bucket[commands[i].y + commands[i].h - 1] = NO_COMMAND;
+    }
+    command_count = 0;
+    background_color = background;
+}
+
+static bool add_command(const display_list_command_t* command)
+{
+    if (command_count >= DISPLAY_LIST_MAX_COMMANDS)
+        return false;
+
+    const uint index = command_count++;
+    commands[index] = *command;
+
+    const uint first = command->y;
+    const uint last = command->y + command->h - 1;
+    commands[index].next_start = start_bucket[first];
+    start_bucket[first] = index;
+    commands[index].next_end = end_bucket[last];
+    end_bucket[last] = index;
+    return true;
+}
+
+bool display_list_fill_rect(int x, int y, int w, int h, uint16_t color)
+{
+    // Clip to the frame
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > FRAME_WIDTH)
+        w = FRAME_WIDTH - x;
+    if (y + h > FRAME_HEIGHT)
+        h = FRAME_HEIGHT - y;
+    if (w <= 0 || h <= 0)
+        return true;
+
+    const display_list_command_t command = {.x = x, .y = y, .w = w, .h = h, .color = color, .bitmap = NULL};
+    return add_command(&command);
+}
+
+bool display_list_glyph(const uint8_t* bitmap, int stride, int w, int h, int x, int y, uint16_t fg, uint16_t bg)
+{
+    return display_list_glyph_scaled(bitmap, stride, w, h, x, y, 1, fg, bg);
+}
+
+bool display_list_glyph_scaled(const uint8_t* bitmap, int stride, int w, int h, int x, int y, int scale, uint16_t fg,
+                               uint16_t bg)
+{
+    w *= scale;
+    h *= scale;
+
+    // Bounds checking
+    if (x < 0 || x + w > FRAME_WIDTH || y < 0 || y + h > FRAME_HEIGHT || w <= 0 || h <= 0 || scale < 1 ||
+        scale > 255)
+        return false;
+
+    const display_list_command_t command = {.x = x, .y = y, .w = w, .h = h, .stride = stride, .color = fg,
+                                            .background = bg, .bitmap = bitmap, .scale = scale};
+    return add_command(&command);
+}
+
+uint32_t display_list_count(void)
+{
+    return command_count;
+}
+
+static void render_command(const display_list_command_t* command, uint16_t* line, uint y)
+{
+    uint16_t* dst = &line[command->x];
+    if (command->bitmap == NULL)
+    {
+        for (int i = 0; i < command->w; ++i)
+        {
+            dst[i] = command->color;
+        }
+    }
+    else if (command->scale == 1)
+    {
+        const uint8_t* row = &command->bitmap[(y - command->y) * command->stride];
+        for (int i = 0; i < command->w; ++i)
+        {
+            dst[i] = (row[i >> 3] & (0x80 >> (i & 7))) ? command->color : command->background;
+        }
+    }
+    else
+    {
+        // Every bitmap pixel becomes a run of scale pixels, and every bitmap row scale lines
+        const int scale = command->scale;
+        const uint8_t* row = &command->bitmap[(y - command->y) / scale * command->stride];
+        for (int j = 0; j * scale < command->w; ++j)
+        {
+            const uint16_t color = (row[j >> 3] & (0x80 >> (j & 7))) ? command->color : command->background;
+            for (int i = 0; i < scale; ++i)
+            {
+                *dst++ = color;
+            }
+        }
+    }
+}
+
+static void fill_background(uint16_t* line)
+{
+    uint32_t* dst = (uint32_t*)line;
+    const uint32_t pair = background_color * 0x00010001u;
+    for (uint x = 0; x < FRAME_WIDTH / 2; ++x)
+    {
+        dst[x] = pair;
+    }
+}
+
+// Render every line just in time and queue it for scanout. Commands are drawn in the
+// order they were added, so later commands cover earlier ones.
+void display_list_scanout(void)
+{
+    uint64_t active = 0;
+
+    for (uint y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        for (uint i = start_bucket[y]; i != NO_COMMAND; i = commands[i].next_start)
+        {
+            active |= 1ull << i;
+        }
+
+        uint16_t* line = scanout_acquire_line();
+        fill_background(line);
+        for (uint64_t pending = active; pending; pending &= pending - 1)
+        {
+            render_command(&commands[__builtin_ctzll(pending)], line, y);
+        }
+        scanout_commit_line(line);
+
+        for (uint i = end_bucket[y]; i != NO_COMMAND; i = commands[i].next_end)
+        {
+            active &= ~(1ull << i);
+        }
+    }
+}
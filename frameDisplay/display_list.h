@@ -0,0 +1,47 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Maximum number of commands in the display list, at most 64
+#define DISPLAY_LIST_MAX_COMMANDS 64
+
+// Function declarations
+void display_list_init(void);
+void display_list_clear(uint16_t background);
+bool display_list_fill_rect(int x, int y, int w, int h, uint16_t color);
+// Glyph bitmaps are 1bpp with stride bytes per row, a stride of 0 repeats the first row
+bool display_list_glyph(const uint8_t* bitmap, int stride, int w, int h, int x, int y, uint16_t fg, uint16_t bg);
+// Glyph scaled up by an integer factor, w and h are the bitmap's size before scaling
+bool display_list_glyph_scaled(const uint8_t* bitmap, int stride, int w, int h, int x, int y, int scale, uint16_t fg,
+                               uint16_t bg);
+uint32_t display_list_count(void);
+void display_list_scanout(void);
+
+#endif // DISPLAY_LIST_H
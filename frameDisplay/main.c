@@ -27,22 +27,90 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "bitmap.h"
 #include "common_dvi_pin_configs.h"
+#include "digits_font.h"
+#include "display_list.h"
+#include "display_mode.h"
 #include "dvi.h"
 #include "dvi_serialiser.h"
+#include "frame_id.h"
 #include "hardware/clocks.h"
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
 #include "hardware/sync.h"
 #include "hardware/uart.h"
 #include "hardware/vreg.h"
+#include "mem_report.h"
 #include "pico/multicore.h"
 #include "pico/stdlib.h"
+#include "renderer.h"
+#include "scanout.h"
+#include "stress.h"
+#include "uart_command.h"
+#include "uart_stream.h"
+
+// Render from a retained display list instead of a framebuffer
+#ifndef RENDER_DISPLAY_LIST
+#define RENDER_DISPLAY_LIST 0
+#endif
+
+// Stream the framebuffer over UART, see common/uart_stream.h
+#ifndef UART_FB_STREAM
+#define UART_FB_STREAM 0
+#endif
+
+// Draw a machine-readable frame number strip at the top and bottom, see common/frame_id.h
+#ifndef FRAME_ID_STRIP
+#define FRAME_ID_STRIP 0
+#endif
+
+// Stress pattern drawn behind the counter from boot, set with the FRAMEDISPLAY_STRESS CMake cache
+// variable and changed at run time with the "pattern" command. See stress.h.
+#ifndef STRESS_BOOT_PATTERN
+#define STRESS_BOOT_PATTERN STRESS_OFF
+#endif
+
+// Counter layouts: one counter in the middle of the screen, one in the top left corner, or one
+// in each quarter of the screen, where a torn frame shows up as quarters that differ
+typedef enum
+{
+    LAYOUT_CENTRE = 0,
+    LAYOUT_CORNER,
+    LAYOUT_GRID,
+    LAYOUT_COUNT
+} layout_t;
+
+// Digit scale and layout at boot, set with the FRAMEDISPLAY_DIGIT_SCALE and FRAMEDISPLAY_LAYOUT
+// CMake cache variables and changed at run time with the "digits" command
+#ifndef DIGIT_BOOT_SCALE
+#define DIGIT_BOOT_SCALE 1
+#endif
+
+#ifndef DIGIT_BOOT_LAYOUT
+#define DIGIT_BOOT_LAYOUT LAYOUT_CENTRE
+#endif
+
+#if UART_FB_STREAM && RENDER_DISPLAY_LIST
+#error "UART framebuffer streaming needs the framebuffer renderer"
+#endif
+
+#if STRESS_BOOT_PATTERN != STRESS_OFF && RENDER_DISPLAY_LIST
+#error "Stress patterns need the framebuffer renderer"
+#endif
+
+// Digit glyphs are generated from assets/digits.bdf at build time
+#define DIGIT_WIDTH   DIGITS_FONT_WIDTH
+#define DIGIT_HEIGHT  DIGITS_FONT_HEIGHT
+#define DIGIT_SPACING 1
+#define MAX_DIGITS    5
+#define MAX_SCALE     8
+#define CORNER_MARGIN 16 // Keeps the corner counter clear of the frame ID strip
+
+#if DISPLAY_MODE == DISPLAY_MODE_640x480 && !RENDER_DISPLAY_LIST
+#error "The frameDisplay framebuffer does not fit in SRAM at 640x480"
+#endif
 
 // Display settings
-#define FRAME_WIDTH  320
-#define FRAME_HEIGHT 240
 #define VREG_VSEL    VREG_VOLTAGE_1_20
 #define DVI_TIMING   dvi_timing_640x480p_60hz
 
@@ -58,8 +126,56 @@
 
 struct dvi_inst dvi0;
 
+// Number shown on screen, and a request from the "frame" command to clear the screen before
+// the next one because it may be shorter
+static int number;
+static bool clear_requested;
+
+// Digit size and placement. Each counter shows the low counter_digits digits of the number,
+// as many as fit its part of the screen at that scale.
+static int digit_scale;
+static layout_t digit_layout;
+static int counter_digits;
+static int counter_modulus;
+
+// Time to draw the counters, reported every FRAME_COUNT_TARGET frames
+static struct
+{
+    uint32_t frames;
+    uint64_t total_us;
+    uint32_t max_us;
+} digit_stats;
+
+static const char* const layout_names[LAYOUT_COUNT] = {"centre", "corner", "grid"};
+
+#if !RENDER_DISPLAY_LIST
 static uint16_t framebuffer[FRAME_HEIGHT * FRAME_WIDTH];
 
+// Stress pattern and how well it keeps up, reported every FRAME_COUNT_TARGET frames
+static stress_pattern_t stress_pattern = STRESS_BOOT_PATTERN;
+static uint32_t stress_frame;
+static struct
+{
+    uint32_t frames;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t late_frames;    // Started a whole frame interval or more after they were due
+    uint32_t late_scanlines; // libdvi's count at the start of the period
+} stress_stats;
+#endif
+
+#if FRAME_ID_STRIP
+#if FRAME_WIDTH % FRAME_ID_CELLS != 0
+#error "The frame ID strip needs a frame width that is a multiple of FRAME_ID_CELLS"
+#endif
+
+// Counts every frame sent to the display, unlike the displayed number it does not wrap
+static uint32_t frame_counter;
+
+// 1bpp strip, also referenced by the display list until the frame is scanned out
+static uint8_t frame_id_row[FRAME_WIDTH / 8];
+#endif
+
 void core1_main()
 {
     // Register IRQs and start DVI scan buffer on core 1
@@ -71,37 +187,124 @@ void core1_main()
     }
 
     dvi_start(&dvi0);
+#if TMDS_CACHE
+    scanout_tmds_cache_main(&dvi0);
+#else
     dvi_scanbuf_main_16bpp(&dvi0);
+#endif
 }
 
 static void initialize_framebuffer()
 {
+#if RENDER_DISPLAY_LIST
+    // Start with an empty, black display list
+    display_list_init();
+#else
     // Initialize framebuffer with black color
     memset(framebuffer, 0, sizeof(framebuffer));
+#endif
 }
 
 static void reset_framebuffer_to_0()
 {
+#if !RENDER_DISPLAY_LIST
     // Reset framebuffer to 0
     memset(framebuffer, 0, sizeof(framebuffer));
+#endif
 }
 
-static void draw_char(const uint8_t bitmap[DIGIT_HEIGHT][DIGIT_WIDTH], const int x, const int y)
+static int counter_count(void)
 {
-    // Bounds checking
-    if (x < 0 || x + DIGIT_WIDTH > FRAME_WIDTH || y < 0 || y + DIGIT_HEIGHT > FRAME_HEIGHT)
+    return digit_layout == LAYOUT_GRID ? 4 : 1;
+}
+
+// Part of the screen counter i of a layout is placed in
+static void counter_area(layout_t layout, int i, int* x, int* y, int* w, int* h)
+{
+    switch (layout)
     {
+    case LAYOUT_CORNER:
+        *x = CORNER_MARGIN;
+        *y = CORNER_MARGIN;
+        *w = FRAME_WIDTH - 2 * CORNER_MARGIN;
+        *h = FRAME_HEIGHT - 2 * CORNER_MARGIN;
+        break;
+    case LAYOUT_GRID:
+        *w = FRAME_WIDTH / 2;
+        *h = FRAME_HEIGHT / 2;
+        *x = (i % 2) * *w;
+        *y = (i / 2) * *h;
+        break;
+    default:
+        *x = 0;
+        *y = 0;
+        *w = FRAME_WIDTH;
+        *h = FRAME_HEIGHT;
+        break;
+    }
+}
+
+// Top left of counter i when it is total_width pixels wide: in the corner of its area for the
+// corner layout, in the middle of it otherwise
+static void counter_origin(int i, int total_width, int* x, int* y)
+{
+    int w, h;
+    counter_area(digit_layout, i, x, y, &w, &h);
+    if (digit_layout == LAYOUT_CORNER)
         return;
+    *x += (w - total_width) / 2;
+    *y += (h - DIGIT_HEIGHT * digit_scale) / 2;
+}
+
+// Digits of a counter that fit its area at a scale, 0 if not even one does
+static int digits_that_fit(layout_t layout, int scale)
+{
+    int x, y, w, h;
+    counter_area(layout, 0, &x, &y, &w, &h);
+    if (DIGIT_HEIGHT * scale > h)
+        return 0;
+    const int digits = w / ((DIGIT_WIDTH + DIGIT_SPACING) * scale);
+    return digits < MAX_DIGITS ? digits : MAX_DIGITS;
+}
+
+static bool set_digits(int scale, layout_t layout)
+{
+    const int digits = digits_that_fit(layout, scale);
+    if (digits == 0)
+    {
+        printf("Digits %dx do not fit the %s layout\r\n", scale, layout_names[layout]);
+        return false;
     }
 
-    // Draw a character on the framebuffer at specified position
-    for (int i = 0; i < DIGIT_HEIGHT; i++)
+    digit_scale = scale;
+    digit_layout = layout;
+    counter_digits = digits;
+    counter_modulus = 1;
+    for (int i = 0; i < digits; ++i)
     {
-        for (int j = 0; j < DIGIT_WIDTH; j++)
-        {
-            framebuffer[(y + i) * FRAME_WIDTH + (x + j)] = bitmap[i][j] ? 0xFFFF : 0x0000;
-        }
+        counter_modulus *= 10;
+    }
+    memset(&digit_stats, 0, sizeof(digit_stats));
+    clear_requested = true;
+    return true;
+}
+
+static void draw_char(const uint8_t* glyph, const int x, const int y)
+{
+    // Bounds checking
+    if (x < 0 || x + DIGIT_WIDTH * digit_scale > FRAME_WIDTH || y < 0 || y + DIGIT_HEIGHT * digit_scale > FRAME_HEIGHT)
+    {
+        return;
     }
+
+#if RENDER_DISPLAY_LIST
+    display_list_glyph_scaled(glyph, DIGITS_FONT_STRIDE, DIGIT_WIDTH, DIGIT_HEIGHT, x, y, digit_scale, 0xFFFF,
+                              0x0000);
+#else
+    // Draw a character on the framebuffer at specified position, scaled up with row-replicated spans
+    render_glyph_scaled(framebuffer, glyph, DIGITS_FONT_STRIDE, DIGIT_WIDTH, DIGIT_HEIGHT, x, y, digit_scale, 0xFFFF,
+                        0x0000);
+#endif
 }
 
 // Clear the area in the framebuffer where the digits are displayed
@@ -110,60 +313,248 @@ static void clear_digits_area(const int num_digits)
     if (num_digits <= 0)
         return;
 
-    const int total_width = num_digits * (DIGIT_WIDTH + DIGIT_SPACING);
-    const int x_offset = (FRAME_WIDTH - total_width) / 2;
-    const int y_offset = (FRAME_HEIGHT - DIGIT_HEIGHT) / 2;
+#if RENDER_DISPLAY_LIST
+    // The display list is rebuilt from scratch for every frame
+    display_list_clear(0x0000);
+#else
+    const int total_width = num_digits * (DIGIT_WIDTH + DIGIT_SPACING) * digit_scale;
+    for (int c = 0; c < counter_count(); ++c)
+    {
+        int x_offset, y_offset;
+        counter_origin(c, total_width, &x_offset, &y_offset);
 
-    // Bounds checking
-    if (x_offset < 0 || y_offset < 0)
-        return;
+        // Bounds checking
+        if (x_offset < 0 || y_offset < 0)
+            return;
 
-    for (int i = 0; i < DIGIT_HEIGHT; i++)
-    {
-        memset(&framebuffer[(y_offset + i) * FRAME_WIDTH + x_offset], 0, total_width * sizeof(uint16_t));
+        render_fill_rect(framebuffer, x_offset, y_offset, total_width, DIGIT_HEIGHT * digit_scale, 0x0000);
     }
+#endif
 }
 
 static void update_framebuffer(const int number)
 {
-    // Convert number to string and calculate number of digits
-    // The array size is 6 to hold a maximum of 5 digits plus the null terminator
-    // It can be increased if a larger number of digits is required
-    char str[6];
-    const int num_digits = snprintf(str, sizeof(str), "%d", number);
+    // Convert the digits that fit to a string and calculate number of digits
+    char str[MAX_DIGITS + 1];
+    const int num_digits = snprintf(str, sizeof(str), "%d", number % counter_modulus);
     if (num_digits < 0 || num_digits >= sizeof(str))
         return;
 
     clear_digits_area(num_digits);
 
-    const int total_width = num_digits * (DIGIT_WIDTH + DIGIT_SPACING);
-    const int x_offset = (FRAME_WIDTH - total_width) / 2;
-    const int y_offset = (FRAME_HEIGHT - DIGIT_HEIGHT) / 2;
-
-    for (int i = 0; i < num_digits; i++)
+    const int advance = (DIGIT_WIDTH + DIGIT_SPACING) * digit_scale;
+    for (int c = 0; c < counter_count(); ++c)
     {
-        const int digit = str[i] - '0';
-        if (digit >= 0 && digit <= 9)
+        int x_offset, y_offset;
+        counter_origin(c, num_digits * advance, &x_offset, &y_offset);
+
+        for (int i = 0; i < num_digits; i++)
         {
-            draw_char(digit_bitmaps[digit], x_offset + (i * (DIGIT_WIDTH + DIGIT_SPACING)), y_offset);
+            const int digit = str[i] - '0';
+            if (digit >= 0 && digit <= 9)
+            {
+                draw_char(digits_font_glyph(str[i]), x_offset + i * advance, y_offset);
+            }
         }
     }
 }
 
+// Draw the counters, timing them
+static void draw_digits(const int number)
+{
+    const uint32_t start = time_us_32();
+    update_framebuffer(number);
+    const uint32_t elapsed = time_us_32() - start;
+
+    ++digit_stats.frames;
+    digit_stats.total_us += elapsed;
+    if (elapsed > digit_stats.max_us)
+        digit_stats.max_us = elapsed;
+}
+
+// Only printed for large digits or other layouts, the default counter takes a few microseconds
+static void report_digit_stats(void)
+{
+    if (digit_stats.frames == 0 || (digit_scale == 1 && digit_layout == LAYOUT_CENTRE))
+        return;
+
+    printf("Digits %dx %s: %d counters of %d digits, render mean %lu us, max %lu us of a %d us frame\n", digit_scale,
+           layout_names[digit_layout], counter_count(), counter_digits,
+           (unsigned long)(digit_stats.total_us / digit_stats.frames), (unsigned long)digit_stats.max_us,
+           FRAME_INTERVAL_2);
+    memset(&digit_stats, 0, sizeof(digit_stats));
+}
+
+#if !RENDER_DISPLAY_LIST
+static void reset_stress_stats(void)
+{
+    memset(&stress_stats, 0, sizeof(stress_stats));
+    stress_stats.late_scanlines = dvi0.late_scanline_ctr;
+}
+
+// Fill the screen with the stress pattern, timing it. lateness is how long after it was due the
+// frame started.
+static void draw_stress_pattern(uint64_t lateness_us)
+{
+    if (stress_pattern == STRESS_OFF)
+        return;
+
+    const uint32_t start = time_us_32();
+    stress_render(stress_pattern, framebuffer, stress_frame++);
+    const uint32_t elapsed = time_us_32() - start;
+
+    ++stress_stats.frames;
+    stress_stats.total_us += elapsed;
+    if (elapsed > stress_stats.max_us)
+        stress_stats.max_us = elapsed;
+    if (lateness_us >= FRAME_INTERVAL_1)
+        ++stress_stats.late_frames;
+}
+
+// The pattern keeps up if no frame started late and libdvi never had to repeat a line
+static void report_stress_stats(void)
+{
+    if (stress_stats.frames == 0)
+        return;
+
+    const uint32_t late_scanlines = dvi0.late_scanline_ctr - stress_stats.late_scanlines;
+    const bool keeps_up = stress_stats.late_frames == 0 && late_scanlines == 0;
+    printf("Stress %s: %lu frames, render mean %lu us, max %lu us, %lu late frames, %lu late scanlines, %s\n",
+           stress_name(stress_pattern), (unsigned long)stress_stats.frames,
+           (unsigned long)(stress_stats.total_us / stress_stats.frames), (unsigned long)stress_stats.max_us,
+           (unsigned long)stress_stats.late_frames, (unsigned long)late_scanlines,
+           keeps_up ? "keeps up" : "falls behind");
+    reset_stress_stats();
+}
+#endif
+
+#if FRAME_ID_STRIP
+static void draw_frame_id(void)
+{
+    frame_id_encode(frame_counter++, frame_id_row, FRAME_WIDTH);
+
+#if RENDER_DISPLAY_LIST
+    // A stride of 0 repeats the row for the height of the strip
+    display_list_glyph(frame_id_row, 0, FRAME_WIDTH, FRAME_ID_HEIGHT, 0, 0, 0xFFFF, 0x0000);
+    display_list_glyph(frame_id_row, 0, FRAME_WIDTH, FRAME_ID_HEIGHT, 0, FRAME_HEIGHT - FRAME_ID_HEIGHT, 0xFFFF,
+                       0x0000);
+#else
+    uint16_t* top = framebuffer;
+    for (int x = 0; x < FRAME_WIDTH; ++x)
+    {
+        top[x] = (frame_id_row[x >> 3] & (0x80 >> (x & 7))) ? 0xFFFF : 0x0000;
+    }
+    for (int y = 1; y < FRAME_ID_HEIGHT; ++y)
+    {
+        memcpy(&framebuffer[y * FRAME_WIDTH], top, FRAME_WIDTH * sizeof(uint16_t));
+    }
+    for (int y = FRAME_HEIGHT - FRAME_ID_HEIGHT; y < FRAME_HEIGHT; ++y)
+    {
+        memcpy(&framebuffer[y * FRAME_WIDTH], top, FRAME_WIDTH * sizeof(uint16_t));
+    }
+#endif
+}
+#endif
+
 static void update_framebuffer_sync(void)
 {
+#if RENDER_DISPLAY_LIST
+    // Render each line just in time from the display list
+    display_list_scanout();
+#else
     // Synchronize the framebuffer with the DVI output
-    for (uint y = 0; y < FRAME_HEIGHT; ++y)
+    scanout_push_frame(framebuffer);
+#endif
+}
+
+// Commands for test rigs, see common/uart_command.h. The frame ID strip keeps counting every
+// frame sent, whatever number is shown.
+static bool command_frame(int argc, char** argv)
+{
+    int32_t value;
+    if (argc != 2 || !uart_command_parse_int(argv[1], 0, MAX_NUMBER - 1, &value))
+        return false;
+    number = value;
+    clear_requested = true;
+    return true;
+}
+
+#if !RENDER_DISPLAY_LIST
+// With no argument, print the current pattern
+static bool command_pattern(int argc, char** argv)
+{
+    stress_pattern_t pattern;
+    if (argc == 1)
+    {
+        printf("Pattern: %s\r\n", stress_name(stress_pattern));
+        return true;
+    }
+    if (argc != 2 || !stress_parse(argv[1], &pattern))
+        return false;
+
+    report_stress_stats();
+    stress_pattern = pattern;
+    reset_stress_stats();
+    // Back to the counter on black
+    clear_requested = true;
+    return true;
+}
+#endif
+
+static bool parse_layout(const char* name, layout_t* layout)
+{
+    for (int i = 0; i < LAYOUT_COUNT; ++i)
     {
-        const uint16_t* scanline = &framebuffer[y * FRAME_WIDTH];
-        queue_add_blocking_u32(&dvi0.q_colour_valid, &scanline);
-        while (!queue_try_remove_u32(&dvi0.q_colour_free, &scanline))
+        if (strcmp(name, layout_names[i]) == 0)
         {
-            __wfe();
+            *layout = (layout_t)i;
+            return true;
         }
     }
+    return false;
 }
 
+// With no argument, print the current scale and layout
+static bool command_digits(int argc, char** argv)
+{
+    if (argc == 1)
+    {
+        printf("Digits: %dx %s, %d digits shown\r\n", digit_scale, layout_names[digit_layout], counter_digits);
+        return true;
+    }
+
+    int32_t scale;
+    layout_t layout = digit_layout;
+    if (argc > 3 || !uart_command_parse_int(argv[1], 1, MAX_SCALE, &scale))
+        return false;
+    if (argc == 3 && !parse_layout(argv[2], &layout))
+        return false;
+    return set_digits(scale, layout);
+}
+
+static bool command_stats(int argc, char** argv)
+{
+    if (argc != 1)
+        return false;
+    printf("Frame: showing %d\r\n", number);
+    uart_command_print_stats();
+#if SCANOUT_STATS
+    scanout_stats_t stats;
+    scanout_get_stats(&stats);
+    scanout_stats_print(&stats, scanout_line_period_ns());
+#endif
+    return true;
+}
+
+static const uart_command_t commands[] = {
+    {"frame", "<number>", command_frame},
+    {"stats", "", command_stats},
+    {"digits", "[1-8] [centre|corner|grid]", command_digits},
+#if !RENDER_DISPLAY_LIST
+    {"pattern", "[off|gradient|noise|bars|checker]", command_pattern},
+#endif
+};
+
 static int initialize_hardware(void)
 {
     // Initialize voltage regulator
@@ -193,6 +584,8 @@ static int initialize_hardware(void)
 
 int main(void)
 {
+    // Paint the stacks before anything else runs deep, or core 1 starts
+    mem_report_init();
     stdio_init_all();
 
     if (initialize_hardware() != ERR_SUCCESS)
@@ -201,10 +594,35 @@ int main(void)
         return ERR_INIT_FAILED;
     }
 
+    scanout_init(&dvi0);
     multicore_launch_core1(core1_main);
+
+    const uint64_t clear_start = to_us_since_boot(get_absolute_time());
     initialize_framebuffer();
+#if RENDER_DISPLAY_LIST
+    printf("Display mode %s, display list renderer, clear took %llu us\n", display_mode.name,
+           to_us_since_boot(get_absolute_time()) - clear_start);
+#else
+    printf("Display mode %s, framebuffer %lu bytes, clear took %llu us\n", display_mode.name,
+           (unsigned long)display_mode_framebuffer_bytes(&display_mode),
+           to_us_since_boot(get_absolute_time()) - clear_start);
+#endif
+
+#if !RENDER_DISPLAY_LIST
+    stress_init();
+    reset_stress_stats();
+#endif
+
+#if UART_FB_STREAM
+    uart_stream_init(framebuffer);
+    uart_stream_set_enabled(true);
+#endif
+
+    if (!set_digits(DIGIT_BOOT_SCALE, DIGIT_BOOT_LAYOUT))
+        set_digits(1, LAYOUT_CENTRE);
+
+    uart_command_init(uart0, commands, sizeof(commands) / sizeof(commands[0]));
 
-    int number = 0;
     const uint64_t t0 = to_us_since_boot(get_absolute_time());
     uint64_t next_t = t0 + FRAME_INTERVAL_1;
     uint64_t start_t = t0;
@@ -215,13 +633,34 @@ int main(void)
 
         if (current_t > next_t)
         {
-            if (number == 0)
+            if (number % counter_modulus == 0 || clear_requested)
             {
                 reset_framebuffer_to_0();
+                clear_requested = false;
             }
 
-            update_framebuffer(number);
+#if !RENDER_DISPLAY_LIST
+            draw_stress_pattern(current_t - next_t);
+#endif
+            draw_digits(number);
+#if FRAME_ID_STRIP
+            draw_frame_id();
+#endif
             update_framebuffer_sync();
+#if UART_FB_STREAM
+            uart_stream_poll();
+#endif
+            mem_report_poll();
+            uart_command_poll();
+#if SCANOUT_STATS
+            scanout_poll_stats();
+#endif
+#if FRAME_CRC
+            scanout_poll_crc();
+#endif
+#if TMDS_CACHE
+            scanout_poll_tmds_cache();
+#endif
 
             number++;
             if (number >= MAX_NUMBER)
@@ -234,6 +673,10 @@ int main(void)
                 const uint64_t end_t = to_us_since_boot(get_absolute_time());
                 printf("Time for %d frames: %llu us\n", FRAME_COUNT_TARGET, end_t - start_t);
                 start_t = end_t;
+                report_digit_stats();
+#if !RENDER_DISPLAY_LIST
+                report_stress_stats();
+#endif
             }
 
             next_t += (number % 3 == 0) ? FRAME_INTERVAL_1 : FRAME_INTERVAL_2;
@@ -0,0 +1,181 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "display_mode.h"
+#include "stress.h"
+
+#define RAMP_LENGTH  256 // Pixels per cycle of the gradient
+#define BAR_WIDTH    16
+#define BAR_COUNT    8
+#define BAR_PERIOD   (BAR_WIDTH * BAR_COUNT)
+#define BAR_STEP     (BAR_WIDTH / 2) // Pixels per frame, so half the screen changes colour
+#define CHECKER_SIZE 8
+
+#if FRAME_WIDTH % (2 * CHECKER_SIZE) != 0
+#error "The checkerboard needs a frame width that is a multiple of twice its square size"
+#endif
+
+static const char* const names[STRESS_PATTERN_COUNT] = {"off", "gradient", "noise", "bars", "checker"};
+
+// Source lines, long enough that a window of FRAME_WIDTH pixels can start anywhere in the
+// first period. Offsets are kept even so every copy is word aligned.
+static uint16_t ramp[FRAME_WIDTH + RAMP_LENGTH] __attribute__((aligned(4)));
+static uint16_t bars[FRAME_WIDTH + BAR_PERIOD] __attribute__((aligned(4)));
+static uint16_t checker[2][FRAME_WIDTH] __attribute__((aligned(4)));
+static uint32_t noise_state = 2463534242u;
+
+static uint16_t rgb565(uint32_t r, uint32_t g, uint32_t b)
+{
+    return (uint16_t)((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+}
+
+// Fully saturated hue, 0 to 1535
+static uint16_t hue(uint32_t h)
+{
+    const uint32_t f = h & 255;
+    switch (h >> 8)
+    {
+    case 0:
+        return rgb565(255, f, 0);
+    case 1:
+        return rgb565(255 - f, 255, 0);
+    case 2:
+        return rgb565(0, 255, f);
+    case 3:
+        return rgb565(0, 255 - f, 255);
+    case 4:
+        return rgb565(f, 0, 255);
+    default:
+        return rgb565(255, 0, 255 - f);
+    }
+}
+
+void stress_init(void)
+{
+    static const uint16_t bar_colors[BAR_COUNT] = {0xFFFF, 0xFFE0, 0x07FF, 0x07E0, 0xF81F, 0xF800, 0x001F, 0x0000};
+
+    for (int x = 0; x < FRAME_WIDTH + RAMP_LENGTH; ++x)
+    {
+        ramp[x] = hue(x % RAMP_LENGTH * 6);
+    }
+    for (int x = 0; x < FRAME_WIDTH + BAR_PERIOD; ++x)
+    {
+        bars[x] = bar_colors[x % BAR_PERIOD / BAR_WIDTH];
+    }
+    for (int x = 0; x < FRAME_WIDTH; ++x)
+    {
+        const bool set = (x / CHECKER_SIZE) & 1;
+        checker[0][x] = set ? 0xFFFF : 0x0000;
+        checker[1][x] = set ? 0x0000 : 0xFFFF;
+    }
+}
+
+const char* stress_name(stress_pattern_t pattern)
+{
+    return pattern < STRESS_PATTERN_COUNT ? names[pattern] : "?";
+}
+
+bool stress_parse(const char* name, stress_pattern_t* pattern)
+{
+    for (int i = 0; i < STRESS_PATTERN_COUNT; ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *pattern = (stress_pattern_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void copy_line(uint16_t* dst, const uint16_t* src)
+{
+    memcpy(dst, src, FRAME_WIDTH * sizeof(uint16_t));
+}
+
+static void render_gradient(uint16_t* framebuffer, uint32_t frame)
+{
+    for (int y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        const uint32_t offset = (2 * frame + 2 * y) % RAMP_LENGTH;
+        copy_line(&framebuffer[y * FRAME_WIDTH], &ramp[offset]);
+    }
+}
+
+// Two pixels per xorshift32 step
+static void render_noise(uint16_t* framebuffer)
+{
+    uint32_t* words = (uint32_t*)framebuffer;
+    uint32_t state = noise_state;
+    for (int i = 0; i < FRAME_WIDTH * FRAME_HEIGHT / 2; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        words[i] = state;
+    }
+    noise_state = state;
+}
+
+static void render_bars(uint16_t* framebuffer, uint32_t frame)
+{
+    const uint16_t* line = &bars[BAR_PERIOD - BAR_STEP * frame % BAR_PERIOD];
+    for (int y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        copy_line(&framebuffer[y * FRAME_WIDTH], line);
+    }
+}
+
+static void render_checker(uint16_t* framebuffer, uint32_t frame)
+{
+    for (int y = 0; y < FRAME_HEIGHT; ++y)
+    {
+        copy_line(&framebuffer[y * FRAME_WIDTH], checker[(y / CHECKER_SIZE + frame) & 1]);
+    }
+}
+
+// Draw the pattern for the given frame over the whole framebuffer
+void stress_render(stress_pattern_t pattern, uint16_t* framebuffer, uint32_t frame)
+{
+    switch (pattern)
+    {
+    case STRESS_GRADIENT:
+        render_gradient(framebuffer, frame);
+        break;
+    case STRESS_NOISE:
+        render_noise(framebuffer);
+        break;
+    case STRESS_BARS:
+        render_bars(framebuffer, frame);
+        break;
+    case STRESS_CHECKER:
+        render_checker(framebuffer, frame);
+        break;
+    default:
+        break;
+    }
+}
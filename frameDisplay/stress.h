@@ -0,0 +1,60 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef STRESS_H
+#define STRESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Full-screen stress patterns for testing capture and compression bandwidth. The counter alone
+// changes a few hundred pixels per frame, the best case for any capture path. The patterns
+// here change most of the screen on every frame, with different amounts of structure for a
+// compressor to find:
+//
+// - gradient: a diagonal rainbow moving 2 pixels per frame, every line different
+// - noise: new random pixels every frame, nothing to compress
+// - bars: vertical colour bars scrolling half a bar per frame, every line the same
+// - checker: an 8x8 checkerboard inverted every frame
+//
+// Each kernel writes whole words, copying from a precomputed line where the pattern allows.
+
+typedef enum
+{
+    STRESS_OFF = 0,
+    STRESS_GRADIENT,
+    STRESS_NOISE,
+    STRESS_BARS,
+    STRESS_CHECKER,
+    STRESS_PATTERN_COUNT
+} stress_pattern_t;
+
+// Function declarations
+void stress_init(void);
+const char* stress_name(stress_pattern_t pattern);
+bool stress_parse(const char* name, stress_pattern_t* pattern);
+void stress_render(stress_pattern_t pattern, uint16_t* framebuffer, uint32_t frame);
+
+#endif // STRESS_H
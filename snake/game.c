@@ -0,0 +1,466 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+
+#include "game_state.h"
+#include "main.h"
+#include "rewind.h"
+
+// The game on screen. The rules live in game_state.c; this file draws what they change.
+static game_state_t game = {.joined = {true}, .random_state = GAME_DEFAULT_SEED};
+
+#if SMOOTH_MOTION
+// Cells drawn from the tick phase until the next move: the head grows into its new cell from
+// the side it entered, and the cell the tail just left shrinks towards the new tail
+static bool head_moving[MAX_PLAYERS];
+static direction_t head_side[MAX_PLAYERS];
+static bool tail_moving[MAX_PLAYERS];
+static uint8_t tail_x[MAX_PLAYERS];
+static uint8_t tail_y[MAX_PLAYERS];
+static direction_t tail_side[MAX_PLAYERS];
+#endif
+
+#if REWIND
+// The state at the start of every tick, for the "rewind" command
+static rewind_t history;
+static bool paused; // After a rewind, until the next steer or reset
+static bool have_loss;
+static uint32_t loss_tick; // Start of the last tick that lost a run
+#endif
+
+#if LOAD_GOVERNOR
+// Cells to draw from the grid, marked by resets, rewinds and players joining or leaving and
+// drawn by game_repaint(), a few rows per frame while the governor spreads repaints
+#define DIRTY_WORDS ((GRID_WIDTH + 31) / 32)
+static uint32_t dirty_cells[GRID_HEIGHT][DIRTY_WORDS];
+static bool repaint_pending;
+#endif
+
+// Since boot, for the "stats" command
+static uint32_t moves_played;
+static uint32_t food_eaten;
+static uint32_t runs_lost;
+
+static const uint16_t player_colors[4] = {SNAKE_COLOR, SNAKE_PALETTE_PLAYER2, SNAKE_PALETTE_PLAYER3, SNAKE_PALETTE_PLAYER4};
+
+static void draw_segment(uint8_t player, uint32_t i, uint16_t color)
+{
+    const uint32_t index = game_segment(&game, player, i);
+    draw_cell(game.body_x[player][index], game.body_y[player][index], color);
+}
+
+#if SMOOTH_MOTION
+// Side of the cell at (x, y) that faces the neighbouring cell at (to_x, to_y)
+static direction_t side_facing(int x, int y, int to_x, int to_y)
+{
+    if (to_x > x)
+        return DIRECTION_RIGHT;
+    if (to_x < x)
+        return DIRECTION_LEFT;
+    return to_y > y ? DIRECTION_DOWN : DIRECTION_UP;
+}
+
+// Finish the partly drawn cells of the last move
+static void settle_motion(uint8_t player)
+{
+    if (head_moving[player])
+    {
+        draw_segment(player, 0, player_colors[player]);
+        head_moving[player] = false;
+    }
+    // Someone else may have moved into the cell the tail left, or food may be there
+    if (tail_moving[player] && game.grid[tail_y[player]][tail_x[player]] == CELL_EMPTY)
+    {
+        draw_cell(tail_x[player], tail_y[player], BACKGROUND_COLOR);
+    }
+    tail_moving[player] = false;
+}
+
+void render_motion(uint32_t phase)
+{
+    const int filled = phase * BLOCK_SIZE / MOTION_PHASE_ONE;
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (head_moving[player])
+        {
+            const int head = game.head_index[player];
+            draw_partial_cell(game.body_x[player][head], game.body_y[player][head], head_side[player], filled,
+                              player_colors[player]);
+        }
+        if (tail_moving[player] && game.grid[tail_y[player]][tail_x[player]] == CELL_EMPTY)
+        {
+            draw_partial_cell(tail_x[player], tail_y[player], tail_side[player], BLOCK_SIZE - filled,
+                              player_colors[player]);
+        }
+    }
+}
+#endif
+
+#if FLASH_BACKGROUND
+// Draw the snakes and the food crossing scanline y over the background already in line
+void render_grid_line(uint16_t* line, int y)
+{
+    const uint8_t* row = game.grid[y / BLOCK_SIZE];
+    for (int x = 0; x < GRID_WIDTH; ++x)
+    {
+        const uint8_t cell = row[x];
+        if (cell == CELL_EMPTY || cell == CELL_WALL)
+            continue;
+
+        const uint16_t color = cell == CELL_FOOD ? FOOD_COLOR : player_colors[cell - 1];
+        uint32_t* dst = (uint32_t*)&line[x * BLOCK_SIZE];
+        for (int i = 0; i < BLOCK_SIZE / 2; ++i)
+        {
+            dst[i] = color * 0x00010001u;
+        }
+    }
+}
+#endif
+
+#if SCROLLING || REWIND || LOAD_GOVERNOR
+static uint16_t grid_color(uint8_t cell)
+{
+    if (cell == CELL_EMPTY)
+        return BACKGROUND_COLOR;
+    if (cell == CELL_WALL)
+        return BORDER_COLOR;
+    if (cell == CELL_FOOD)
+        return FOOD_COLOR;
+    return player_colors[cell - 1];
+}
+#endif
+
+#if SCROLLING
+// Colour of a world cell, for redrawing the parts of the world that scroll into view
+uint16_t cell_color(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= GRID_WIDTH || y >= GRID_HEIGHT)
+        return BACKGROUND_COLOR;
+    return grid_color(game.grid[y][x]);
+}
+
+bool snake_head(uint8_t player, int* x, int* y)
+{
+    if (!game.alive[player])
+        return false;
+
+    *x = game.body_x[player][game.head_index[player]];
+    *y = game.body_y[player][game.head_index[player]];
+    return true;
+}
+#endif
+
+#if LOAD_GOVERNOR
+static void mark_cell(int x, int y)
+{
+    dirty_cells[y][x / 32] |= 1u << (x % 32);
+    repaint_pending = true;
+}
+
+// Draw up to max_rows rows with marked cells. Returns true once nothing is left to draw.
+bool game_repaint(uint32_t max_rows)
+{
+    if (!repaint_pending)
+        return true;
+
+    uint32_t rows = 0;
+    for (int y = 0; y < GRID_HEIGHT; ++y)
+    {
+        bool marked = false;
+        for (int word = 0; word < DIRTY_WORDS; ++word)
+        {
+            marked |= dirty_cells[y][word] != 0;
+        }
+        if (!marked)
+            continue;
+        if (rows++ == max_rows)
+            return false;
+
+        for (int word = 0; word < DIRTY_WORDS; ++word)
+        {
+            for (uint32_t bits = dirty_cells[y][word]; bits; bits &= bits - 1)
+            {
+                const int x = word * 32 + __builtin_ctz(bits);
+                draw_cell(x, y, grid_color(game.grid[y][x]));
+            }
+            dirty_cells[y][word] = 0;
+        }
+    }
+
+    repaint_pending = false;
+    return true;
+}
+#endif
+
+// Cells that change together in large numbers are only marked with the load governor, the grid
+// has their colour by the time game_repaint() draws them
+static void repaint_cell(int x, int y, uint16_t color)
+{
+#if LOAD_GOVERNOR
+    mark_cell(x, y);
+#else
+    draw_cell(x, y, color);
+#endif
+}
+
+static void draw_player(uint8_t player)
+{
+    for (uint32_t i = 0; i < game.snake_length[player]; ++i)
+    {
+        const uint32_t index = game_segment(&game, player, i);
+        repaint_cell(game.body_x[player][index], game.body_y[player][index], player_colors[player]);
+    }
+}
+
+static void remove_player(uint8_t player)
+{
+#if SMOOTH_MOTION
+    settle_motion(player);
+#endif
+    for (uint32_t i = 0; i < game.snake_length[player]; ++i)
+    {
+        const uint32_t index = game_segment(&game, player, i);
+        repaint_cell(game.body_x[player][index], game.body_y[player][index], BACKGROUND_COLOR);
+    }
+    game_state_remove(&game, player);
+}
+
+void reset_game()
+{
+    // Clear the snakes and the food from the screen
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        remove_player(player);
+    }
+    if (game.grid[game.food_y][game.food_x] == CELL_FOOD)
+    {
+        repaint_cell(game.food_x, game.food_y, BACKGROUND_COLOR);
+    }
+
+    game_state_reset(&game);
+#if REWIND
+    paused = false;
+#endif
+    draw_border();
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        draw_player(player);
+    }
+    repaint_cell(game.food_x, game.food_y, FOOD_COLOR);
+
+    log_event("Game reset\r\n");
+}
+
+// End the player's run. With a single player the whole game restarts.
+static void player_lost(uint8_t player, move_result_t result)
+{
+    const char* reason = result == MOVE_HIT_WALL    ? "Collision with border"
+                         : result == MOVE_HIT_SELF  ? "Collision with itself"
+                         : result == MOVE_HIT_OTHER ? "Collision with another snake"
+                                                    : "Maximum snake length reached!";
+#if REWIND
+    have_loss = true;
+    loss_tick = history.next_tick - 1;
+#endif
+    ++runs_lost;
+#if MAX_PLAYERS == 1
+    log_event("%s\r\n", reason);
+    reset_game();
+#else
+    log_event("Player %d: %s\r\n", player + 1, reason);
+    remove_player(player);
+#endif
+}
+
+static void move_player(uint8_t player)
+{
+#if SMOOTH_MOTION
+    if (game.alive[player])
+        settle_motion(player);
+#endif
+
+    move_t move;
+    game_state_move(&game, player, &move);
+
+    if (move.result == MOVE_NONE)
+        return;
+    if (move.result == MOVE_SPAWNED)
+    {
+        draw_player(player);
+        return;
+    }
+    if (game_is_lost(move.result))
+    {
+        player_lost(player, move.result);
+        return;
+    }
+
+    ++moves_played;
+    if (move.result == MOVE_ATE)
+    {
+        ++food_eaten;
+        log_event("Food eaten\r\n");
+    }
+    else
+    {
+        // Clear the cell the tail left
+#if SMOOTH_MOTION
+        const uint32_t new_tail = game_segment(&game, player, game.snake_length[player] - 1);
+        tail_moving[player] = true;
+        tail_x[player] = move.tail_x;
+        tail_y[player] = move.tail_y;
+        tail_side[player] =
+            side_facing(move.tail_x, move.tail_y, game.body_x[player][new_tail], game.body_y[player][new_tail]);
+#else
+        draw_cell(move.tail_x, move.tail_y, BACKGROUND_COLOR);
+#endif
+    }
+
+    // Only the new head cell needs drawing
+#if SMOOTH_MOTION
+    const uint32_t head = game.head_index[player];
+    const uint32_t neck = game_segment(&game, player, 1);
+    head_moving[player] = true;
+    head_side[player] =
+        side_facing(game.body_x[player][head], game.body_y[player][head], game.body_x[player][neck],
+                    game.body_y[player][neck]);
+#else
+    draw_segment(player, 0, player_colors[player]);
+#endif
+
+    if (move.result == MOVE_ATE)
+        draw_cell(game.food_x, game.food_y, FOOD_COLOR);
+}
+
+void move_snake()
+{
+#if REWIND
+    if (paused)
+        return;
+    rewind_push(&history, &game);
+#endif
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        move_player(player);
+    }
+}
+
+void steer_snake(uint8_t player, direction_t new_direction)
+{
+    if (player >= MAX_PLAYERS)
+        return;
+    game_state_steer(&game, player, new_direction);
+#if REWIND
+    paused = false;
+#endif
+}
+
+void player_join(uint8_t player)
+{
+    if (player >= MAX_PLAYERS || game.joined[player])
+        return;
+
+    log_event("Player %d joined\r\n", player + 1);
+    game.joined[player] = true;
+    if (game_state_spawn(&game, player))
+        draw_player(player);
+}
+
+void player_leave(uint8_t player)
+{
+    // Player 0 keeps playing without a keyboard, as in single player mode
+    if (player == 0 || player >= MAX_PLAYERS || !game.joined[player])
+        return;
+
+    log_event("Player %d left\r\n", player + 1);
+    game.joined[player] = false;
+    if (game.alive[player])
+        remove_player(player);
+}
+
+#if REWIND
+// Put the game back to the start of a recorded tick and redraw every cell. The game waits there
+// until the next steer, and play goes on from that tick.
+static bool rewind_to(uint32_t tick)
+{
+    if (!rewind_restore(&history, tick, &game))
+        return false;
+    if (have_loss && loss_tick >= tick)
+        have_loss = false; // Forgotten, the ticks from here on are recorded again
+
+#if SMOOTH_MOTION
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        head_moving[player] = false;
+        tail_moving[player] = false;
+    }
+#endif
+    for (int y = 0; y < GRID_HEIGHT; ++y)
+    {
+        for (int x = 0; x < GRID_WIDTH; ++x)
+        {
+            repaint_cell(x, y, grid_color(game.grid[y][x]));
+        }
+    }
+
+    paused = true;
+    printf("Rewound to tick %lu, steer to play on\r\n", (unsigned long)tick);
+    return true;
+}
+
+// Go back the given number of ticks, 1 being the start of the last tick played
+bool game_rewind(uint32_t ticks)
+{
+    return ticks > 0 && ticks <= rewind_ticks(&history) && rewind_to(history.next_tick - ticks);
+}
+
+// Go back to just before the move that lost the last run
+bool game_rewind_to_loss(void)
+{
+    return have_loss && rewind_to(loss_tick);
+}
+#endif
+
+void game_print_stats(void)
+{
+    static const char* const directions[] = {"up", "right", "down", "left", "none"};
+    printf("Game: %lu moves, %lu food eaten, %lu runs lost, food at %d,%d\r\n", (unsigned long)moves_played,
+           (unsigned long)food_eaten, (unsigned long)runs_lost, game.food_x, game.food_y);
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (!game.joined[player])
+            continue;
+        const int head = game.head_index[player];
+        printf("Player %d: %s, length %d, head %d,%d, heading %s\r\n", player + 1,
+               game.alive[player] ? "playing" : "waiting", game.snake_length[player], game.body_x[player][head],
+               game.body_y[player][head], directions[game.direction[player]]);
+    }
+#if REWIND
+    printf("Rewind: %lu ticks kept in %u bytes, %lu keyframes, %lu deltas%s\r\n",
+           (unsigned long)rewind_ticks(&history), REWIND_BUFFER_BYTES, (unsigned long)history.keyframes_written,
+           (unsigned long)history.deltas_written, paused ? ", paused" : "");
+#endif
+}
@@ -0,0 +1,227 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "game_state.h"
+
+// Rows between the spawn positions of consecutive players
+#define PLAYER_SPAWN_SPACING ((GRID_HEIGHT - 1 - INITIAL_SNAKE_Y) / MAX_PLAYERS)
+
+static uint32_t next_random(game_state_t* game)
+{
+    game->random_state ^= game->random_state << 13;
+    game->random_state ^= game->random_state >> 17;
+    game->random_state ^= game->random_state << 5;
+    return game->random_state;
+}
+
+// Pick a random free cell inside the border
+static void place_food(game_state_t* game)
+{
+    do
+    {
+        game->food_x = next_random(game) % GRID_WIDTH;
+        game->food_y = next_random(game) % GRID_HEIGHT;
+    } while (game->grid[game->food_y][game->food_x] != CELL_EMPTY);
+
+    game->grid[game->food_y][game->food_x] = CELL_FOOD;
+}
+
+// An empty game with only player 0 joined. Call game_state_reset() to start it.
+void game_state_init(game_state_t* game, uint32_t seed)
+{
+    memset(game, 0, sizeof(*game));
+    game->joined[0] = true; // Player 0 always plays
+    game->random_state = seed ? seed : GAME_DEFAULT_SEED;
+}
+
+// Empty the grid inside the border walls, without touching the players or the food
+void game_state_clear_grid(game_state_t* game)
+{
+    for (int y = 0; y < GRID_HEIGHT; ++y)
+    {
+        for (int x = 0; x < GRID_WIDTH; ++x)
+        {
+            const bool wall = x == 0 || y == 0 || x == GRID_WIDTH - 1 || y == GRID_HEIGHT - 1;
+            game->grid[y][x] = wall ? CELL_WALL : CELL_EMPTY;
+        }
+    }
+}
+
+// Clear the grid to the border walls, spawn every joined player and put the food back at its
+// start position
+void game_state_reset(game_state_t* game)
+{
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        game->snake_length[player] = 0;
+        game->alive[player] = false;
+    }
+    ++game->epoch;
+    game_state_clear_grid(game);
+
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (game->joined[player])
+            game_state_spawn(game, player);
+    }
+
+    game->food_x = INITIAL_FOOD_X;
+    game->food_y = INITIAL_FOOD_Y;
+    if (game->grid[game->food_y][game->food_x] == CELL_EMPTY)
+        game->grid[game->food_y][game->food_x] = CELL_FOOD;
+    else
+        place_food(game);
+}
+
+// Place the player at its spawn position, if it is free
+bool game_state_spawn(game_state_t* game, uint8_t player)
+{
+    const int y = INITIAL_SNAKE_Y + player * PLAYER_SPAWN_SPACING;
+    for (int i = 0; i < INITIAL_SNAKE_LENGTH; ++i)
+    {
+        if (game->grid[y][INITIAL_SNAKE_X - i] != CELL_EMPTY)
+            return false;
+    }
+
+    game->head_index[player] = 0;
+    game->snake_length[player] = INITIAL_SNAKE_LENGTH;
+    game->direction[player] = INITIAL_SNAKE_DIRECTION;
+    for (int i = 0; i < INITIAL_SNAKE_LENGTH; ++i)
+    {
+        game->body_x[player][i] = INITIAL_SNAKE_X - i;
+        game->body_y[player][i] = y;
+        game->grid[y][INITIAL_SNAKE_X - i] = player + 1;
+    }
+    game->alive[player] = true;
+    ++game->epoch;
+    return true;
+}
+
+// Take the player's body off the grid
+void game_state_remove(game_state_t* game, uint8_t player)
+{
+    for (uint32_t i = 0; i < game->snake_length[player]; ++i)
+    {
+        const uint32_t index = game_segment(game, player, i);
+        game->grid[game->body_y[player][index]][game->body_x[player][index]] = CELL_EMPTY;
+    }
+    game->snake_length[player] = 0;
+    game->alive[player] = false;
+    ++game->epoch;
+}
+
+// Advance the player by one cell, or respawn it once its spawn position is clear. A player who
+// loses stays on the grid until the caller removes it or resets the game.
+void game_state_move(game_state_t* game, uint8_t player, move_t* move)
+{
+    if (!game->alive[player])
+    {
+        move->result = game->joined[player] && game_state_spawn(game, player) ? MOVE_SPAWNED : MOVE_NONE;
+        return;
+    }
+
+    if (game->snake_length[player] >= MAX_SNAKE_LENGTH)
+    {
+        move->result = MOVE_MAX_LENGTH;
+        return;
+    }
+
+    const int head = game->head_index[player];
+    int next_x = game->body_x[player][head];
+    int next_y = game->body_y[player][head];
+
+    // Determine next position based on the current direction
+    switch (game->direction[player])
+    {
+    case DIRECTION_UP:
+        next_y -= 1;
+        break;
+    case DIRECTION_RIGHT:
+        next_x += 1;
+        break;
+    case DIRECTION_DOWN:
+        next_y += 1;
+        break;
+    case DIRECTION_LEFT:
+        next_x -= 1;
+        break;
+    default:
+        break;
+    }
+
+    const uint8_t cell = game->grid[next_y][next_x];
+    if (cell == CELL_WALL)
+    {
+        move->result = MOVE_HIT_WALL;
+        return;
+    }
+    if (cell != CELL_EMPTY && cell != CELL_FOOD)
+    {
+        move->result = cell == player + 1 ? MOVE_HIT_SELF : MOVE_HIT_OTHER;
+        return;
+    }
+
+    if (cell == CELL_FOOD)
+    {
+        move->result = MOVE_ATE;
+        game->snake_length[player]++;
+    }
+    else
+    {
+        // Clear the last segment of the snake if it didn't just eat food
+        const int tail = (head + game->snake_length[player] - 1) % MAX_SNAKE_LENGTH;
+        move->result = MOVE_STEP;
+        move->tail_x = game->body_x[player][tail];
+        move->tail_y = game->body_y[player][tail];
+        game->grid[move->tail_y][move->tail_x] = CELL_EMPTY;
+    }
+
+    // Move the head forward
+    const int new_head = (head + MAX_SNAKE_LENGTH - 1) % MAX_SNAKE_LENGTH;
+    game->head_index[player] = new_head;
+    game->body_x[player][new_head] = next_x;
+    game->body_y[player][new_head] = next_y;
+    game->grid[next_y][next_x] = player + 1;
+
+    if (cell == CELL_FOOD)
+        place_food(game);
+}
+
+void game_state_steer(game_state_t* game, uint8_t player, direction_t new_direction)
+{
+    const direction_t current = game->direction[player];
+
+    // Only update the direction if it does not reverse the snake onto itself
+    if (new_direction != DIRECTION_UNKNOWN &&
+        !((new_direction == DIRECTION_UP && current == DIRECTION_DOWN) ||    // Up to Down
+          (new_direction == DIRECTION_DOWN && current == DIRECTION_UP) ||    // Down to Up
+          (new_direction == DIRECTION_RIGHT && current == DIRECTION_LEFT) || // Right to Left
+          (new_direction == DIRECTION_LEFT && current == DIRECTION_RIGHT)))  // Left to Right
+    {
+        game->direction[player] = new_direction;
+    }
+}
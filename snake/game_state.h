@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef GAME_STATE_H
+#define GAME_STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "main.h"
+
+// Snake rules on a self-contained game state, with no drawing and no globals, so any number of
+// games can run side by side: one on the Pico (game.c draws it), thousands in the host batch
+// engine (tools/snake_batch.h).
+
+// Occupancy grid values. Cells occupied by a snake hold the player number plus one.
+#define CELL_EMPTY 0x00
+#define CELL_WALL  0xfe
+#define CELL_FOOD  0xff
+
+#if MAX_PLAYERS > 4
+#error "At most 4 players are supported"
+#endif
+
+// Outcome of one player's move
+typedef enum
+{
+    MOVE_NONE = 0,       // Not playing, or waiting for the spawn position to clear
+    MOVE_STEP,           // Moved, the tail left tail_x, tail_y
+    MOVE_ATE,            // Moved onto the food and grew, new food has been placed
+    MOVE_SPAWNED,        // Respawned at the spawn position
+    MOVE_HIT_WALL,       // Lost, the player is still on the grid
+    MOVE_HIT_SELF,
+    MOVE_HIT_OTHER,
+    MOVE_MAX_LENGTH
+} move_result_t;
+
+typedef struct
+{
+    move_result_t result;
+    uint8_t tail_x;
+    uint8_t tail_y;
+} move_t;
+
+typedef struct
+{
+    // Shared occupancy grid, used for collisions between all snakes, the border and the food
+    uint8_t grid[GRID_HEIGHT][GRID_WIDTH];
+
+    // Player state in structure-of-arrays form, indexed by player. Each body is a ring buffer
+    // where segment i lives at (head_index + i) % MAX_SNAKE_LENGTH, so a move only touches
+    // the head and tail cells.
+    uint8_t body_x[MAX_PLAYERS][MAX_SNAKE_LENGTH];
+    uint8_t body_y[MAX_PLAYERS][MAX_SNAKE_LENGTH];
+    uint8_t head_index[MAX_PLAYERS];
+    uint8_t snake_length[MAX_PLAYERS];
+    direction_t direction[MAX_PLAYERS];
+    bool joined[MAX_PLAYERS];
+    bool alive[MAX_PLAYERS];
+
+    uint8_t food_x;
+    uint8_t food_y;
+    uint32_t random_state; // xorshift32, so every C library places the food the same way
+
+    // Bumped by every change other than a move or a steer: reset, spawn and remove. The rewind
+    // buffer (rewind.h) writes a keyframe when it changes and a small delta otherwise.
+    uint32_t epoch;
+} game_state_t;
+
+// Seed the Pico's game starts from
+#define GAME_DEFAULT_SEED 2463534242u
+
+static inline bool game_is_lost(move_result_t result)
+{
+    return result >= MOVE_HIT_WALL;
+}
+
+// Segment i of a player's body, counted from the head
+static inline uint32_t game_segment(const game_state_t* game, uint8_t player, uint32_t i)
+{
+    return (game->head_index[player] + i) % MAX_SNAKE_LENGTH;
+}
+
+// Function declarations
+void game_state_init(game_state_t* game, uint32_t seed);
+void game_state_reset(game_state_t* game);
+void game_state_clear_grid(game_state_t* game);
+bool game_state_spawn(game_state_t* game, uint8_t player);
+void game_state_remove(game_state_t* game, uint8_t player);
+void game_state_move(game_state_t* game, uint8_t player, move_t* move);
+void game_state_steer(game_state_t* game, uint8_t player, direction_t new_direction);
+
+#endif // GAME_STATE_H
@@ -24,6 +24,7 @@
  */
 
 #include "bsp/board.h"
+#include "latency.h"
 #include "main.h"
 #include "tusb.h"
 
@@ -39,6 +40,18 @@
 
 static uint8_t const keycode2ascii[128][2] = {HID_KEYCODE_TO_ASCII};
 
+#if MAX_PLAYERS > CFG_TUH_HID
+#error "Each player needs its own HID interface"
+#endif
+
+// Keyboard assigned to each player, by device address and HID instance
+static struct
+{
+    bool assigned;
+    uint8_t dev_addr;
+    uint8_t instance;
+} player_keyboards[MAX_PLAYERS];
+
 // Each HID instance can has multiple reports
 static struct
 {
@@ -56,6 +69,33 @@ void hid_app_task(void)
     // nothing to do
 }
 
+// Return the player steered by this keyboard, assigning the next free player to a new keyboard.
+// With a single player every keyboard steers the same snake.
+static int player_for_keyboard(uint8_t dev_addr, uint8_t instance)
+{
+    for (int player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (player_keyboards[player].assigned && player_keyboards[player].dev_addr == dev_addr &&
+            player_keyboards[player].instance == instance)
+            return player;
+    }
+
+    for (int player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (!player_keyboards[player].assigned)
+        {
+            player_keyboards[player].assigned = true;
+            player_keyboards[player].dev_addr = dev_addr;
+            player_keyboards[player].instance = instance;
+            log_event("Keyboard %d/%d steers player %d\r\n", dev_addr, instance, player + 1);
+            player_join(player);
+            return player;
+        }
+    }
+
+    return MAX_PLAYERS == 1 ? 0 : -1;
+}
+
 //--------------------------------------------------------------------+
 // TinyUSB Callbacks
 //--------------------------------------------------------------------+
@@ -67,13 +107,13 @@ void hid_app_task(void)
 // therefore report_desc = NULL, desc_len = 0
 void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* desc_report, uint16_t desc_len)
 {
-    printf("HID device address = %d, instance = %d is mounted\r\n", dev_addr, instance);
+    log_event("HID device address = %d, instance = %d is mounted\r\n", dev_addr, instance);
 
     // Interface protocol (hid_interface_protocol_enum_t)
     const char* protocol_str[] = {"None", "Keyboard", "Mouse"};
     uint8_t const itf_protocol = tuh_hid_interface_protocol(dev_addr, instance);
 
-    printf("HID Interface Protocol = %s\r\n", protocol_str[itf_protocol]);
+    log_event("HID Interface Protocol = %s\r\n", protocol_str[itf_protocol]);
 
     // By default host stack will use activate boot protocol on supported interface.
     // Therefore for this simple example, we only need to parse generic report descriptor (with built-in parser)
@@ -81,7 +121,7 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* desc_re
     {
         hid_info[instance].report_count =
             tuh_hid_parse_report_descriptor(hid_info[instance].report_info, MAX_REPORT, desc_report, desc_len);
-        printf("HID has %u reports \r\n", hid_info[instance].report_count);
+        log_event("HID has %u reports \r\n", hid_info[instance].report_count);
     }
 
     // request to receive report
@@ -95,12 +135,31 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* desc_re
 // Invoked when device with hid interface is un-mounted
 void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance)
 {
-    printf("HID device address = %d, instance = %d is unmounted\r\n", dev_addr, instance);
+    log_event("HID device address = %d, instance = %d is unmounted\r\n", dev_addr, instance);
+
+    // Free the player slot for the next keyboard
+    for (int player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (player_keyboards[player].assigned && player_keyboards[player].dev_addr == dev_addr &&
+            player_keyboards[player].instance == instance)
+        {
+            player_keyboards[player].assigned = false;
+            player_leave(player);
+        }
+    }
 }
 
 // Invoked when received report from device via interrupt endpoint
 void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report, uint16_t len)
 {
+#if LATENCY_TEST
+    // Timestamp key presses before anything else, releases carry no key code
+    if ((len == 8 && report[2] != 0) || (len == 9 && report[3] != 0))
+    {
+        latency_key_event();
+    }
+#endif
+
     uint8_t const itf_protocol = tuh_hid_interface_protocol(dev_addr, instance);
 
     switch (itf_protocol)
@@ -176,26 +235,31 @@ void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t cons
         break;
     case 0x29: // 'ESC'
         reset_game();
-        printf("RESET GAME\r\n");
+        log_event("RESET GAME\r\n");
+        break;
+#if MSC_CAPTURE
+    case 0x45: // 'F12'
+        msc_app_screenshot();
+        break;
+    case 0x44: // 'F11'
+        msc_app_toggle_recording();
+        break;
+#endif
     default:
         break;
     }
 
-    // Check if the new direction is directly opposite to the current direction
-    if (new_direction != DIRECTION_UNKNOWN &&
-        !((new_direction == DIRECTION_UP && snake_direction == DIRECTION_DOWN) ||    // Up to Down
-          (new_direction == DIRECTION_DOWN && snake_direction == DIRECTION_UP) ||    // Down to Up
-          (new_direction == DIRECTION_RIGHT && snake_direction == DIRECTION_LEFT) || // Right to Left
-          (new_direction == DIRECTION_LEFT && snake_direction == DIRECTION_RIGHT)))  // Left to Right
+    // Route the key to the snake of the keyboard it came from
+    if (new_direction != DIRECTION_UNKNOWN)
     {
-        // Only update and move snake if not reversing direction
-        if (new_direction != snake_direction)
+        const int player = player_for_keyboard(dev_addr, instance);
+        if (player >= 0)
         {
-            snake_direction = new_direction;
+            steer_snake(player, new_direction);
         }
     }
 
-    printf("Keycode: %02X\r\n", keycode);
+    log_event("Keycode: %02X\r\n", keycode);
 
     static bool led_state = true; // added
     led_state = !led_state;       // added
@@ -23,6 +23,7 @@
  *
  */
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -42,46 +43,140 @@
 #include "tmds_encode.h"
 #include "tusb.h"
 
+#if LIB_PICO_STDIO_UART
+#include "pico/stdio/driver.h"
+#include "pico/stdio_uart.h"
+#endif
+
+#include "background.h"
+#include "console.h"
+#include "display_mode.h"
+#include "governor.h"
+#include "latency.h"
 #include "main.h"
+#include "mem_report.h"
+#include "renderer.h"
+#include "row_intern.h"
+#include "scanout.h"
+#include "scroll_ring.h"
+#include "uart_command.h"
+#include "uart_stream.h"
+
+#if FLASH_BACKGROUND
+#include "snake_background.h"
+#endif
+
+#if LOG_CONSOLE
+#include "console_font.h"
+#endif
+
+#if DISPLAY_MODE == DISPLAY_MODE_640x480
+#error "The snake framebuffer does not fit in SRAM at 640x480"
+#endif
 
 // Display settings
-#define FRAME_WIDTH  320
-#define FRAME_HEIGHT 240
 #define VREG_VSEL    VREG_VOLTAGE_1_20
 #define DVI_TIMING   dvi_timing_640x480p_60hz
 
-// Colors and block sizes
-#define BLOCK_SIZE       8 // Multiple of 8
-#define BORDER_SIZE      BLOCK_SIZE
-#define BORDER_COLOR     0x3bbb // Blue color in RGB565
-#define BACKGROUND_COLOR 0x9f53 // Light green color in RGB565
-#define SNAKE_COLOR      0x1ca3 // Green color in RGB565
-#define FOOD_COLOR       0xfaca // Red color in RGB565
-
-// Snake game settings
-#define SNAKE_MOVE_INTERVAL_MS  250
-#define INITIAL_SNAKE_LENGTH    5
-#define INITIAL_SNAKE_X         10
-#define INITIAL_SNAKE_Y         5
-#define INITIAL_FOOD_X          10
-#define INITIAL_FOOD_Y          10
-#define INITIAL_SNAKE_DIRECTION DIRECTION_RIGHT
+// Stream the framebuffer over UART, see common/uart_stream.h
+#ifndef UART_FB_STREAM
+#define UART_FB_STREAM 0
+#endif
+
+#if LOAD_GOVERNOR && UART_FB_STREAM
+#error "The load governor and UART streaming both take over stdio's UART output"
+#endif
 
 // DVI instance
 struct dvi_inst dvi0;
 
+#if FLASH_BACKGROUND
+#if SMOOTH_MOTION || LATENCY_TEST || UART_FB_STREAM || MSC_CAPTURE || ROW_INTERNING
+#error "Smooth motion, the latency test, UART streaming, USB drive capture and row interning need the RAM framebuffer"
+#endif
+#if SNAKE_BACKGROUND_WIDTH != FRAME_WIDTH || SNAKE_BACKGROUND_HEIGHT != FRAME_HEIGHT
+#error "assets/background.png does not match the display mode"
+#endif
+
+static const background_t background = BACKGROUND_ASSET(snake_background, SNAKE_BACKGROUND);
+
+// Longest time taken to decode and composite one line, in microseconds
+static uint32_t max_line_us;
+static uint32_t rendered_frames;
+#elif SCROLLING
+#if ROW_INTERNING
+#error "Row interning and the scrolling world cannot be combined"
+#endif
+#if LATENCY_TEST || UART_FB_STREAM || MSC_CAPTURE
+#error "The latency test, UART streaming and USB drive capture need the linear framebuffer"
+#endif
+
+// The screen's window onto the world: a ring of lines plus a mirror of the first one, and a
+// pointer to the start of every screen line
+static uint16_t framebuffer[(FRAME_HEIGHT + 1) * FRAME_WIDTH] __attribute__((aligned(4)));
+static const uint16_t* scan_lines[FRAME_HEIGHT];
+static scroll_ring_t view;
+#elif ROW_INTERNING
+#if LATENCY_TEST || UART_FB_STREAM || MSC_CAPTURE
+#error "The latency test, UART streaming and USB drive capture need the linear framebuffer"
+#endif
+
+// No framebuffer: every screen row points into a pool of shared row buffers
+ROW_INTERN_STORAGE(row_pool, FRAME_WIDTH, FRAME_HEIGHT, ROW_INTERN_POOL_ROWS);
+static row_intern_t rows;
+static uint32_t rendered_frames;
+#else
 // Framebuffer
 static uint16_t framebuffer[FRAME_HEIGHT * FRAME_WIDTH];
+#endif
+
+#if COPPER_GRADIENT
+#if FLASH_BACKGROUND || SCROLLING || ROW_INTERNING || LOG_CONSOLE || LATENCY_TEST
+#error "The copper gradient needs frames pushed straight from the linear framebuffer"
+#endif
+
+// One palette command per cell row, replacing the background colour
+static copper_command_t copper_list[GRID_HEIGHT];
 
-// Snake and game state
-static int snake_x[MAX_SNAKE_LENGTH];
-static int snake_y[MAX_SNAKE_LENGTH];
-static int snake_length;
-direction_t snake_direction;
-static int food_x;
-static int food_y;
-static bool update_snake = false;
+// Scale each RGB565 channel of the background colour from full at the top to
+// COPPER_GRADIENT_BOTTOM / 256 on the last row
+static void build_copper_gradient(void)
+{
+    const uint32_t r = BACKGROUND_COLOR >> 11, g = (BACKGROUND_COLOR >> 5) & 0x3f, b = BACKGROUND_COLOR & 0x1f;
+    for (int row = 0; row < GRID_HEIGHT; ++row)
+    {
+        const uint32_t scale = 256 - (256 - COPPER_GRADIENT_BOTTOM) * row / (GRID_HEIGHT - 1);
+        const uint16_t colour = (uint16_t)((r * scale >> 8) << 11 | (g * scale >> 8) << 5 | (b * scale >> 8));
+        copper_list[row] = (copper_command_t)COPPER_PALETTE_AT(row * BLOCK_SIZE, BACKGROUND_COLOR, colour);
+    }
+}
+#endif
+
+#if LOG_CONSOLE
+#if FLASH_BACKGROUND || SCROLLING || ROW_INTERNING
+#error "The log console cannot be combined with the flash background, scrolling or row interning"
+#endif
+#if LATENCY_TEST || UART_FB_STREAM || MSC_CAPTURE
+#error "The latency test, UART streaming and USB drive capture need the framebuffer in screen order"
+#endif
+#if CONSOLE_FONT_HEIGHT != BLOCK_SIZE || PLAYFIELD_HEIGHT + LOG_CONSOLE_ROWS * BLOCK_SIZE != FRAME_HEIGHT
+#error "Each console row must take the place of one row of cells"
+#endif
+#if GRID_HEIGHT < INITIAL_FOOD_Y + 2
+#error "The playfield left over by the log console is too small in this display mode"
+#endif
+
+// The framebuffer rows under the playfield are the console's text strips, shown in the order the
+// console has scrolled them to through the screen line pointers
+static const uint16_t* scan_lines[FRAME_HEIGHT];
+static const console_font_t log_font = CONSOLE_FONT_ASSET(console_font, CONSOLE_FONT);
+static console_t log_console;
+#endif
+
+// Set by the timer when the snakes are due to move
 static bool move_snake_flag = false;
+static struct repeating_timer move_timer;
+static uint32_t move_interval_ms = SNAKE_MOVE_INTERVAL_MS;
 
 bool repeating_timer_callback(struct repeating_timer* t)
 {
@@ -89,232 +184,369 @@ bool repeating_timer_callback(struct repeating_timer* t)
     return true;
 }
 
+// Restart the move timer with a new interval, from the "tick" command
+void set_move_interval(uint32_t interval_ms)
+{
+    cancel_repeating_timer(&move_timer);
+    move_interval_ms = interval_ms;
+    add_repeating_timer_ms(interval_ms, repeating_timer_callback, NULL, &move_timer);
+}
+
 void core1_main()
 {
     dvi_register_irqs_this_core(&dvi0, DMA_IRQ_0);
     while (queue_is_empty(&dvi0.q_colour_valid))
         __wfe();
     dvi_start(&dvi0);
+#if TMDS_CACHE
+    scanout_tmds_cache_main(&dvi0);
+#else
     dvi_scanbuf_main_16bpp(&dvi0);
+#endif
 }
 
+#if FLASH_BACKGROUND
+// The border and background come from flash and the snakes and food from the occupancy grid,
+// both fetched as each line is scanned out, so there is nothing to draw ahead of time
 void initialize_framebuffer()
 {
-    for (uint y = 0; y < FRAME_HEIGHT; ++y)
-    {
-        for (uint x = 0; x < FRAME_WIDTH; ++x)
-        {
-            framebuffer[y * FRAME_WIDTH + x] = BACKGROUND_COLOR;
-        }
-    }
 }
 
 void draw_border()
 {
-    // Top border
-    for (uint y = 0; y < BORDER_SIZE; ++y)
-    {
-        for (uint x = 0; x < FRAME_WIDTH; ++x)
-        {
-            framebuffer[y * FRAME_WIDTH + x] = BORDER_COLOR;
-        }
-    }
+}
 
-    // Bottom border
-    for (uint y = FRAME_HEIGHT - BORDER_SIZE; y < FRAME_HEIGHT; ++y)
-    {
-        for (uint x = 0; x < FRAME_WIDTH; ++x)
-        {
-            framebuffer[y * FRAME_WIDTH + x] = BORDER_COLOR;
-        }
-    }
+void draw_cell(int x, int y, uint16_t color)
+{
+}
 
-    // Left border
-    for (uint y = BORDER_SIZE; y < FRAME_HEIGHT - BORDER_SIZE; ++y)
+// Build every line just in time: decode the background row, then draw the grid over it
+static void render_frame(void)
+{
+    for (uint y = 0; y < FRAME_HEIGHT; ++y)
     {
-        for (uint x = 0; x < BORDER_SIZE; ++x)
-        {
-            framebuffer[y * FRAME_WIDTH + x] = BORDER_COLOR;
-        }
+        uint16_t* line = scanout_acquire_line();
+        const uint32_t start = time_us_32();
+        background_decode_line(&background, y, line);
+        render_grid_line(line, y);
+        const uint32_t elapsed = time_us_32() - start;
+        if (elapsed > max_line_us)
+            max_line_us = elapsed;
+        scanout_commit_line(line);
     }
 
-    // Right border
-    for (uint y = BORDER_SIZE; y < FRAME_HEIGHT - BORDER_SIZE; ++y)
+    if (++rendered_frames == RENDER_REPORT_FRAMES)
     {
-        for (uint x = FRAME_WIDTH - BORDER_SIZE; x < FRAME_WIDTH; ++x)
-        {
-            framebuffer[y * FRAME_WIDTH + x] = BORDER_COLOR;
-        }
+        printf("Background: longest line %lu us, at most %u runs per row\r\n", (unsigned long)max_line_us,
+               SNAKE_BACKGROUND_MAX_ROW_RUNS);
+        rendered_frames = 0;
+        max_line_us = 0;
     }
 }
+#else
+#if SCROLLING
+// Fill a rectangle given in world pixels, clipped to the view
+static void fill_rect(int x, int y, int width, int height, uint16_t color)
+{
+    scroll_ring_fill(&view, x - view.scroll_x, y - view.scroll_y, width, height, color);
+}
 
-void set_pixel(uint16_t* buffer, int x, int y, uint16_t color)
+static int clamp(int value, int low, int high)
 {
-    buffer[y * FRAME_WIDTH + x] = color;
+    return value < low ? low : value > high ? high : value;
 }
 
-void draw_block(uint16_t* buffer, int x, int y, uint16_t color)
+// Redraw a stale part of the view from the occupancy grid, cell by cell
+static void redraw_view(scroll_ring_t* ring, int x, int y, int width, int height, void* user)
 {
-    for (int i = 0; i < BLOCK_SIZE; ++i)
+    const int left = ring->scroll_x + x;
+    const int top = ring->scroll_y + y;
+    const int right = left + width;
+    const int bottom = top + height;
+
+    for (int cell_y = top / BLOCK_SIZE; cell_y * BLOCK_SIZE < bottom; ++cell_y)
     {
-        for (int j = 0; j < BLOCK_SIZE; ++j)
+        const int y0 = clamp(top, cell_y * BLOCK_SIZE, cell_y * BLOCK_SIZE + BLOCK_SIZE);
+        const int y1 = clamp(bottom, cell_y * BLOCK_SIZE, cell_y * BLOCK_SIZE + BLOCK_SIZE);
+        for (int cell_x = left / BLOCK_SIZE; cell_x * BLOCK_SIZE < right; ++cell_x)
         {
-            set_pixel(buffer, x + j, y + i, color);
+            const int x0 = clamp(left, cell_x * BLOCK_SIZE, cell_x * BLOCK_SIZE + BLOCK_SIZE);
+            const int x1 = clamp(right, cell_x * BLOCK_SIZE, cell_x * BLOCK_SIZE + BLOCK_SIZE);
+            fill_rect(x0, y0, x1 - x0, y1 - y0, cell_color(cell_x, cell_y));
         }
     }
 }
 
-void draw_initial_snake_and_food()
+// Move the view towards the first snake, SCROLL_STEP pixels per frame at most. Only the strips
+// that come into view are redrawn.
+static void follow_snake(void)
 {
-    for (int i = 0; i < snake_length; ++i)
-    {
-        draw_block(framebuffer, snake_x[i] * BLOCK_SIZE, snake_y[i] * BLOCK_SIZE, SNAKE_COLOR);
-    }
-    draw_block(framebuffer, food_x * BLOCK_SIZE, food_y * BLOCK_SIZE, FOOD_COLOR);
+    int head_x, head_y;
+    if (!snake_head(0, &head_x, &head_y))
+        return;
+
+    const int max_x = WORLD_WIDTH * BLOCK_SIZE - FRAME_WIDTH;
+    const int max_y = WORLD_HEIGHT * BLOCK_SIZE - FRAME_HEIGHT;
+    const int target_x = clamp(head_x * BLOCK_SIZE + BLOCK_SIZE / 2 - FRAME_WIDTH / 2, 0, max_x) & ~1;
+    const int target_y = clamp(head_y * BLOCK_SIZE + BLOCK_SIZE / 2 - FRAME_HEIGHT / 2, 0, max_y);
+
+    const int dx = clamp(target_x - view.scroll_x, -SCROLL_STEP, SCROLL_STEP);
+    const int dy = clamp(target_y - view.scroll_y, -SCROLL_STEP, SCROLL_STEP);
+    scroll_ring_scroll_to(&view, view.scroll_x + dx, view.scroll_y + dy, redraw_view, NULL);
 }
 
-void clear_snake_and_food()
+void initialize_framebuffer()
 {
-    // Clear the current snake positions
-    for (int i = 0; i < snake_length; ++i)
-    {
-        draw_block(framebuffer, snake_x[i] * BLOCK_SIZE, snake_y[i] * BLOCK_SIZE, BACKGROUND_COLOR);
-    }
-
-    // Clear the current food position
-    draw_block(framebuffer, food_x * BLOCK_SIZE, food_y * BLOCK_SIZE, BACKGROUND_COLOR);
+    scroll_ring_init(&view, framebuffer, scan_lines, FRAME_WIDTH, FRAME_HEIGHT);
+    fill_rect(0, 0, FRAME_WIDTH, FRAME_HEIGHT, BACKGROUND_COLOR);
 }
 
-void reset_game()
+// The border is part of the world: redraw whatever of the grid is in view
+void draw_border()
 {
-    clear_snake_and_food();
+    redraw_view(&view, 0, 0, FRAME_WIDTH, FRAME_HEIGHT, NULL);
+}
 
-    snake_length = INITIAL_SNAKE_LENGTH;
-    snake_direction = INITIAL_SNAKE_DIRECTION;
+void draw_cell(int x, int y, uint16_t color)
+{
+    fill_rect(x * BLOCK_SIZE, y * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE, color);
+}
+#else
+#if ROW_INTERNING
+// Drawing copies the rows it touches out of their shared buffers, see merge_rows()
+static void fill_rect(int x, int y, int width, int height, uint16_t color)
+{
+    row_intern_fill(&rows, x, y, width, height, color);
+}
 
-    // Set the head of the snake
-    snake_x[0] = INITIAL_SNAKE_X;
-    snake_y[0] = INITIAL_SNAKE_Y;
+// Every row starts out sharing a single background buffer
+void initialize_framebuffer()
+{
+    ROW_INTERN_INIT(&rows, row_pool, FRAME_WIDTH, FRAME_HEIGHT, ROW_INTERN_POOL_ROWS, BACKGROUND_COLOR);
+}
 
-    // Initialize the rest of the snake segments
-    for (int i = 1; i < snake_length; ++i)
+// Share the rows drawn into during this frame again where they match another row
+static void merge_rows(void)
+{
+    row_intern_collect(&rows, ROW_INTERN_COLLECT_ROWS);
+    if (++rendered_frames == RENDER_REPORT_FRAMES)
     {
-        snake_x[i] = snake_x[i - 1] - 1;
-        snake_y[i] = snake_y[i - 1];
+        row_intern_print(&rows);
+        rendered_frames = 0;
     }
-
-    // Initialize food position
-    food_x = INITIAL_FOOD_X;
-    food_y = INITIAL_FOOD_Y;
-
-    draw_border();
-    draw_initial_snake_and_food(); // Draw initial positions without clearing the framebuffer
-
-    // Reset flags
-    update_snake = false;
-    move_snake_flag = false;
-    printf("Game reset\r\n");
+}
+#else
+static void fill_rect(int x, int y, int width, int height, uint16_t color)
+{
+    render_fill_rect(framebuffer, x, y, width, height, color);
 }
 
-void move_snake()
+void initialize_framebuffer()
 {
-    if (snake_length >= MAX_SNAKE_LENGTH)
+    fill_rect(0, 0, FRAME_WIDTH, FRAME_HEIGHT, BACKGROUND_COLOR);
+#if LOG_CONSOLE
+    for (int y = 0; y < PLAYFIELD_HEIGHT; ++y)
     {
-        printf("Maximum snake length reached!\r\n");
-        reset_game();
-        return;
+        scan_lines[y] = &framebuffer[y * FRAME_WIDTH];
     }
+    console_init(&log_console, &log_font, &framebuffer[PLAYFIELD_HEIGHT * FRAME_WIDTH], &scan_lines[PLAYFIELD_HEIGHT],
+                 LOG_CONSOLE_ROWS, SNAKE_PALETTE_CONSOLE_TEXT, SNAKE_PALETTE_CONSOLE_BACKGROUND);
+    console_attach_stdio(&log_console);
+#endif
+}
+#endif
+
+void draw_border()
+{
+    // Top, bottom, left and right
+    fill_rect(0, 0, FRAME_WIDTH, BORDER_SIZE, BORDER_COLOR);
+    fill_rect(0, PLAYFIELD_HEIGHT - BORDER_SIZE, FRAME_WIDTH, BORDER_SIZE, BORDER_COLOR);
+    fill_rect(0, BORDER_SIZE, BORDER_SIZE, PLAYFIELD_HEIGHT - 2 * BORDER_SIZE, BORDER_COLOR);
+    fill_rect(FRAME_WIDTH - BORDER_SIZE, BORDER_SIZE, BORDER_SIZE, PLAYFIELD_HEIGHT - 2 * BORDER_SIZE, BORDER_COLOR);
+}
+
+void draw_cell(int x, int y, uint16_t color)
+{
+#if ROW_INTERNING
+    fill_rect(x * BLOCK_SIZE, y * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE, color);
+#else
+    render_fill_cell(framebuffer, x, y, BLOCK_SIZE, color);
+#endif
+}
+#endif
 
-    int next_x = snake_x[0];
-    int next_y = snake_y[0];
+// Fill the first `filled` rows or columns of the cell, counted from its `side` edge, with
+// color and the rest with the background
+void draw_partial_cell(int x, int y, direction_t side, int filled, uint16_t color)
+{
+    const int left = x * BLOCK_SIZE;
+    const int top = y * BLOCK_SIZE;
+    const int rest = BLOCK_SIZE - filled;
 
-    // Determine next position based on the current direction
-    switch (snake_direction)
+    switch (side)
     {
     case DIRECTION_UP:
-        next_y -= 1;
-        break;
-    case DIRECTION_RIGHT:
-        next_x += 1;
+        fill_rect(left, top, BLOCK_SIZE, filled, color);
+        fill_rect(left, top + filled, BLOCK_SIZE, rest, BACKGROUND_COLOR);
         break;
     case DIRECTION_DOWN:
-        next_y += 1;
+        fill_rect(left, top, BLOCK_SIZE, rest, BACKGROUND_COLOR);
+        fill_rect(left, top + rest, BLOCK_SIZE, filled, color);
         break;
     case DIRECTION_LEFT:
-        next_x -= 1;
+        fill_rect(left, top, filled, BLOCK_SIZE, color);
+        fill_rect(left + filled, top, rest, BLOCK_SIZE, BACKGROUND_COLOR);
         break;
     default:
+        fill_rect(left, top, rest, BLOCK_SIZE, BACKGROUND_COLOR);
+        fill_rect(left + rest, top, filled, BLOCK_SIZE, color);
         break;
     }
+}
+#endif
 
-    // Collision with the border
-    if (next_x <= 0 || next_x >= FRAME_WIDTH / BLOCK_SIZE - 1 || next_y <= 0 || next_y >= FRAME_HEIGHT / BLOCK_SIZE - 1)
-    {
-        printf("Collision with border\r\n");
-        reset_game();
-        return;
-    }
+#if MSC_CAPTURE
+// Keep the capture going while the frame is being pushed. Only the capture and the FAT writer run
+// here: tuh_task() would run keyboard callbacks and enumeration, which take unbounded time, so
+// it stays between frames and drive commands complete there.
+static void capture_line_poll(void)
+{
+    if (msc_app_busy())
+        msc_app_poll();
+}
+#endif
 
-    // Collision with itself
-    for (int i = 1; i < snake_length; ++i)
+#if SMOOTH_MOTION
+// Time spent between frames, on input, game logic and drawing
+static struct
+{
+    uint32_t frames;
+    uint32_t overruns;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t late_scanlines;
+} render_stats;
+
+static void account_frame(uint32_t work_us)
+{
+    ++render_stats.frames;
+    render_stats.total_us += work_us;
+    if (work_us > render_stats.max_us)
+        render_stats.max_us = work_us;
+    if (work_us > RENDER_BUDGET_US)
+        ++render_stats.overruns;
+
+    if (render_stats.frames == RENDER_REPORT_FRAMES)
     {
-        if (next_x == snake_x[i] && next_y == snake_y[i])
-        {
-            printf("Collision with itself\r\n");
-            reset_game();
-            return;
-        }
+        // libdvi counts lines it had to send before core 1 had them ready
+        const uint32_t late = dvi0.late_scanline_ctr - render_stats.late_scanlines;
+        printf("Render: %lu frames, mean %lu us, max %lu us, budget %u us, %lu overruns, %lu late scanlines\r\n",
+               (unsigned long)render_stats.frames, (unsigned long)(render_stats.total_us / render_stats.frames),
+               (unsigned long)render_stats.max_us, RENDER_BUDGET_US, (unsigned long)render_stats.overruns,
+               (unsigned long)late);
+        render_stats.frames = 0;
+        render_stats.overruns = 0;
+        render_stats.total_us = 0;
+        render_stats.max_us = 0;
+        render_stats.late_scanlines = dvi0.late_scanline_ctr;
     }
+}
+#endif
 
-    // Check if snake eats the food
-    if (next_x == food_x && next_y == food_y)
-    {
-        printf("Food eaten\r\n");
-        // Move the snake head to the food position
-        for (int i = snake_length; i > 0; --i)
-        {
-            snake_x[i] = snake_x[i - 1];
-            snake_y[i] = snake_y[i - 1];
-        }
-        snake_x[0] = food_x;
-        snake_y[0] = food_y;
-        snake_length++;
+#if LOAD_GOVERNOR
+static governor_t governor;
+static uint32_t governed_frames;
+static uint32_t late_scanlines_seen;
 
-        // Generate new food
-        do
-        {
-            food_x = rand() % (FRAME_WIDTH / BLOCK_SIZE);
-            food_y = rand() % (FRAME_HEIGHT / BLOCK_SIZE);
-        } while (food_x < 1 || food_y < 1 || food_x > (FRAME_WIDTH / BLOCK_SIZE) - 2 ||
-                 food_y > (FRAME_HEIGHT / BLOCK_SIZE) - 2);
+// Set on every other frame while the governor sheds per-frame extras
+static bool shed_frame;
+
+// True while the governor is at the given level or above
+#define GOVERNOR_AT(at)   (governor.level >= (at))
+#define SHED_THIS_FRAME() shed_frame
 
-        draw_block(framebuffer, food_x * BLOCK_SIZE, food_y * BLOCK_SIZE, FOOD_COLOR);
+void log_event(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    governor_vlog(&governor, format, args);
+    va_end(args);
+}
+
+// Set while flush_log() has sent only part of a line
+static bool log_line_open;
+
+// Send one character of queued log text to the UART, and to the log console which does not
+// see it through stdio. Returns false when the queue is empty.
+static bool send_log_char(void)
+{
+    const int c = governor_log_next(&governor);
+    if (c < 0)
+    {
+        log_line_open = false;
+        return false;
     }
-    else
+    uart_putc_raw(uart0, (char)c);
+#if LOG_CONSOLE
+    const char ch = (char)c;
+    console_write(&log_console, &ch, 1);
+#endif
+    log_line_open = c != '\n';
+    return true;
+}
+
+// Write queued log text for as long as the UART takes it without waiting
+static void flush_log(void)
+{
+    while (uart_is_writable(uart0) && send_log_char())
     {
-        // Clear the last segment of the snake if it didn't just eat food
-        draw_block(framebuffer, snake_x[snake_length - 1] * BLOCK_SIZE, snake_y[snake_length - 1] * BLOCK_SIZE,
-                   BACKGROUND_COLOR);
+    }
+}
 
-        // Move the snake forward
-        for (int i = snake_length - 1; i > 0; --i)
-        {
-            snake_x[i] = snake_x[i - 1];
-            snake_y[i] = snake_y[i - 1];
-        }
-        snake_x[0] = next_x;
-        snake_y[0] = next_y;
+#if LIB_PICO_STDIO_UART
+// Everything else printed goes to the UART through this driver in place of stdio's own, which
+// first finishes any log line flush_log() left half sent, so the two never mix within a line
+static void governed_out_chars(const char* buf, int length)
+{
+    while (log_line_open && send_log_char())
+    {
     }
+    uart_write_blocking(uart0, (const uint8_t*)buf, length);
+}
 
-    // Redraw each segment of the snake on the display at updated positions
-    for (int i = 0; i < snake_length; ++i)
+static stdio_driver_t governed_stdio = {.out_chars = governed_out_chars};
+#endif
+
+// Account for the work since the frame was pushed and pick the level for the next frame
+static void govern_frame(uint32_t work_us)
+{
+    // libdvi counts lines it had to send before core 1 had them ready
+    const uint32_t late = dvi0.late_scanline_ctr - late_scanlines_seen;
+    late_scanlines_seen = dvi0.late_scanline_ctr;
+    governor_frame(&governor, work_us, late);
+
+    if (++governed_frames >= RENDER_REPORT_FRAMES && !GOVERNOR_AT(GOVERNOR_DEFER_LOGS))
     {
-        draw_block(framebuffer, snake_x[i] * BLOCK_SIZE, snake_y[i] * BLOCK_SIZE, SNAKE_COLOR);
+        governor_print(&governor);
+        governor_reset_stats(&governor);
+        governed_frames = 0;
     }
 }
 
+// For the "stats" command
+void governor_print_stats(void)
+{
+    governor_print(&governor);
+}
+#else
+#define GOVERNOR_AT(at)   false
+#define SHED_THIS_FRAME() false
+#endif
+
 int main()
 {
+    // Paint the stacks before anything else runs deep, or core 1 starts
+    mem_report_init();
     board_init();
     tuh_init(BOARD_TUH_RHPORT);
     vreg_set_voltage(VREG_VSEL);
@@ -332,32 +564,149 @@ int main()
     dvi0.ser_cfg = DVI_DEFAULT_SERIAL_CONFIG;
     dvi_init(&dvi0, next_striped_spin_lock_num(), next_striped_spin_lock_num());
 
+    scanout_init(&dvi0);
     multicore_launch_core1(core1_main);
 
+    printf("Display mode %s, framebuffer %lu bytes\r\n", display_mode.name,
+           (unsigned long)display_mode_framebuffer_bytes(&display_mode));
+
+#if SCROLLING
+    printf("World %dx%d cells, view %dx%d pixels\r\n", WORLD_WIDTH, WORLD_HEIGHT, FRAME_WIDTH, FRAME_HEIGHT);
+#endif
+
+#if LOAD_GOVERNOR
+    governor_init(&governor, RENDER_BUDGET_US);
+#if LIB_PICO_STDIO_UART
+    stdio_set_driver_enabled(&stdio_uart, false);
+    stdio_set_driver_enabled(&governed_stdio, true);
+#endif
+#endif
+
     printf("Game start\r\n");
+    const uint64_t redraw_start = time_us_64();
     initialize_framebuffer();
+    draw_border();
+    printf("Full redraw took %llu us\r\n", time_us_64() - redraw_start);
     reset_game();
 
+#if UART_FB_STREAM
+    uart_stream_init(framebuffer);
+    uart_stream_set_enabled(true);
+#endif
+
+#if MSC_CAPTURE
+    msc_app_init(framebuffer);
+    scanout_set_line_poll(capture_line_poll);
+#endif
+
+#if LATENCY_TEST
+    latency_init();
+    printf("Latency test: marker at %d,%d\r\n", LATENCY_MARKER_X, LATENCY_MARKER_Y);
+#endif
+
+#if COPPER_GRADIENT
+    build_copper_gradient();
+#endif
+
+    uart_app_init();
+
     // Set up timer to move the snake
-    struct repeating_timer timer;
-    add_repeating_timer_ms(SNAKE_MOVE_INTERVAL_MS, repeating_timer_callback, NULL, &timer);
+    add_repeating_timer_ms(move_interval_ms, repeating_timer_callback, NULL, &move_timer);
+
+#if SMOOTH_MOTION
+    uint64_t last_move_us = time_us_64();
+#endif
 
     while (true)
     {
-        for (uint y = 0; y < FRAME_HEIGHT; ++y)
+#if LATENCY_TEST
+        latency_push_frame(framebuffer);
+#elif FLASH_BACKGROUND
+        render_frame();
+#elif SCROLLING
+        scanout_push_lines(scan_lines);
+#elif ROW_INTERNING
+        scanout_push_lines(rows.lines);
+#elif LOG_CONSOLE
+        scanout_push_lines(scan_lines);
+#elif COPPER_GRADIENT
+        scanout_push_copper(framebuffer, copper_list, GRID_HEIGHT);
+#else
+        scanout_push_frame(framebuffer);
+#endif
+#if FRAME_CRC
+        // The signature of the frame just pushed, before anything else prints
+        scanout_poll_crc();
+#endif
+#if LOAD_GOVERNOR
+        // Everything up to the next frame counts against the render budget
+        const uint32_t frame_start = time_us_32();
+#endif
+#if UART_FB_STREAM
+        uart_stream_poll();
+#endif
+#if LOAD_GOVERNOR
+        shed_frame = GOVERNOR_AT(GOVERNOR_SHED_FRAMES) && !shed_frame;
+        if (!GOVERNOR_AT(GOVERNOR_DEFER_LOGS))
+            flush_log();
+#endif
+        if (!GOVERNOR_AT(GOVERNOR_DEFER_LOGS))
+            mem_report_poll();
+        uart_command_poll();
+#if SCROLLING
+        if (!SHED_THIS_FRAME())
+            follow_snake();
+#endif
+#if MSC_CAPTURE
+        msc_app_frame();
+#endif
+#if SCANOUT_STATS
+        if (!GOVERNOR_AT(GOVERNOR_DEFER_LOGS))
+            scanout_poll_stats();
+#endif
+#if TMDS_CACHE
+        if (!GOVERNOR_AT(GOVERNOR_DEFER_LOGS))
+            scanout_poll_tmds_cache();
+#endif
+#if SMOOTH_MOTION
+        // Everything up to the next frame counts against the render budget
+        const uint64_t work_start = time_us_64();
+        tuh_task();
+        if (move_snake_flag)
         {
-            const uint16_t* scanline = &framebuffer[y * FRAME_WIDTH];
-            queue_add_blocking_u32(&dvi0.q_colour_valid, &scanline);
-            while (queue_try_remove_u32(&dvi0.q_colour_free, &scanline))
-                ;
+            move_snake();
+            move_snake_flag = false;
+            last_move_us = time_us_64();
         }
+
+        // Draw the head and tail at the current point between two moves
+        uint64_t phase = (time_us_64() - last_move_us) * MOTION_PHASE_ONE / ((uint64_t)move_interval_ms * 1000);
+        if (!SHED_THIS_FRAME())
+            render_motion(phase < MOTION_PHASE_ONE ? (uint32_t)phase : MOTION_PHASE_ONE);
+        account_frame((uint32_t)(time_us_64() - work_start));
+#else
         tuh_task();
         if (move_snake_flag)
         {
             move_snake();            // Move snake when flag is set
             move_snake_flag = false; // Reset flag after moving
-            sleep_ms(1);             // Add a small delay to prevent overflow
+#if !LOAD_GOVERNOR
+            // Add a small delay to prevent overflow. The governor times this window against the
+            // blanking interval, so it leaves the time to the work instead of idling it away.
+            sleep_ms(1);
+#endif
         }
+#endif
+#if LOAD_GOVERNOR
+        // Resets and rewinds only mark the cells they change
+        game_repaint(GOVERNOR_AT(GOVERNOR_SPREAD_REPAINTS) ? REPAINT_ROWS_PER_FRAME : GRID_HEIGHT);
+#endif
+#if ROW_INTERNING
+        merge_rows();
+#endif
+#if LOAD_GOVERNOR
+        govern_frame(time_us_32() - frame_start);
+#endif
     }
     return 0;
 }
@@ -26,8 +26,143 @@
 #ifndef MAIN_H
 #define MAIN_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "display_mode.h"
+#include "snake_palette.h"
+
 #define MAX_SNAKE_LENGTH 100
 
+// Number of snakes, each steered by its own keyboard. Set with the SNAKE_PLAYERS CMake cache variable.
+#ifndef MAX_PLAYERS
+#define MAX_PLAYERS 1
+#endif
+
+// Input-to-photon latency test, enabled with -DLATENCY_TEST=ON. See common/latency.h.
+#ifndef LATENCY_TEST
+#define LATENCY_TEST 0
+#endif
+
+// Smooth motion, enabled with -DSNAKE_SMOOTH_MOTION=ON. The game still moves on its tick, but the
+// head and tail cells are drawn at pixel offsets interpolated from the tick phase on every frame.
+#ifndef SMOOTH_MOTION
+#define SMOOTH_MOTION 0
+#endif
+
+// Border and background streamed from flash, enabled with -DSNAKE_FLASH_BACKGROUND=ON. There is no
+// framebuffer: every scanline is decoded from assets/background.png and the snakes and food are
+// drawn over it from the occupancy grid. See common/background.h.
+#ifndef FLASH_BACKGROUND
+#define FLASH_BACKGROUND 0
+#endif
+
+// Scrolling world, enabled with -DSNAKE_SCROLLING=ON. The playfield is WORLD_WIDTH x WORLD_HEIGHT
+// cells and the screen follows the first snake. See common/scroll_ring.h.
+#ifndef SCROLLING
+#define SCROLLING 0
+#endif
+
+#define WORLD_WIDTH  80
+#define WORLD_HEIGHT 60
+
+// Pixels the view moves per frame while catching up with the snake, even for word-aligned lines
+#define SCROLL_STEP 4
+
+// Interned rows, enabled with -DSNAKE_ROW_INTERNING=ON. Identical screen rows share one buffer
+// from a pool of ROW_INTERN_POOL_ROWS instead of a full framebuffer. See common/row_intern.h.
+#ifndef ROW_INTERNING
+#define ROW_INTERNING 0
+#endif
+
+// Row buffers in the pool. Without smooth motion every pixel row of a cell row is the same, so a
+// screen has at most GRID_HEIGHT distinct rows plus the ones drawn into since the last merge.
+#define ROW_INTERN_POOL_ROWS 64
+
+// Rows drawn into that are merged with identical buffers after each frame
+#define ROW_INTERN_COLLECT_ROWS 48
+
+// Log console, enabled with -DSNAKE_LOG_CONSOLE=ON. The last lines printed are shown in
+// LOG_CONSOLE_ROWS text rows under the playfield, one row per cell row. See common/console.h.
+#ifndef LOG_CONSOLE
+#define LOG_CONSOLE 0
+#endif
+
+#define LOG_CONSOLE_ROWS 4
+
+// Copper gradient, enabled with -DSNAKE_COPPER=ON. The playfield background darkens towards the
+// bottom through one copper palette command per cell row. See common/copper.h.
+#ifndef COPPER_GRADIENT
+#define COPPER_GRADIENT 0
+#endif
+
+// Background colour on the last cell row, in 1/256ths of the palette colour
+#define COPPER_GRADIENT_BOTTOM 128
+
+// Rewind buffer, enabled with -DSNAKE_REWIND=ON. The state at the start of every tick is kept as
+// deltas and keyframes in a few KB, and the "rewind" command goes back to any of them. See rewind.h.
+#ifndef REWIND
+#define REWIND 0
+#endif
+
+// Load governor, enabled with -DSNAKE_LOAD_GOVERNOR=ON. The time spent between frames is checked
+// against RENDER_BUDGET_US, and while it runs over, event logs, periodic reports, large repaints
+// and smooth motion are cut back step by step. See common/governor.h.
+#ifndef LOAD_GOVERNOR
+#define LOAD_GOVERNOR 0
+#endif
+
+// Rows of cells game_repaint() draws per frame while the governor spreads repaints
+#define REPAINT_ROWS_PER_FRAME 4
+
+// Screenshots and recordings to a USB drive, enabled with -DSNAKE_MSC_CAPTURE=ON. See common/capture.h.
+#ifndef MSC_CAPTURE
+#define MSC_CAPTURE 0
+#endif
+
+// Work between two frames has to fit in the vertical blanking interval, 45 lines of 800 pixels
+// at 25.2 MHz for 640x480p60, or the line queue runs dry
+#define RENDER_BUDGET_US 1430
+
+// Frames between render time reports in smooth motion, flash background and row interning modes
+#define RENDER_REPORT_FRAMES 600
+
+// Block sizes
+#define BLOCK_SIZE       8 // Multiple of 8
+#define BORDER_SIZE      BLOCK_SIZE
+
+// RGB565 colours, generated from assets/palette.gpl at build time
+#define BORDER_COLOR     SNAKE_PALETTE_BORDER
+#define BACKGROUND_COLOR SNAKE_PALETTE_BACKGROUND
+#define SNAKE_COLOR      SNAKE_PALETTE_SNAKE
+#define FOOD_COLOR       SNAKE_PALETTE_FOOD
+
+// Playfield size in blocks, including the border
+#if SCROLLING
+#define GRID_WIDTH  WORLD_WIDTH
+#define GRID_HEIGHT WORLD_HEIGHT
+#elif LOG_CONSOLE
+#define GRID_WIDTH  (FRAME_WIDTH / BLOCK_SIZE)
+#define GRID_HEIGHT (FRAME_HEIGHT / BLOCK_SIZE - LOG_CONSOLE_ROWS)
+#else
+#define GRID_WIDTH  (FRAME_WIDTH / BLOCK_SIZE)
+#define GRID_HEIGHT (FRAME_HEIGHT / BLOCK_SIZE)
+#endif
+
+// Screen lines taken by the playfield, any below belong to the log console
+#define PLAYFIELD_HEIGHT (GRID_HEIGHT * BLOCK_SIZE)
+
+// Snake game settings
+#define SNAKE_MOVE_INTERVAL_MS  250
+#define MOVE_INTERVAL_MIN_MS    20 // Range accepted by the "tick" command
+#define MOVE_INTERVAL_MAX_MS    5000
+#define INITIAL_SNAKE_LENGTH    5
+#define INITIAL_SNAKE_X         10
+#define INITIAL_SNAKE_Y         5
+#define INITIAL_FOOD_X          10
+#define INITIAL_FOOD_Y          10
+#define INITIAL_SNAKE_DIRECTION DIRECTION_RIGHT
+
 // Direction enumeration
 typedef enum
 {
@@ -41,8 +176,61 @@ typedef enum
 // Function declarations
 void move_snake(void);
 void reset_game(void);
+void steer_snake(uint8_t player, direction_t new_direction);
+void player_join(uint8_t player);
+void player_leave(uint8_t player);
+void game_print_stats(void);
+
+// Tick phase for render_motion(), from the last move (0) to the next one (MOTION_PHASE_ONE)
+#define MOTION_PHASE_ONE 256
+void render_motion(uint32_t phase);
+
+#if FLASH_BACKGROUND
+void render_grid_line(uint16_t* line, int y);
+#endif
+
+#if REWIND
+bool game_rewind(uint32_t ticks);
+bool game_rewind_to_loss(void);
+#endif
+
+#if LOAD_GOVERNOR
+bool game_repaint(uint32_t max_rows);
+#endif
+
+#if SCROLLING
+uint16_t cell_color(int x, int y);
+bool snake_head(uint8_t player, int* x, int* y);
+#endif
+
+// Rendering and timing, implemented in main.c
+void set_move_interval(uint32_t interval_ms);
+void draw_border(void);
+void draw_cell(int x, int y, uint16_t color);
+void draw_partial_cell(int x, int y, direction_t side, int filled, uint16_t color);
+
+// Event messages. With the load governor they are queued and written out between busy frames,
+// see log_event() in main.c; command replies still go straight to printf(). The governor's
+// report is part of the "stats" command.
+#if LOAD_GOVERNOR
+void log_event(const char* format, ...) __attribute__((format(printf, 1, 2)));
+void governor_print_stats(void);
+#else
+#define log_event printf
+#endif
+
+// USB drive captures, implemented in msc_app.c
+#if MSC_CAPTURE
+void msc_app_init(const uint16_t* framebuffer);
+void msc_app_screenshot(void);
+void msc_app_toggle_recording(void);
+bool msc_app_recording(void);
+bool msc_app_busy(void);
+void msc_app_poll(void);
+void msc_app_frame(void);
+#endif
 
-// Variables
-extern direction_t snake_direction;
+// UART commands, implemented in uart_app.c
+void uart_app_init(void);
 
 #endif
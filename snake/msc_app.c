@@ -0,0 +1,178 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "tusb.h"
+
+#include "capture.h"
+#include "display_mode.h"
+#include "main.h"
+
+#if MSC_CAPTURE
+
+// Block device on the first LUN of the mounted USB drive
+static block_dev_t msc_dev;
+static uint8_t msc_dev_addr;
+static volatile block_dev_status_t msc_status;
+
+static fat_writer_t writer;
+static fat_writer_state_t reported_state;
+static capture_t capture;
+static uint32_t tile_hashes[FB_STREAM_TILE_COUNT(FRAME_WIDTH, FRAME_HEIGHT)];
+
+static bool msc_complete_cb(uint8_t dev_addr, tuh_msc_complete_data_t const* cb_data)
+{
+    msc_status = cb_data->csw->status == MSC_CSW_STATUS_PASSED ? BLOCK_DEV_IDLE : BLOCK_DEV_ERROR;
+    return true;
+}
+
+static bool msc_read(block_dev_t* dev, uint32_t lba, void* buffer, uint32_t count)
+{
+    msc_status = BLOCK_DEV_BUSY;
+    if (!tuh_msc_read10(msc_dev_addr, 0, buffer, lba, (uint16_t)count, msc_complete_cb, 0))
+    {
+        msc_status = BLOCK_DEV_IDLE;
+        return false;
+    }
+    return true;
+}
+
+static bool msc_write(block_dev_t* dev, uint32_t lba, const void* buffer, uint32_t count)
+{
+    msc_status = BLOCK_DEV_BUSY;
+    if (!tuh_msc_write10(msc_dev_addr, 0, buffer, lba, (uint16_t)count, msc_complete_cb, 0))
+    {
+        msc_status = BLOCK_DEV_IDLE;
+        return false;
+    }
+    return true;
+}
+
+// Completions arrive from tuh_task()
+static block_dev_status_t msc_get_status(block_dev_t* dev)
+{
+    return msc_status;
+}
+
+void tuh_msc_mount_cb(uint8_t dev_addr)
+{
+    const uint32_t block_size = tuh_msc_get_block_size(dev_addr, 0);
+    if (block_size != BLOCK_DEV_BLOCK_SIZE)
+    {
+        printf("USB drive: %lu byte blocks are not supported\r\n", (unsigned long)block_size);
+        return;
+    }
+
+    msc_dev_addr = dev_addr;
+    msc_status = BLOCK_DEV_IDLE;
+    msc_dev.block_count = tuh_msc_get_block_count(dev_addr, 0);
+    msc_dev.read = msc_read;
+    msc_dev.write = msc_write;
+    msc_dev.status = msc_get_status;
+    msc_dev.context = NULL;
+
+    log_event("USB drive mounted, %lu MB\r\n", (unsigned long)(msc_dev.block_count / (1024 * 1024 / block_size)));
+    fat_writer_mount(&writer, &msc_dev);
+    reported_state = FAT_WRITER_MOUNTING;
+}
+
+void tuh_msc_umount_cb(uint8_t dev_addr)
+{
+    if (writer.dev == NULL || dev_addr != msc_dev_addr)
+        return;
+
+    capture_abort(&capture);
+    fat_writer_unmount(&writer);
+    log_event("USB drive removed\r\n");
+}
+
+void msc_app_init(const uint16_t* framebuffer)
+{
+    capture_init(&capture, &writer, framebuffer, FRAME_WIDTH, FRAME_HEIGHT, tile_hashes);
+}
+
+void msc_app_screenshot(void)
+{
+    if (!capture_screenshot(&capture, time_us_64()))
+        printf("Capture: no USB drive ready\r\n");
+}
+
+void msc_app_toggle_recording(void)
+{
+    if (capture.mode == CAPTURE_RECORDING)
+    {
+        capture_record_stop(&capture);
+    }
+    else if (capture_record_start(&capture, time_us_64()))
+    {
+        printf("Capture: recording\r\n");
+    }
+    else
+    {
+        printf("Capture: no USB drive ready\r\n");
+    }
+}
+
+bool msc_app_recording(void)
+{
+    return capture.mode == CAPTURE_RECORDING;
+}
+
+// True while a capture is being written, when msc_app_poll() wants to run between lines
+bool msc_app_busy(void)
+{
+    return capture_busy(&capture);
+}
+
+// Advance mounting and any capture in progress. Cheap enough to call between scanline pushes: it
+// only submits commands to the drive and never prints. Completions are picked up by tuh_task(),
+// which runs between frames.
+void msc_app_poll(void)
+{
+    if (writer.state == FAT_WRITER_MOUNTING)
+        fat_writer_poll(&writer);
+    capture_poll(&capture, time_us_64());
+}
+
+// Call once per frame from the main loop
+void msc_app_frame(void)
+{
+    capture_frame(&capture);
+    msc_app_poll();
+    capture_poll_report(&capture);
+
+    if (writer.state != reported_state && writer.dev != NULL)
+    {
+        if (reported_state == FAT_WRITER_MOUNTING && writer.state == FAT_WRITER_READY)
+            printf("USB drive: FAT32 volume ready, F12 screenshot, F11 start/stop recording\r\n");
+        else if (writer.state == FAT_WRITER_ERROR)
+            printf("USB drive: %s\r\n", writer.error);
+        reported_state = writer.state;
+    }
+}
+
+#endif
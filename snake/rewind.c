@@ -0,0 +1,412 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "rewind.h"
+
+// First byte of a keyframe. The first byte of a delta has the players who moved in the low
+// nibble and the players who grew in the high one, and only a player who moved can grow.
+#define KEYFRAME_TAG 0xf0
+
+// Largest delta: the masks, the directions, and the food and random state after eating
+#define MAX_DELTA 8
+
+// A keyframe and its deltas fit in half the buffer, so making room for a record never drops the
+// keyframe it belongs to
+_Static_assert(REWIND_MAX_RECORD + (REWIND_KEYFRAME_INTERVAL - 1) * MAX_DELTA <= REWIND_BUFFER_BYTES / 2,
+               "Rewind buffer too small for its keyframe interval");
+
+static const int8_t step_x[4] = {0, 1, 0, -1}; // Indexed by direction_t
+static const int8_t step_y[4] = {-1, 0, 1, 0};
+
+typedef struct
+{
+    const rewind_t* rewind;
+    uint32_t position;
+} reader_t;
+
+static uint8_t read_byte(reader_t* reader)
+{
+    return reader->rewind->bytes[reader->position++ % REWIND_BUFFER_BYTES];
+}
+
+static uint32_t read_u32(reader_t* reader)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        value |= (uint32_t)read_byte(reader) << (8 * i);
+    }
+    return value;
+}
+
+static uint32_t put_u32(uint8_t* record, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        record[i] = value >> (8 * i);
+    }
+    return 4;
+}
+
+static void summarise(const game_state_t* game, rewind_summary_t* summary)
+{
+    summary->epoch = game->epoch;
+    summary->random_state = game->random_state;
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        const uint32_t head = game->head_index[player];
+        summary->head_x[player] = game->body_x[player][head];
+        summary->head_y[player] = game->body_y[player][head];
+        summary->length[player] = game->snake_length[player];
+        summary->direction[player] = game->direction[player];
+        summary->joined[player] = game->joined[player];
+        summary->alive[player] = game->alive[player];
+    }
+    summary->food_x = game->food_x;
+    summary->food_y = game->food_y;
+}
+
+// The whole state, with each body as its head cell followed by the direction from every segment
+// to the next, 4 to a byte
+static uint32_t encode_keyframe(const game_state_t* game, uint8_t* record)
+{
+    uint32_t size = 0;
+    record[size++] = KEYFRAME_TAG;
+    size += put_u32(&record[size], game->random_state);
+    record[size++] = game->food_x;
+    record[size++] = game->food_y;
+
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        const uint32_t length = game->snake_length[player];
+        record[size++] = game->joined[player] | game->alive[player] << 1 | game->direction[player] << 2;
+        record[size++] = length;
+        if (length == 0)
+            continue;
+
+        uint32_t index = game_segment(game, player, 0);
+        int x = game->body_x[player][index];
+        int y = game->body_y[player][index];
+        record[size++] = x;
+        record[size++] = y;
+
+        uint8_t bits = 0;
+        for (uint32_t i = 1; i < length; ++i)
+        {
+            index = game_segment(game, player, i);
+            const int next_x = game->body_x[player][index];
+            const int next_y = game->body_y[player][index];
+            const direction_t way = next_x > x   ? DIRECTION_RIGHT
+                                    : next_x < x ? DIRECTION_LEFT
+                                    : next_y > y ? DIRECTION_DOWN
+                                                 : DIRECTION_UP;
+            bits |= way << ((i - 1) % 4 * 2);
+            if ((i - 1) % 4 == 3 || i == length - 1)
+            {
+                record[size++] = bits;
+                bits = 0;
+            }
+            x = next_x;
+            y = next_y;
+        }
+    }
+    return size;
+}
+
+// The change since the last state as a delta, or 0 if it was not a plain move of every player
+static uint32_t encode_delta(const rewind_summary_t* last, const game_state_t* game, uint8_t* record)
+{
+    if (game->epoch != last->epoch)
+        return 0;
+
+    uint8_t moved = 0;
+    uint8_t grew = 0;
+    uint8_t directions = 0;
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (game->joined[player] != last->joined[player] || game->alive[player] != last->alive[player] ||
+            game->direction[player] > DIRECTION_LEFT || last->direction[player] > DIRECTION_LEFT)
+            return 0;
+        directions |= game->direction[player] << (player * 2);
+        if (!game->alive[player])
+            continue;
+
+        const uint32_t head = game->head_index[player];
+        const int x = game->body_x[player][head];
+        const int y = game->body_y[player][head];
+        const uint32_t length = game->snake_length[player];
+        if (x == last->head_x[player] && y == last->head_y[player])
+        {
+            if (length != last->length[player])
+                return 0;
+            continue;
+        }
+
+        // The head only moves one cell, the way the player was heading
+        const direction_t way = (direction_t)last->direction[player];
+        if (x != last->head_x[player] + step_x[way] || y != last->head_y[player] + step_y[way])
+            return 0;
+        if (length == last->length[player] + 1u)
+            grew |= 1 << player;
+        else if (length != last->length[player])
+            return 0;
+        moved |= 1 << player;
+    }
+
+    uint32_t size = 0;
+    record[size++] = moved | grew << 4;
+    record[size++] = directions;
+    if (grew)
+    {
+        record[size++] = game->food_x;
+        record[size++] = game->food_y;
+        size += put_u32(&record[size], game->random_state);
+    }
+    else if (game->food_x != last->food_x || game->food_y != last->food_y || game->random_state != last->random_state)
+    {
+        return 0;
+    }
+    return size;
+}
+
+static void decode_keyframe(reader_t* reader, game_state_t* game)
+{
+    read_byte(reader); // KEYFRAME_TAG
+    game->random_state = read_u32(reader);
+    game->food_x = read_byte(reader);
+    game->food_y = read_byte(reader);
+    game_state_clear_grid(game);
+
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        const uint8_t flags = read_byte(reader);
+        const uint32_t length = read_byte(reader);
+        game->joined[player] = flags & 1;
+        game->alive[player] = flags >> 1 & 1;
+        game->direction[player] = (direction_t)(flags >> 2);
+        game->snake_length[player] = length;
+        game->head_index[player] = 0;
+        if (length == 0)
+            continue;
+
+        int x = read_byte(reader);
+        int y = read_byte(reader);
+        uint8_t bits = 0;
+        for (uint32_t i = 0; i < length; ++i)
+        {
+            if (i > 0)
+            {
+                if ((i - 1) % 4 == 0)
+                    bits = read_byte(reader);
+                const int way = bits >> ((i - 1) % 4 * 2) & 3;
+                x += step_x[way];
+                y += step_y[way];
+            }
+            game->body_x[player][i] = x;
+            game->body_y[player][i] = y;
+            game->grid[y][x] = player + 1;
+        }
+    }
+
+    if (game->grid[game->food_y][game->food_x] == CELL_EMPTY)
+        game->grid[game->food_y][game->food_x] = CELL_FOOD;
+}
+
+// Replay one tick's moves, in player order as game_state_move() made them
+static void apply_delta(reader_t* reader, game_state_t* game)
+{
+    const uint8_t masks = read_byte(reader);
+    const uint8_t directions = read_byte(reader);
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (!(masks & 1 << player))
+            continue;
+
+        const uint32_t head = game->head_index[player];
+        const direction_t way = game->direction[player];
+        const int x = game->body_x[player][head] + step_x[way];
+        const int y = game->body_y[player][head] + step_y[way];
+        if (masks & 0x10 << player)
+        {
+            game->snake_length[player]++;
+        }
+        else
+        {
+            const uint32_t tail = game_segment(game, player, game->snake_length[player] - 1);
+            game->grid[game->body_y[player][tail]][game->body_x[player][tail]] = CELL_EMPTY;
+        }
+
+        const uint32_t new_head = (head + MAX_SNAKE_LENGTH - 1) % MAX_SNAKE_LENGTH;
+        game->head_index[player] = new_head;
+        game->body_x[player][new_head] = x;
+        game->body_y[player][new_head] = y;
+        game->grid[y][x] = player + 1;
+    }
+
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        game->direction[player] = (direction_t)(directions >> (player * 2) & 3);
+    }
+
+    if (masks >> 4)
+    {
+        game->food_x = read_byte(reader);
+        game->food_y = read_byte(reader);
+        game->random_state = read_u32(reader);
+        game->grid[game->food_y][game->food_x] = CELL_FOOD;
+    }
+}
+
+// Slot of the i-th oldest keyframe
+static uint32_t keyframe_slot(const rewind_t* rewind, uint32_t i)
+{
+    return (rewind->first_keyframe + i) % REWIND_MAX_KEYFRAMES;
+}
+
+static void drop_oldest(rewind_t* rewind)
+{
+    rewind->first_keyframe = (rewind->first_keyframe + 1) % REWIND_MAX_KEYFRAMES;
+    rewind->keyframe_count--;
+    rewind->tail = rewind->keyframe_count ? rewind->keyframes[keyframe_slot(rewind, 0)].position : rewind->head;
+}
+
+// Index of the last keyframe at or before a tick that is in the buffer
+static uint32_t find_keyframe(const rewind_t* rewind, uint32_t tick)
+{
+    uint32_t i = rewind->keyframe_count - 1;
+    while (rewind->keyframes[keyframe_slot(rewind, i)].tick > tick)
+    {
+        --i;
+    }
+    return i;
+}
+
+// Decode the tick into the game, returning the position of the tick's own record
+static uint32_t rebuild(const rewind_t* rewind, uint32_t keyframe, uint32_t tick, game_state_t* game)
+{
+    const rewind_keyframe_t* start = &rewind->keyframes[keyframe_slot(rewind, keyframe)];
+    reader_t reader = {rewind, start->position};
+    decode_keyframe(&reader, game);
+
+    uint32_t position = start->position;
+    for (uint32_t t = start->tick; t < tick; ++t)
+    {
+        position = reader.position;
+        apply_delta(&reader, game);
+    }
+    return position;
+}
+
+void rewind_init(rewind_t* rewind)
+{
+    memset(rewind, 0, sizeof(*rewind));
+}
+
+// Record the state at the start of the next tick
+void rewind_push(rewind_t* rewind, const game_state_t* game)
+{
+    uint8_t record[REWIND_MAX_RECORD];
+    uint32_t size = 0;
+    const bool due = rewind->keyframe_count == 0 ||
+                     rewind->next_tick - rewind->keyframes[keyframe_slot(rewind, rewind->keyframe_count - 1)].tick >=
+                         REWIND_KEYFRAME_INTERVAL;
+    if (rewind->have_last && !due)
+        size = encode_delta(&rewind->last, game, record);
+
+    const bool keyframe = size == 0;
+    if (keyframe)
+    {
+        size = encode_keyframe(game, record);
+        if (rewind->keyframe_count == REWIND_MAX_KEYFRAMES)
+            drop_oldest(rewind);
+    }
+    while (rewind->head + size - rewind->tail > REWIND_BUFFER_BYTES)
+    {
+        drop_oldest(rewind);
+    }
+    if (keyframe)
+    {
+        rewind->keyframes[keyframe_slot(rewind, rewind->keyframe_count++)] =
+            (rewind_keyframe_t){rewind->next_tick, rewind->head};
+        rewind->keyframes_written++;
+    }
+    else
+    {
+        rewind->deltas_written++;
+    }
+
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        rewind->bytes[rewind->head++ % REWIND_BUFFER_BYTES] = record[i];
+    }
+    rewind->bytes_written += size;
+
+    summarise(game, &rewind->last);
+    rewind->have_last = true;
+    rewind->next_tick++;
+}
+
+// First tick that can still be rebuilt
+uint32_t rewind_oldest(const rewind_t* rewind)
+{
+    return rewind->keyframe_count ? rewind->keyframes[rewind->first_keyframe].tick : rewind->next_tick;
+}
+
+// Number of ticks that can be rebuilt, up to the last one pushed
+uint32_t rewind_ticks(const rewind_t* rewind)
+{
+    return rewind->next_tick - rewind_oldest(rewind);
+}
+
+// Rebuild the state at the start of a tick into game, apart from its epoch. The body ring
+// buffers start at index 0, which plays on the same as the original.
+bool rewind_get(const rewind_t* rewind, uint32_t tick, game_state_t* game)
+{
+    if (tick < rewind_oldest(rewind) || tick >= rewind->next_tick)
+        return false;
+
+    rebuild(rewind, find_keyframe(rewind, tick), tick, game);
+    return true;
+}
+
+// Go back to a tick: rebuild it into game and forget it and every tick after it, so play can
+// carry on from there and the next rewind_push() records the tick again
+bool rewind_restore(rewind_t* rewind, uint32_t tick, game_state_t* game)
+{
+    if (tick < rewind_oldest(rewind) || tick >= rewind->next_tick)
+        return false;
+
+    const uint32_t keyframe = find_keyframe(rewind, tick);
+    rewind->head = rebuild(rewind, keyframe, tick, game);
+    rewind->keyframe_count = rewind->keyframes[keyframe_slot(rewind, keyframe)].tick == tick ? keyframe : keyframe + 1;
+    if (rewind->keyframe_count == 0)
+        rewind->tail = rewind->head;
+    rewind->next_tick = tick;
+    rewind->have_last = false;
+    game->epoch++;
+    return true;
+}
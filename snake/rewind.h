@@ -0,0 +1,107 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game_state.h"
+
+// Rewind buffer: the last few thousand ticks of a game in a fixed number of bytes, for going back
+// to any of them after the fact, such as the moves before an unexpected collision.
+//
+// The state at the start of every tick is recorded with rewind_push(). Most ticks only move each
+// snake by one cell, so they are stored as a 2 byte delta: which snakes moved, which of them grew,
+// and every snake's direction. The new head follows from the old head and direction and the tail
+// cell from the body, so neither is stored. Eating adds the new food cell and random state, 6
+// bytes. Every REWIND_KEYFRAME_INTERVAL ticks, and whenever the game changes in any other way
+// (reset, spawn, remove, see game_state_t.epoch), a keyframe holds the whole state instead: each
+// body as its head cell and 2 bits per segment for the way to the next one, around 30 bytes for
+// a 100 cell snake. The grid is rebuilt from the bodies, the walls and the food.
+//
+// Records go into a byte ring. When it is full the oldest keyframe is dropped with the deltas
+// after it. Rebuilding a tick decodes its keyframe and at most REWIND_KEYFRAME_INTERVAL - 1
+// deltas. With one snake, 4 KB keeps around 1600 ticks, over 6 minutes at the default speed.
+
+#define REWIND_BUFFER_BYTES      4096
+#define REWIND_KEYFRAME_INTERVAL 64
+#define REWIND_MAX_KEYFRAMES     64
+
+// Largest record: a keyframe with every snake at full length
+#define REWIND_MAX_RECORD (7 + MAX_PLAYERS * (4 + (MAX_SNAKE_LENGTH + 2) / 4))
+
+typedef struct
+{
+    uint32_t tick;
+    uint32_t position; // In bytes written since rewind_init(), wrapped to the buffer when read
+} rewind_keyframe_t;
+
+// Enough of the last state recorded to tell how the next one differs
+typedef struct
+{
+    uint32_t epoch;
+    uint32_t random_state;
+    uint8_t head_x[MAX_PLAYERS];
+    uint8_t head_y[MAX_PLAYERS];
+    uint8_t length[MAX_PLAYERS];
+    uint8_t direction[MAX_PLAYERS];
+    bool joined[MAX_PLAYERS];
+    bool alive[MAX_PLAYERS];
+    uint8_t food_x;
+    uint8_t food_y;
+} rewind_summary_t;
+
+typedef struct
+{
+    uint8_t bytes[REWIND_BUFFER_BYTES];
+    uint32_t head; // Bytes written since rewind_init()
+    uint32_t tail; // Position of the oldest keyframe kept
+
+    // Keyframes in the buffer, a ring starting at first_keyframe
+    rewind_keyframe_t keyframes[REWIND_MAX_KEYFRAMES];
+    uint32_t first_keyframe;
+    uint32_t keyframe_count;
+
+    uint32_t next_tick; // Tick number of the next rewind_push()
+    bool have_last;
+    rewind_summary_t last;
+
+    // Since rewind_init()
+    uint32_t keyframes_written;
+    uint32_t deltas_written;
+    uint32_t bytes_written;
+} rewind_t;
+
+// Function declarations
+void rewind_init(rewind_t* rewind);
+void rewind_push(rewind_t* rewind, const game_state_t* game);
+uint32_t rewind_oldest(const rewind_t* rewind);
+uint32_t rewind_ticks(const rewind_t* rewind);
+bool rewind_get(const rewind_t* rewind, uint32_t tick, game_state_t* game);
+bool rewind_restore(rewind_t* rewind, uint32_t tick, game_state_t* game);
+
+#endif // REWIND_H
@@ -0,0 +1,148 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+#include "scanout.h"
+#include "uart_command.h"
+
+// Commands for test rigs and the Kiwi terminal, see common/uart_command.h
+
+static bool parse_direction(const char* text, direction_t* direction)
+{
+    static const char* const names[] = {"up", "right", "down", "left"};
+    for (int i = 0; i < 4; ++i)
+    {
+        // Full name or first letter
+        if (strcmp(text, names[i]) == 0 || (text[0] == names[i][0] && text[1] == '\0'))
+        {
+            *direction = (direction_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool command_reset(int argc, char** argv)
+{
+    if (argc != 1)
+        return false;
+    reset_game();
+    return true;
+}
+
+static bool command_dir(int argc, char** argv)
+{
+    direction_t direction;
+    int32_t player = 1;
+    if (argc < 2 || argc > 3 || !parse_direction(argv[1], &direction))
+        return false;
+    if (argc == 3 && !uart_command_parse_int(argv[2], 1, MAX_PLAYERS, &player))
+        return false;
+    steer_snake(player - 1, direction);
+    return true;
+}
+
+static bool command_tick(int argc, char** argv)
+{
+    int32_t interval_ms;
+    if (argc != 2 || !uart_command_parse_int(argv[1], MOVE_INTERVAL_MIN_MS, MOVE_INTERVAL_MAX_MS, &interval_ms))
+        return false;
+    set_move_interval(interval_ms);
+    return true;
+}
+
+static bool command_stats(int argc, char** argv)
+{
+    if (argc != 1)
+        return false;
+    game_print_stats();
+    uart_command_print_stats();
+#if SCANOUT_STATS
+    scanout_stats_t stats;
+    scanout_get_stats(&stats);
+    scanout_stats_print(&stats, scanout_line_period_ns());
+#endif
+#if LOAD_GOVERNOR
+    governor_print_stats();
+#endif
+    return true;
+}
+
+#if REWIND
+static bool command_rewind(int argc, char** argv)
+{
+    int32_t ticks;
+    if (argc != 2)
+        return false;
+    if (strcmp(argv[1], "loss") == 0)
+        return game_rewind_to_loss();
+    return uart_command_parse_int(argv[1], 1, INT32_MAX, &ticks) && game_rewind(ticks);
+}
+#endif
+
+#if MSC_CAPTURE
+static bool command_rec(int argc, char** argv)
+{
+    if (argc != 2)
+        return false;
+
+    const bool start = strcmp(argv[1], "start") == 0;
+    if (!start && strcmp(argv[1], "stop") != 0)
+        return false;
+    if (start != msc_app_recording())
+        msc_app_toggle_recording();
+    return true;
+}
+
+static bool command_shot(int argc, char** argv)
+{
+    if (argc != 1)
+        return false;
+    msc_app_screenshot();
+    return true;
+}
+#endif
+
+static const uart_command_t commands[] = {
+    {"reset", "", command_reset},
+    {"dir", "up|down|left|right [player]", command_dir},
+    {"tick", "<ms>", command_tick},
+    {"stats", "", command_stats},
+#if REWIND
+    {"rewind", "<ticks>|loss", command_rewind},
+#endif
+#if MSC_CAPTURE
+    {"rec", "start|stop", command_rec},
+    {"shot", "", command_shot},
+#endif
+};
+
+void uart_app_init(void)
+{
+    uart_command_init(uart0, commands, sizeof(commands) / sizeof(commands[0]));
+}
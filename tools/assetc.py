@@ -0,0 +1,526 @@
+#!/usr/bin/env python3
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2024, Cytrence Technologies
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+"""Asset compiler: converts images, fonts and palettes into C headers.
+
+Images (PNG, BMP) become packed pixel arrays in 1bpp, 4bpp, 8bpp (indexed) or
+RGB565, optionally ordered-dithered and run-length encoded. BDF fonts become 1bpp
+glyph tables. GIMP palettes (.gpl) become RGB565 colour constants.
+
+Layouts:
+  1bpp/4bpp/8bpp  rows of packed pixels, leftmost pixel in the most significant bits
+  rgb565          rows of uint16_t pixels
+  Every row is padded to a multiple of --align bytes, so row starts stay aligned for
+  word-sized loads. With --rle each row is encoded separately as (count - 1, value)
+  pairs, where value is one byte (1/4/8bpp) or a little-endian RGB565 pixel, and a
+  table of row offsets allows any row to be decoded on its own.
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+# ---------------------------------------------------------------------------
+# Image loading, every loader returns (width, height, rows of (r, g, b) tuples)
+# ---------------------------------------------------------------------------
+
+
+def load_png(data):
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("not a PNG file")
+    pos = 8
+    idat = b""
+    palette = []
+    trns = b""
+    while pos < len(data):
+        length, ctype = struct.unpack(">I4s", data[pos : pos + 8])
+        chunk = data[pos + 8 : pos + 8 + length]
+        pos += 12 + length
+        if ctype == b"IHDR":
+            width, height, depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif ctype == b"PLTE":
+            palette = [tuple(chunk[i : i + 3]) for i in range(0, len(chunk), 3)]
+        elif ctype == b"tRNS":
+            trns = chunk
+        elif ctype == b"IDAT":
+            idat += chunk
+        elif ctype == b"IEND":
+            break
+    if interlace:
+        raise ValueError("interlaced PNG files are not supported")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    bits_per_pixel = channels * depth
+    bpp = max(1, bits_per_pixel // 8)
+    stride = (width * bits_per_pixel + 7) // 8
+    raw = zlib.decompress(idat)
+
+    rows = []
+    prev = bytearray(stride)
+    pos = 0
+    for _ in range(height):
+        filter_type = raw[pos]
+        line = bytearray(raw[pos + 1 : pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if filter_type == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif filter_type == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif filter_type == 3:
+                line[i] = (line[i] + (a + b) // 2) & 0xFF
+            elif filter_type == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pred = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pred) & 0xFF
+        prev = line
+
+        # Unpack samples
+        if depth == 8:
+            samples = list(line)
+        elif depth == 16:
+            samples = [line[i] for i in range(0, len(line), 2)]
+        else:
+            per_byte = 8 // depth
+            mask = (1 << depth) - 1
+            samples = []
+            for byte in line:
+                for k in range(per_byte):
+                    samples.append((byte >> (8 - depth * (k + 1))) & mask)
+            if color_type == 0:
+                samples = [s * 255 // mask for s in samples]
+
+        row = []
+        for x in range(width):
+            px = samples[x * channels : (x + 1) * channels]
+            if color_type == 0 or color_type == 4:
+                row.append((px[0], px[0], px[0]))
+            elif color_type == 3:
+                row.append(palette[px[0]])
+            else:
+                row.append(tuple(px[:3]))
+        rows.append(row)
+    return width, height, rows
+
+
+def load_bmp(data):
+    if data[:2] != b"BM":
+        raise ValueError("not a BMP file")
+    offset = struct.unpack("<I", data[10:14])[0]
+    header_size, width, height, _, bits, compression = struct.unpack("<IiiHHI", data[14:34])
+    if compression not in (0, 3):
+        raise ValueError("compressed BMP files are not supported")
+    palette = []
+    if bits <= 8:
+        colors = struct.unpack("<I", data[46:50])[0] or (1 << bits)
+        base = 14 + header_size
+        palette = [(data[base + i * 4 + 2], data[base + i * 4 + 1], data[base + i * 4]) for i in range(colors)]
+
+    bottom_up = height > 0
+    height = abs(height)
+    stride = ((width * bits + 31) // 32) * 4
+    rows = []
+    for y in range(height):
+        src = y if not bottom_up else height - 1 - y
+        line = data[offset + src * stride : offset + (src + 1) * stride]
+        row = []
+        for x in range(width):
+            if bits == 24 or bits == 32:
+                n = bits // 8
+                b, g, r = line[x * n], line[x * n + 1], line[x * n + 2]
+                row.append((r, g, b))
+            elif bits <= 8:
+                per_byte = 8 // bits
+                byte = line[x // per_byte]
+                index = (byte >> (8 - bits * (x % per_byte + 1))) & ((1 << bits) - 1)
+                row.append(palette[index])
+            else:
+                raise ValueError("unsupported BMP bit depth %d" % bits)
+        rows.append(row)
+    return width, height, rows
+
+
+def load_image(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:2] == b"BM":
+        return load_bmp(data)
+    return load_png(data)
+
+
+def resize(image, width, height):
+    """Nearest-neighbour resize"""
+    src_w, src_h, rows = image
+    return width, height, [[rows[y * src_h // height][x * src_w // width] for x in range(width)] for y in range(height)]
+
+
+# ---------------------------------------------------------------------------
+# Palettes and colour conversion
+# ---------------------------------------------------------------------------
+
+
+def load_gpl(path):
+    """Return a list of (name, (r, g, b)) from a GIMP palette"""
+    entries = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#") or line.startswith("GIMP") or ":" in line:
+                continue
+            parts = line.split(None, 3)
+            r, g, b = int(parts[0]), int(parts[1]), int(parts[2])
+            name = parts[3] if len(parts) > 3 else "color%d" % len(entries)
+            entries.append((name, (r, g, b)))
+    return entries
+
+
+def rgb565(rgb):
+    r, g, b = rgb
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+# 4x4 Bayer matrix, thresholds in 0..15
+BAYER4 = [[0, 8, 2, 10], [12, 4, 14, 6], [3, 11, 1, 9], [15, 7, 13, 5]]
+
+
+def dither_offset(x, y, step):
+    """Ordered dither offset for a quantisation step, centred on zero"""
+    return (BAYER4[y & 3][x & 3] + 0.5) / 16.0 * step - step / 2.0
+
+
+def clamp(v):
+    return 0 if v < 0 else (255 if v > 255 else int(v))
+
+
+def nearest(palette, rgb):
+    best, best_dist = 0, None
+    for i, (r, g, b) in enumerate(palette):
+        d = (r - rgb[0]) ** 2 + (g - rgb[1]) ** 2 + (b - rgb[2]) ** 2
+        if best_dist is None or d < best_dist:
+            best, best_dist = i, d
+    return best
+
+
+def fixed_palette(fmt):
+    """Uniform palette for images with too many colours: black/white, 16 greys or RGB332"""
+    if fmt == "1bpp":
+        return [(0, 0, 0), (255, 255, 255)]
+    if fmt == "4bpp":
+        return [(v * 17, v * 17, v * 17) for v in range(16)]
+    return [(r * 255 // 7, g * 255 // 7, b * 255 // 3) for r in range(8) for g in range(8) for b in range(4)]
+
+
+def build_palette(rows, fmt):
+    """Exact palette of the image, most frequent colour first, or a fixed one if it has too many colours"""
+    counts = {}
+    for row in rows:
+        for px in row:
+            counts[px] = counts.get(px, 0) + 1
+    if len(counts) > 1 << BITS[fmt]:
+        return fixed_palette(fmt)
+    return sorted(counts, key=lambda c: -counts[c])
+
+
+def palette_step(palette):
+    """Approximate distance between neighbouring levels of a palette, per channel"""
+    levels = [len(set(c[i] for c in palette)) for i in range(3)]
+    return [256.0 / max(1, n - 1) for n in levels]
+
+
+def quantise(image, fmt, palette, dither):
+    """Return rows of pixel values: palette indices, or RGB565 values"""
+    width, height, rows = image
+    step = palette_step(palette) if palette else None
+    out = []
+    for y, row in enumerate(rows):
+        values = []
+        for x, rgb in enumerate(row):
+            if fmt == "rgb565":
+                if dither:
+                    rgb = (
+                        clamp(rgb[0] + dither_offset(x, y, 8)),
+                        clamp(rgb[1] + dither_offset(x, y, 4)),
+                        clamp(rgb[2] + dither_offset(x, y, 8)),
+                    )
+                values.append(rgb565(rgb))
+            else:
+                if dither:
+                    rgb = tuple(clamp(c + dither_offset(x, y, step[i])) for i, c in enumerate(rgb))
+                values.append(nearest(palette, rgb))
+        out.append(values)
+    return out
+
+
+# ---------------------------------------------------------------------------
+# Packing and run-length encoding
+# ---------------------------------------------------------------------------
+
+BITS = {"1bpp": 1, "4bpp": 4, "8bpp": 8, "rgb565": 16}
+
+
+def pack_row(values, fmt, align):
+    """Pack one row into bytes, padded to a multiple of align bytes"""
+    bits = BITS[fmt]
+    out = bytearray()
+    if bits == 16:
+        for v in values:
+            out += struct.pack("<H", v)
+    else:
+        per_byte = 8 // bits
+        for i in range(0, len(values), per_byte):
+            byte = 0
+            for k, v in enumerate(values[i : i + per_byte]):
+                byte |= v << (8 - bits * (k + 1))
+            out.append(byte)
+    while len(out) % align:
+        out.append(0)
+    return bytes(out)
+
+
+def rle_row(packed, fmt):
+    """Encode a packed row as (count - 1, value) pairs"""
+    size = 2 if fmt == "rgb565" else 1
+    units = [packed[i : i + size] for i in range(0, len(packed), size)]
+    out = bytearray()
+    i = 0
+    while i < len(units):
+        run = 1
+        while i + run < len(units) and run < 256 and units[i + run] == units[i]:
+            run += 1
+        out.append(run - 1)
+        out += units[i]
+        i += run
+    return bytes(out)
+
+
+# ---------------------------------------------------------------------------
+# Output
+# ---------------------------------------------------------------------------
+
+HEADER = """// Generated by tools/assetc.py from {source}, do not edit.
+
+#ifndef {guard}
+#define {guard}
+
+#include <stdint.h>
+
+"""
+
+
+def c_bytes(data, per_line=16):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append("    " + " ".join("0x%02x," % b for b in data[i : i + per_line]))
+    return "\n".join(lines)
+
+
+def c_words(data, per_line=12, fmt="0x%04x,"):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append("    " + " ".join(fmt % w for w in data[i : i + per_line]))
+    return "\n".join(lines)
+
+
+def emit_image(args, name, upper):
+    image = load_image(args.input)
+    if args.resize:
+        w, h = (int(v) for v in args.resize.lower().split("x"))
+        image = resize(image, w, h)
+    width, height, rows = image
+    fmt = args.format
+
+    palette = None
+    if fmt != "rgb565":
+        if args.palette:
+            palette = [rgb for _, rgb in load_gpl(args.palette)][: 1 << BITS[fmt]]
+        else:
+            palette = build_palette(rows, fmt)
+
+    values = quantise(image, fmt, palette, args.dither)
+    packed = [pack_row(row, fmt, args.align) for row in values]
+    stride = len(packed[0])
+
+    out = [
+        "#define %s_WIDTH  %d" % (upper, width),
+        "#define %s_HEIGHT %d" % (upper, height),
+        "#define %s_STRIDE %d // Bytes per row" % (upper, stride),
+        "",
+    ]
+    if palette is not None:
+        out.append("#define %s_PALETTE_SIZE %d" % (upper, len(palette)))
+        out.append("")
+        out.append("static const uint16_t %s_palette[%d] = {" % (name, len(palette)))
+        out.append(c_words([rgb565(c) for c in palette]))
+        out.append("};")
+        out.append("")
+
+    if args.rle:
+        encoded = [rle_row(row, fmt) for row in packed]
+        offsets = [0]
+        for row in encoded:
+            offsets.append(offsets[-1] + len(row))
+        data = b"".join(encoded)
+        unit = 3 if fmt == "rgb565" else 2
+        out.append("#define %s_MAX_ROW_RUNS %d // Runs in the longest row" % (upper, max(len(r) for r in encoded) // unit))
+        out.append("")
+        out.append("// Row y is encoded in %s_rle[%s_row_offsets[y] .. %s_row_offsets[y + 1]]" % (name, name, name))
+        out.append("static const uint32_t %s_row_offsets[%d] = {" % (name, height + 1))
+        out.append(c_words(offsets, 8, "%d,"))
+        out.append("};")
+        out.append("")
+        out.append("static const uint8_t %s_rle[%d] __attribute__((aligned(4))) = {" % (name, len(data)))
+        out.append(c_bytes(data))
+        out.append("};")
+        raw_size = stride * height
+        print("%s: %dx%d %s, %d bytes RLE (%d raw)" % (name, width, height, fmt, len(data), raw_size), file=sys.stderr)
+    elif fmt == "rgb565":
+        words = [v for row in packed for v in struct.unpack("<%dH" % (len(row) // 2), row)]
+        out.append("static const uint16_t %s_data[%d] __attribute__((aligned(4))) = {" % (name, len(words)))
+        out.append(c_words(words))
+        out.append("};")
+    else:
+        data = b"".join(packed)
+        out.append("static const uint8_t %s_data[%d] __attribute__((aligned(4))) = {" % (name, len(data)))
+        out.append(c_bytes(data))
+        out.append("};")
+    return "\n".join(out)
+
+
+def load_bdf(path):
+    """Return (width, height, ascent, {codepoint: rows of bits, top row first})"""
+    glyphs = {}
+    width = height = ascent = 0
+    with open(path) as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        if line.startswith("FONTBOUNDINGBOX"):
+            width, height, _, descent = (int(v) for v in line.split()[1:5])
+            ascent = height + descent
+        elif line.startswith("STARTCHAR"):
+            code, bbx, bitmap = None, None, []
+            for line in lines:
+                if line.startswith("ENCODING"):
+                    code = int(line.split()[1])
+                elif line.startswith("BBX"):
+                    bbx = [int(v) for v in line.split()[1:5]]
+                elif line.startswith("BITMAP"):
+                    for line in lines:
+                        if line.startswith("ENDCHAR"):
+                            break
+                        bitmap.append(int(line, 16))
+                    break
+            # Place the glyph bitmap in the font bounding box
+            gw, gh, gx, gy = bbx
+            row_bits = 8 * ((gw + 7) // 8)
+            rows = [[0] * width for _ in range(height)]
+            top = ascent - (gy + gh)
+            for r, bits in enumerate(bitmap):
+                for c in range(gw):
+                    if bits & (1 << (row_bits - 1 - c)) and 0 <= top + r < height and 0 <= gx + c < width:
+                        rows[top + r][gx + c] = 1
+            glyphs[code] = rows
+    return width, height, ascent, glyphs
+
+
+def emit_font(args, name, upper):
+    width, height, _, glyphs = load_bdf(args.input)
+    codes = sorted(c for c in glyphs if c >= 0)
+    first, last = codes[0], codes[-1]
+    stride = (width + 7) // 8
+    while stride % args.align:
+        stride += 1
+
+    out = [
+        "#define %s_WIDTH       %d" % (upper, width),
+        "#define %s_HEIGHT      %d" % (upper, height),
+        "#define %s_STRIDE      %d // Bytes per glyph row" % (upper, stride),
+        "#define %s_FIRST_CHAR  %d" % (upper, first),
+        "#define %s_GLYPH_COUNT %d" % (upper, last - first + 1),
+        "",
+        "// 1bpp glyphs for characters %d to %d, leftmost pixel in the most significant bit." % (first, last),
+        "// Characters missing from the font are blank.",
+        "static const uint8_t %s_glyphs[%d][%d] = {" % (name, last - first + 1, height * stride),
+    ]
+    blank = [[0] * width for _ in range(height)]
+    for code in range(first, last + 1):
+        rows = glyphs.get(code, blank)
+        data = b"".join(pack_row(row, "1bpp", args.align)[:stride].ljust(stride, b"\0") for row in rows)
+        label = chr(code) if 32 < code < 127 and chr(code) != "\\" else "0x%02x" % code
+        out.append("    {%s}, // %s" % (", ".join("0x%02x" % b for b in data), label))
+    out.append("};")
+    out.append("")
+    out.append("static inline const uint8_t* %s_glyph(char c)" % name)
+    out.append("{")
+    out.append("    const int index = (unsigned char)c - %s_FIRST_CHAR;" % upper)
+    out.append("    return (index >= 0 && index < %s_GLYPH_COUNT) ? %s_glyphs[index] : %s_glyphs[0];" % (upper, name, name))
+    out.append("}")
+    return "\n".join(out)
+
+
+def emit_palette(args, name, upper):
+    out = ["// RGB565 colours"]
+    entries = load_gpl(args.input)
+    width = max(len(re.sub(r"\W+", "_", n)) for n, _ in entries)
+    for entry_name, rgb in entries:
+        macro = "%s_%s" % (upper, re.sub(r"\W+", "_", entry_name).upper())
+        out.append("#define %s 0x%04x // #%02x%02x%02x" % (macro.ljust(len(upper) + 1 + width), rgb565(rgb), *rgb))
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("kind", choices=["image", "font", "palette"])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--name", help="C identifier prefix, defaults to the output file name")
+    parser.add_argument("--format", choices=sorted(BITS), default="rgb565", help="pixel format for images")
+    parser.add_argument("--palette", help="GIMP palette to quantise indexed images to")
+    parser.add_argument("--dither", action="store_true", help="apply 4x4 ordered dithering")
+    parser.add_argument("--rle", action="store_true", help="run-length encode each row")
+    parser.add_argument("--align", type=int, default=1, help="pad rows to a multiple of this many bytes")
+    parser.add_argument("--resize", help="resize images to WxH first (nearest neighbour)")
+    args = parser.parse_args()
+
+    name = args.name or os.path.splitext(os.path.basename(args.output))[0]
+    upper = name.upper()
+    body = {"image": emit_image, "font": emit_font, "palette": emit_palette}[args.kind](args, name, upper)
+
+    guard = upper + "_H"
+    text = HEADER.format(source=os.path.basename(args.input), guard=guard) + body + "\n\n#endif // %s\n" % guard
+    with open(args.output, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
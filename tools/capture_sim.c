@@ -0,0 +1,482 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Run the USB drive capture code (common/capture.h, common/fat_writer.h) against a FAT32 image
+// file standing in for the drive. The image is formatted, then a screenshot and a recording are
+// taken the way the snake firmware takes them: capture_poll() between groups of scanlines and
+// capture_frame() once per frame, on a simulated clock. The block device completes each command
+// after a fixed overhead plus a time per sector, but as on the Pico, where completions come from
+// tuh_task() between frames, the capture only sees a command finish at the next frame boundary.
+// The reported MB/s shows how well writing keeps the drive busy. Afterwards the files are read back through an independent FAT32 reader
+// and checked against the framebuffer. The image can be inspected with mtools or fsck.fat.
+//
+// Usage: capture_sim [-o image] [-s size_mb] [-c sectors_per_cluster] [-p] [-k]
+//                    [-f frames] [-l command_us] [-b sector_us]
+//   -p puts the volume in an MBR partition, -k keeps an existing image instead of formatting it.
+//   Defaults: capture.img, 512 MB, 4 KB clusters, 1000 us per command and 500 us per sector,
+//   roughly a full speed USB stick.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "capture.h"
+#include "fb_decoder.h"
+
+#define WIDTH  320
+#define HEIGHT 240
+
+// 640x480p60 with every framebuffer line shown twice, polled every 16 lines like the firmware
+#define FRAME_US        16683
+#define POLLS_PER_FRAME (HEIGHT / 16)
+
+static uint64_t now_us;
+static uint64_t usb_task_us; // When tuh_task() last ran, at the end of a frame
+
+typedef struct
+{
+    FILE* file;
+    uint64_t done_us; // Completion time of the command in progress
+    bool failed;
+    uint32_t command_us;
+    uint32_t sector_us;
+    uint64_t busy_us;
+} image_dev_t;
+
+static bool image_io(block_dev_t* dev, uint32_t lba, void* buffer, uint32_t count, bool write)
+{
+    image_dev_t* image = dev->context;
+    if (lba + count > dev->block_count || now_us < image->done_us)
+        return false;
+
+    bool ok = fseek(image->file, (long)lba * BLOCK_DEV_BLOCK_SIZE, SEEK_SET) == 0;
+    if (write)
+        ok = ok && fwrite(buffer, BLOCK_DEV_BLOCK_SIZE, count, image->file) == count;
+    else
+        ok = ok && fread(buffer, BLOCK_DEV_BLOCK_SIZE, count, image->file) == count;
+
+    const uint32_t cost = image->command_us + count * image->sector_us;
+    image->done_us = now_us + cost;
+    image->busy_us += cost;
+    image->failed = !ok;
+    return true;
+}
+
+static bool image_read(block_dev_t* dev, uint32_t lba, void* buffer, uint32_t count)
+{
+    return image_io(dev, lba, buffer, count, false);
+}
+
+static bool image_write(block_dev_t* dev, uint32_t lba, const void* buffer, uint32_t count)
+{
+    return image_io(dev, lba, (void*)buffer, count, true);
+}
+
+static block_dev_status_t image_status(block_dev_t* dev)
+{
+    const image_dev_t* image = dev->context;
+    if (usb_task_us < image->done_us)
+        return BLOCK_DEV_BUSY;
+    return image->failed ? BLOCK_DEV_ERROR : BLOCK_DEV_IDLE;
+}
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value & 0xff;
+    p[1] = value >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t value)
+{
+    put_u16(p, value & 0xffff);
+    put_u16(p + 2, value >> 16);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_sector(FILE* f, uint32_t lba, const uint8_t* sector)
+{
+    fseek(f, (long)lba * 512, SEEK_SET);
+    fwrite(sector, 512, 1, f);
+}
+
+static void read_sector(FILE* f, uint32_t lba, uint8_t* sector)
+{
+    fseek(f, (long)lba * 512, SEEK_SET);
+    if (fread(sector, 512, 1, f) != 1)
+        memset(sector, 0, 512);
+}
+
+// Format the image as FAT32, optionally inside an MBR partition starting at 1 MB
+static bool format_image(FILE* f, uint32_t sectors, uint32_t per_cluster, bool partition)
+{
+    const uint32_t start = partition ? 2048 : 0;
+    const uint32_t volume = sectors - start;
+    const uint32_t reserved = 32;
+    const uint32_t fat_sectors = (((volume - reserved) / per_cluster + 2) * 4 + 511) / 512;
+    const uint32_t clusters = (volume - reserved - 2 * fat_sectors) / per_cluster;
+    if (clusters < 65525)
+    {
+        fprintf(stderr, "%u clusters is too few for FAT32, use a bigger image or smaller clusters\n", clusters);
+        return false;
+    }
+
+    if (ftruncate(fileno(f), 0) != 0 || ftruncate(fileno(f), (off_t)sectors * 512) != 0)
+        return false;
+
+    uint8_t s[512];
+    if (partition)
+    {
+        memset(s, 0, sizeof(s));
+        s[446 + 4] = 0x0c; // FAT32 LBA
+        put_u32(s + 446 + 8, start);
+        put_u32(s + 446 + 12, volume);
+        s[510] = 0x55;
+        s[511] = 0xaa;
+        write_sector(f, 0, s);
+    }
+
+    memset(s, 0, sizeof(s));
+    memcpy(s, "\xeb\x58\x90MSWIN4.1", 11);
+    put_u16(s + 11, 512);
+    s[13] = (uint8_t)per_cluster;
+    put_u16(s + 14, reserved);
+    s[16] = 2;
+    s[21] = 0xf8;
+    put_u16(s + 24, 32);
+    put_u16(s + 26, 64);
+    put_u32(s + 28, start);
+    put_u32(s + 32, volume);
+    put_u32(s + 36, fat_sectors);
+    put_u32(s + 44, 2); // Root directory cluster
+    put_u16(s + 48, 1); // FSInfo
+    put_u16(s + 50, 6); // Backup boot sector
+    s[64] = 0x80;
+    s[66] = 0x29;
+    put_u32(s + 67, 0x4b495749);
+    memcpy(s + 71, "NO NAME    FAT32   ", 19);
+    s[510] = 0x55;
+    s[511] = 0xaa;
+    write_sector(f, start, s);
+    write_sector(f, start + 6, s);
+
+    memset(s, 0, sizeof(s));
+    put_u32(s, 0x41615252);
+    put_u32(s + 484, 0x61417272);
+    put_u32(s + 488, clusters - 1);
+    put_u32(s + 492, 3);
+    put_u32(s + 508, 0xaa550000);
+    write_sector(f, start + 1, s);
+    write_sector(f, start + 7, s);
+
+    memset(s, 0, sizeof(s));
+    put_u32(s, 0x0ffffff8);
+    put_u32(s + 4, 0x0fffffff);
+    put_u32(s + 8, 0x0fffffff); // Root directory, one cluster
+    write_sector(f, start + reserved, s);
+    write_sector(f, start + reserved + fat_sectors, s);
+    return true;
+}
+
+// Independent reader for checking the results
+typedef struct
+{
+    FILE* file;
+    uint32_t fat_start;
+    uint32_t fat_sectors;
+    uint32_t data_start;
+    uint32_t per_cluster;
+    uint32_t root;
+} volume_t;
+
+static void open_volume(volume_t* v, FILE* f, bool partition)
+{
+    uint8_t s[512];
+    const uint32_t start = partition ? 2048 : 0;
+    read_sector(f, start, s);
+    v->file = f;
+    v->per_cluster = s[13];
+    v->fat_start = start + (s[14] | (s[15] << 8));
+    v->fat_sectors = get_u32(s + 36);
+    v->data_start = v->fat_start + s[16] * v->fat_sectors;
+    v->root = get_u32(s + 44);
+}
+
+static uint32_t next_cluster(const volume_t* v, uint32_t cluster, int copy)
+{
+    uint8_t s[512];
+    read_sector(v->file, v->fat_start + copy * v->fat_sectors + cluster / 128, s);
+    return get_u32(s + 4 * (cluster % 128)) & 0x0fffffff;
+}
+
+// Read a root directory file into a new buffer, checking its cluster chain on the way
+static uint8_t* read_file(const volume_t* v, const char* name83, uint32_t* size)
+{
+    uint8_t s[512];
+    for (uint32_t dir = v->root; dir >= 2 && dir < 0x0ffffff8; dir = next_cluster(v, dir, 0))
+    {
+        for (uint32_t i = 0; i < v->per_cluster; ++i)
+        {
+            read_sector(v->file, v->data_start + (dir - 2) * v->per_cluster + i, s);
+            for (int e = 0; e < 16; ++e)
+            {
+                const uint8_t* entry = s + 32 * e;
+                if (entry[0] == 0)
+                    return NULL;
+                if (memcmp(entry, name83, 11) != 0)
+                    continue;
+
+                *size = get_u32(entry + 28);
+                uint32_t cluster = (entry[20] | (entry[21] << 8)) << 16 | entry[26] | (entry[27] << 8);
+                const uint32_t cluster_bytes = v->per_cluster * 512;
+                const uint32_t clusters = (*size + cluster_bytes - 1) / cluster_bytes;
+                uint8_t* data = malloc((size_t)clusters * cluster_bytes + 1);
+                for (uint32_t c = 0; c < clusters; ++c)
+                {
+                    if (cluster < 2 || cluster >= 0x0ffffff8)
+                    {
+                        printf("  %.11s: chain ends after %u of %u clusters\n", name83, c, clusters);
+                        free(data);
+                        return NULL;
+                    }
+                    for (uint32_t k = 0; k < v->per_cluster; ++k)
+                        read_sector(v->file, v->data_start + (cluster - 2) * v->per_cluster + k,
+                                    data + c * cluster_bytes + k * 512);
+                    const uint32_t next = next_cluster(v, cluster, 0);
+                    if (next != next_cluster(v, cluster, 1))
+                        printf("  %.11s: FAT copies differ at cluster %u\n", name83, cluster);
+                    cluster = next;
+                }
+                if (clusters > 0 && cluster < 0x0ffffff8)
+                {
+                    printf("  %.11s: chain longer than the file\n", name83);
+                    free(data);
+                    return NULL;
+                }
+                return data;
+            }
+        }
+    }
+    return NULL;
+}
+
+static uint16_t framebuffer[WIDTH * HEIGHT];
+static uint32_t tile_hashes[FB_STREAM_TILE_COUNT(WIDTH, HEIGHT)];
+static fat_writer_t writer;
+static capture_t capture;
+
+// A snake-like scene: border, background and a cell that moves every 15 frames
+static void draw_scene(uint32_t frame)
+{
+    for (int y = 0; y < HEIGHT; ++y)
+        for (int x = 0; x < WIDTH; ++x)
+        {
+            const bool border = x < 8 || y < 8 || x >= WIDTH - 8 || y >= HEIGHT - 8;
+            framebuffer[y * WIDTH + x] = border ? 0x7bef : (uint16_t)(0x0841 * ((x ^ y) >> 5 & 3));
+        }
+    const int step = frame / 15;
+    const int cx = 8 + (step * 8) % (WIDTH - 16);
+    const int cy = 8 + ((step * 8) / (WIDTH - 16) * 8) % (HEIGHT - 16);
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 8; ++x)
+            framebuffer[(cy + y) * WIDTH + cx + x] = 0x07e0;
+}
+
+// One displayed frame: polls between groups of lines, then the per-frame call
+static void run_frame(void)
+{
+    for (int i = 0; i < POLLS_PER_FRAME; ++i)
+    {
+        now_us += FRAME_US / POLLS_PER_FRAME;
+        capture_poll(&capture, now_us);
+    }
+    capture_frame(&capture);
+    capture_poll(&capture, now_us);
+    capture_poll_report(&capture);
+    usb_task_us = now_us;
+}
+
+static bool run_until_idle(uint32_t max_frames)
+{
+    for (uint32_t i = 0; i < max_frames && capture_busy(&capture); ++i)
+        run_frame();
+    return !capture_busy(&capture);
+}
+
+typedef struct
+{
+    uint32_t frames;
+    bool last_matches;
+} decode_check_t;
+
+static void on_frame(const fb_decoder_t* decoder, void* user)
+{
+    decode_check_t* check = user;
+    ++check->frames;
+    check->last_matches = memcmp(decoder->frame, framebuffer, sizeof(framebuffer)) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = "capture.img";
+    uint32_t size_mb = 512;
+    uint32_t per_cluster = 8;
+    bool partition = false;
+    bool keep = false;
+    uint32_t frames = 300;
+    image_dev_t image = {.command_us = 1000, .sector_us = 500};
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:s:c:pkf:l:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            path = optarg;
+            break;
+        case 's':
+            size_mb = atoi(optarg);
+            break;
+        case 'c':
+            per_cluster = atoi(optarg);
+            break;
+        case 'p':
+            partition = true;
+            break;
+        case 'k':
+            keep = true;
+            break;
+        case 'f':
+            frames = atoi(optarg);
+            break;
+        case 'l':
+            image.command_us = atoi(optarg);
+            break;
+        case 'b':
+            image.sector_us = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-o image] [-s size_mb] [-c sectors_per_cluster] [-p] [-k] [-f frames] "
+                            "[-l command_us] [-b sector_us]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    image.file = fopen(path, keep ? "r+b" : "w+b");
+    if (!image.file || (!keep && !format_image(image.file, size_mb * 2048, per_cluster, partition)))
+    {
+        fprintf(stderr, "Cannot set up %s\n", path);
+        return 1;
+    }
+    fseek(image.file, 0, SEEK_END);
+    block_dev_t dev = {.block_count = (uint32_t)(ftell(image.file) / 512), .read = image_read,
+                       .write = image_write, .status = image_status, .context = &image};
+
+    fat_writer_mount(&writer, &dev);
+    while (writer.state == FAT_WRITER_MOUNTING)
+    {
+        now_us += 100;
+        usb_task_us = now_us;
+        fat_writer_poll(&writer);
+    }
+    if (writer.state != FAT_WRITER_READY)
+    {
+        printf("Mount failed: %s\n", writer.error);
+        return 1;
+    }
+    printf("Mounted %s: %u clusters of %u sectors, drive limit %.2f MB/s\n", path, writer.max_cluster - 1,
+           writer.sectors_per_cluster, 512.0 / image.sector_us);
+    capture_init(&capture, &writer, framebuffer, WIDTH, HEIGHT, tile_hashes);
+
+    volume_t volume;
+    open_volume(&volume, image.file, partition);
+    bool ok = true;
+    char name[13];
+    char name83[12];
+
+    // Screenshot of a still frame
+    draw_scene(0);
+    image.busy_us = 0;
+    const uint64_t shot_start = now_us;
+    capture_screenshot(&capture, now_us);
+    ok &= run_until_idle(10000);
+    fat_writer_file_name(&writer, name);
+    memcpy(name83, name, 8);
+    memcpy(name83 + 8, name + 9, 3);
+    printf("  drive busy %u%% of the time\n", (unsigned)(image.busy_us * 100 / (now_us - shot_start)));
+
+    uint32_t size = 0;
+    uint8_t* data = read_file(&volume, name83, &size);
+    bool shot_ok = data && size == CAPTURE_BMP_HEADER_SIZE + sizeof(framebuffer) && data[0] == 'B' && data[1] == 'M';
+    for (int y = 0; shot_ok && y < HEIGHT; ++y)
+    {
+        const uint8_t* row = data + CAPTURE_BMP_HEADER_SIZE + (HEIGHT - 1 - y) * WIDTH * 2;
+        shot_ok = memcmp(row, &framebuffer[y * WIDTH], WIDTH * 2) == 0;
+    }
+    printf("  %s: %s\n", name, shot_ok ? "matches the framebuffer" : "WRONG");
+    ok &= shot_ok;
+    free(data);
+
+    // Recording of a moving scene that stands still for the last second
+    image.busy_us = 0;
+    const uint64_t record_start = now_us;
+    capture_record_start(&capture, now_us);
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        if (frame + 60 < frames)
+            draw_scene(frame);
+        run_frame();
+    }
+    capture_record_stop(&capture);
+    ok &= run_until_idle(10000);
+    fat_writer_file_name(&writer, name);
+    memcpy(name83, name, 8);
+    memcpy(name83 + 8, name + 9, 3);
+    printf("  drive busy %u%% of the time\n", (unsigned)(image.busy_us * 100 / (now_us - record_start)));
+
+    data = read_file(&volume, name83, &size);
+    decode_check_t check = {0};
+    fb_decoder_t decoder;
+    fb_decoder_init(&decoder);
+    if (data)
+        fb_decoder_feed(&decoder, data, size, on_frame, &check);
+    const bool record_ok = data && check.frames == capture.frames_recorded && decoder.bad_packets == 0 &&
+                           check.last_matches;
+    printf("  %s: %u frames decoded, %u bad packets, last frame %s\n", name, check.frames, decoder.bad_packets,
+           check.last_matches ? "matches" : "DIFFERS");
+    ok &= record_ok;
+    fb_decoder_free(&decoder);
+    free(data);
+
+    fclose(image.file);
+    printf("Check: %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
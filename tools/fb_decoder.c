@@ -0,0 +1,247 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fb_decoder.h"
+
+void fb_decoder_init(fb_decoder_t* decoder)
+{
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+void fb_decoder_free(fb_decoder_t* decoder)
+{
+    free(decoder->frame);
+    decoder->frame = NULL;
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+// Drop everything up to the next keyframe
+static void lose_sync(fb_decoder_t* decoder)
+{
+    if (decoder->in_frame)
+        ++decoder->frames_skipped;
+    decoder->synced = false;
+    decoder->in_frame = false;
+}
+
+static void frame_start(fb_decoder_t* decoder, const uint8_t* payload, size_t len)
+{
+    if (len != 9)
+    {
+        lose_sync(decoder);
+        return;
+    }
+
+    // The end of the previous frame went missing
+    if (decoder->in_frame)
+        lose_sync(decoder);
+
+    const uint32_t number = get_u32(payload);
+    const uint16_t width = get_u16(payload + 4);
+    const uint16_t height = get_u16(payload + 6);
+    const bool keyframe = payload[8];
+
+    if (keyframe)
+    {
+        if (width != decoder->width || height != decoder->height || decoder->frame == NULL)
+        {
+            free(decoder->frame);
+            decoder->frame = calloc((size_t)width * height, sizeof(uint16_t));
+            decoder->width = width;
+            decoder->height = height;
+        }
+        decoder->synced = decoder->frame != NULL;
+    }
+    else if (number != decoder->frame_number + 1)
+    {
+        // A whole frame went missing
+        decoder->synced = false;
+    }
+
+    if (!decoder->synced)
+        ++decoder->frames_skipped;
+
+    decoder->in_frame = decoder->synced;
+    decoder->frame_number = number;
+    decoder->tiles_received = 0;
+}
+
+static void tile(fb_decoder_t* decoder, const uint8_t* payload, size_t len)
+{
+    if (!decoder->in_frame)
+        return;
+
+    const uint32_t tiles_x = decoder->width / FB_STREAM_TILE_SIZE;
+    const uint32_t tiles_y = decoder->height / FB_STREAM_TILE_SIZE;
+    const uint32_t index = get_u16(payload);
+    if (len < 2 || (len - 2) % 3 != 0 || index >= tiles_x * tiles_y)
+    {
+        lose_sync(decoder);
+        return;
+    }
+
+    uint16_t* dst = &decoder->frame[(index / tiles_x) * FB_STREAM_TILE_SIZE * decoder->width +
+                                    (index % tiles_x) * FB_STREAM_TILE_SIZE];
+    uint32_t pixel = 0;
+    for (size_t i = 2; i < len; i += 3)
+    {
+        const uint32_t count = payload[i] + 1;
+        const uint16_t color = get_u16(&payload[i + 1]);
+        if (pixel + count > FB_STREAM_TILE_SIZE * FB_STREAM_TILE_SIZE)
+        {
+            lose_sync(decoder);
+            return;
+        }
+        for (uint32_t n = 0; n < count; ++n, ++pixel)
+        {
+            dst[(pixel / FB_STREAM_TILE_SIZE) * decoder->width + pixel % FB_STREAM_TILE_SIZE] = color;
+        }
+    }
+    if (pixel != FB_STREAM_TILE_SIZE * FB_STREAM_TILE_SIZE)
+    {
+        lose_sync(decoder);
+        return;
+    }
+    ++decoder->tiles_received;
+}
+
+static void frame_end(fb_decoder_t* decoder, const uint8_t* payload, size_t len, fb_decoder_frame_cb_t callback,
+                      void* user)
+{
+    if (!decoder->in_frame)
+        return;
+
+    if (len != 6 || get_u32(payload) != decoder->frame_number || get_u16(payload + 4) != decoder->tiles_received)
+    {
+        lose_sync(decoder);
+        return;
+    }
+
+    decoder->in_frame = false;
+    ++decoder->frames_decoded;
+    if (callback)
+        callback(decoder, user);
+}
+
+static void dispatch(fb_decoder_t* decoder, fb_decoder_frame_cb_t callback, void* user)
+{
+    const uint8_t type = decoder->packet[0];
+    const size_t payload_len = decoder->packet_expected - 4;
+    const uint8_t* payload = &decoder->packet[3];
+
+    if (fb_stream_crc8(0, decoder->packet, 3 + payload_len) != decoder->packet[3 + payload_len])
+    {
+        ++decoder->bad_packets;
+        lose_sync(decoder);
+        return;
+    }
+
+    switch (type)
+    {
+    case FB_STREAM_PACKET_FRAME_START:
+        frame_start(decoder, payload, payload_len);
+        break;
+    case FB_STREAM_PACKET_TILE:
+        tile(decoder, payload, payload_len);
+        break;
+    case FB_STREAM_PACKET_FRAME_END:
+        frame_end(decoder, payload, payload_len, callback, user);
+        break;
+    default:
+        ++decoder->bad_packets;
+        break;
+    }
+}
+
+// Feed raw bytes received from the UART. Anything between packets, such as log output,
+// is skipped over.
+void fb_decoder_feed(fb_decoder_t* decoder, const uint8_t* data, size_t len, fb_decoder_frame_cb_t callback,
+                     void* user)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        const uint8_t byte = data[i];
+
+        switch (decoder->state)
+        {
+        case FB_DECODER_SYNC_0:
+            if (byte == FB_STREAM_SYNC_0)
+                decoder->state = FB_DECODER_SYNC_1;
+            break;
+
+        case FB_DECODER_SYNC_1:
+            if (byte == FB_STREAM_SYNC_1)
+            {
+                decoder->packet_len = 0;
+                decoder->state = FB_DECODER_HEADER;
+            }
+            else if (byte != FB_STREAM_SYNC_0)
+            {
+                decoder->state = FB_DECODER_SYNC_0;
+            }
+            break;
+
+        case FB_DECODER_HEADER:
+            // Type and payload length
+            decoder->packet[decoder->packet_len++] = byte;
+            if (decoder->packet_len == 3)
+            {
+                decoder->packet_expected = 3 + get_u16(&decoder->packet[1]) + 1;
+                if (decoder->packet_expected > sizeof(decoder->packet))
+                {
+                    ++decoder->bad_packets;
+                    lose_sync(decoder);
+                    decoder->state = FB_DECODER_SYNC_0;
+                }
+                else
+                {
+                    decoder->state = FB_DECODER_PAYLOAD;
+                }
+            }
+            break;
+
+        case FB_DECODER_PAYLOAD:
+            decoder->packet[decoder->packet_len++] = byte;
+            if (decoder->packet_len == decoder->packet_expected)
+            {
+                dispatch(decoder, callback, user);
+                decoder->state = FB_DECODER_SYNC_0;
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef FB_DECODER_H
+#define FB_DECODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fb_stream.h"
+
+// Parser states
+typedef enum
+{
+    FB_DECODER_SYNC_0 = 0,
+    FB_DECODER_SYNC_1,
+    FB_DECODER_HEADER,
+    FB_DECODER_PAYLOAD
+} fb_decoder_state_t;
+
+typedef struct
+{
+    // Reconstructed frame
+    uint16_t width;
+    uint16_t height;
+    uint16_t* frame;
+    uint32_t frame_number;
+
+    // True once a keyframe has been received and no packet has been lost since
+    bool synced;
+    bool in_frame;
+    uint16_t tiles_received;
+
+    // Packet parser
+    fb_decoder_state_t state;
+    uint8_t packet[FB_STREAM_MAX_PACKET];
+    size_t packet_len;
+    size_t packet_expected;
+
+    // Statistics
+    uint32_t frames_decoded;
+    uint32_t frames_skipped;
+    uint32_t bad_packets;
+} fb_decoder_t;
+
+// Invoked for every complete frame
+typedef void (*fb_decoder_frame_cb_t)(const fb_decoder_t* decoder, void* user);
+
+// Function declarations
+void fb_decoder_init(fb_decoder_t* decoder);
+void fb_decoder_free(fb_decoder_t* decoder);
+void fb_decoder_feed(fb_decoder_t* decoder, const uint8_t* data, size_t len, fb_decoder_frame_cb_t callback,
+                     void* user);
+
+#endif // FB_DECODER_H
@@ -0,0 +1,133 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Rebuild frames streamed by the firmware over UART (see common/fb_stream.h) from a
+// capture of the serial port, and write them as PNG files or a Y4M video.
+//
+// Usage: fbdecode [-f png|y4m] [-o output] [-r fps] [capture]
+//   png: one file per frame, named <output>_NNNNN.png (default output "frame")
+//   y4m: a single video file (default output "frames.y4m")
+// The capture is read from stdin when no file is given, e.g. straight from the serial device.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fb_decoder.h"
+#include "image_io.h"
+
+typedef struct
+{
+    bool y4m;
+    const char* output;
+    uint32_t fps;
+    FILE* video;
+} output_t;
+
+static void write_frame(const fb_decoder_t* decoder, void* user)
+{
+    output_t* out = user;
+
+    if (out->y4m)
+    {
+        if (!out->video)
+        {
+            out->video = fopen(out->output, "wb");
+            if (!out->video)
+            {
+                perror(out->output);
+                exit(1);
+            }
+            image_write_y4m_header(out->video, decoder->width, decoder->height, out->fps);
+        }
+        image_write_y4m_frame(out->video, decoder->frame, decoder->width, decoder->height);
+    }
+    else
+    {
+        char path[512];
+        snprintf(path, sizeof(path), "%s_%05u.png", out->output, decoder->frame_number);
+        if (!image_write_png(path, decoder->frame, decoder->width, decoder->height))
+            fprintf(stderr, "Cannot write %s\n", path);
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: fbdecode [-f png|y4m] [-o output] [-r fps] [capture]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    output_t out = {.y4m = false, .output = NULL, .fps = 10, .video = NULL};
+    const char* input = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            ++i;
+            if (strcmp(argv[i], "y4m") == 0)
+                out.y4m = true;
+            else if (strcmp(argv[i], "png") != 0)
+                usage();
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out.output = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            out.fps = atoi(argv[++i]);
+        else if (argv[i][0] == '-')
+            usage();
+        else
+            input = argv[i];
+    }
+    if (!out.output)
+        out.output = out.y4m ? "frames.y4m" : "frame";
+
+    FILE* in = input ? fopen(input, "rb") : stdin;
+    if (!in)
+    {
+        perror(input);
+        return 1;
+    }
+
+    fb_decoder_t decoder;
+    fb_decoder_init(&decoder);
+
+    uint8_t buffer[4096];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        fb_decoder_feed(&decoder, buffer, len, write_frame, &out);
+
+    fprintf(stderr, "%u frames decoded, %u frames skipped, %u bad packets\n", decoder.frames_decoded,
+            decoder.frames_skipped, decoder.bad_packets);
+
+    if (out.video)
+        fclose(out.video);
+    if (in != stdin)
+        fclose(in);
+    fb_decoder_free(&decoder);
+    return 0;
+}
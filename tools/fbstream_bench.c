@@ -0,0 +1,150 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Measure the throughput of the framebuffer stream encoder on the host, and check that
+// the decoder rebuilds every frame exactly. Frames mimic the snake game: a border, a
+// plain background and a snake that moves one block per frame.
+//
+// Usage: fbstream_bench [frames] [width height]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fb_decoder.h"
+#include "fb_stream.h"
+
+#define BLOCK_SIZE       8
+#define BORDER_COLOR     0x3bbb
+#define BACKGROUND_COLOR 0x9f53
+#define SNAKE_COLOR      0x1ca3
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_block(uint16_t* fb, uint32_t width, uint32_t bx, uint32_t by, uint16_t color)
+{
+    for (uint32_t y = 0; y < BLOCK_SIZE; ++y)
+        for (uint32_t x = 0; x < BLOCK_SIZE; ++x)
+            fb[(by * BLOCK_SIZE + y) * width + bx * BLOCK_SIZE + x] = color;
+}
+
+typedef struct
+{
+    const uint16_t* source;
+    size_t pixels;
+    uint32_t mismatches;
+} check_t;
+
+static void compare_frame(const fb_decoder_t* decoder, void* user)
+{
+    check_t* check = user;
+    if (memcmp(decoder->frame, check->source, check->pixels * sizeof(uint16_t)) != 0)
+        ++check->mismatches;
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t frames = argc > 1 ? atoi(argv[1]) : 2000;
+    const uint32_t width = argc > 3 ? atoi(argv[2]) : 320;
+    const uint32_t height = argc > 3 ? atoi(argv[3]) : 240;
+    const uint32_t grid_w = width / BLOCK_SIZE;
+    const uint32_t grid_h = height / BLOCK_SIZE;
+
+    uint16_t* fb = malloc((size_t)width * height * sizeof(uint16_t));
+    uint32_t* hashes = malloc(FB_STREAM_TILE_COUNT(width, height) * sizeof(uint32_t));
+    // Large enough for a keyframe of noise
+    const size_t out_size = FB_STREAM_TILE_COUNT(width, height) * FB_STREAM_MAX_PACKET + 64;
+    uint8_t* out = malloc(out_size);
+
+    for (uint32_t by = 0; by < grid_h; ++by)
+        for (uint32_t bx = 0; bx < grid_w; ++bx)
+        {
+            const bool border = bx == 0 || by == 0 || bx == grid_w - 1 || by == grid_h - 1;
+            fill_block(fb, width, bx, by, border ? BORDER_COLOR : BACKGROUND_COLOR);
+        }
+
+    fb_stream_t stream;
+    fb_stream_init(&stream, fb, width, height, hashes);
+    fb_decoder_t decoder;
+    fb_decoder_init(&decoder);
+    check_t check = {.source = fb, .pixels = (size_t)width * height, .mismatches = 0};
+
+    // Snake of 5 blocks walking around the inside of the border
+    const uint32_t length = 5;
+    const uint32_t lap = 2 * (grid_w - 3) + 2 * (grid_h - 3);
+    uint64_t keyframe_bytes = 0, delta_bytes = 0;
+    double encode_time = 0;
+
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        const uint32_t pos[2] = {frame % lap, (frame + lap - length) % lap};
+        for (int i = 0; i < 2; ++i)
+        {
+            uint32_t p = pos[i], bx, by;
+            if (p < grid_w - 3)
+                bx = 1 + p, by = 1;
+            else if ((p -= grid_w - 3) < grid_h - 3)
+                bx = grid_w - 2, by = 1 + p;
+            else if ((p -= grid_h - 3) < grid_w - 3)
+                bx = grid_w - 2 - p, by = grid_h - 2;
+            else
+                bx = 1, by = grid_h - 2 - (p - (grid_w - 3));
+            fill_block(fb, width, bx, by, i == 0 ? SNAKE_COLOR : BACKGROUND_COLOR);
+        }
+
+        const bool keyframe = frame % 100 == 0;
+        const double start = now_seconds();
+        fb_stream_begin_frame(&stream, keyframe);
+        const size_t len = fb_stream_encode(&stream, out, out_size, UINT32_MAX);
+        encode_time += now_seconds() - start;
+
+        if (keyframe)
+            keyframe_bytes += len;
+        else
+            delta_bytes += len;
+        fb_decoder_feed(&decoder, out, len, compare_frame, &check);
+    }
+
+    const uint32_t keyframes = (frames + 99) / 100;
+    const double megabytes = (double)frames * width * height * sizeof(uint16_t) / 1e6;
+    printf("%ux%u, %u frames\n", width, height, frames);
+    printf("Encode: %.1f MB/s of framebuffer, %.1f us per frame\n", megabytes / encode_time,
+           encode_time * 1e6 / frames);
+    printf("Keyframe: %.0f bytes, delta frame: %.1f bytes\n", (double)keyframe_bytes / keyframes,
+           frames > keyframes ? (double)delta_bytes / (frames - keyframes) : 0.0);
+    printf("Decoded %u frames, %u mismatches\n", decoder.frames_decoded, check.mismatches);
+
+    fb_decoder_free(&decoder);
+    free(out);
+    free(hashes);
+    free(fb);
+    return check.mismatches != 0 || decoder.frames_decoded != frames;
+}
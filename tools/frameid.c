@@ -0,0 +1,522 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Analyse a capture of frameDisplay built with -DFRAMEDISPLAY_FRAME_ID=ON. Every captured
+// frame's ID strips (see common/frame_id.h) are decoded and the sequence is checked for
+// dropped, duplicated and torn frames. The capture time of each new frame is fitted against
+// its frame number, and the residuals give the presentation jitter.
+//
+// Usage: frameid [-r capture_fps] [-v] [capture]
+//   The capture is a Y4M video or a stream of binary PPM/PGM images, read from stdin when no
+//   file is given. Other formats can be piped through ffmpeg:
+//     ffmpeg -i capture.mkv -f yuv4mpegpipe -pix_fmt yuv444p - | frameid
+//   The capture rate is taken from the Y4M header, or -r (default 60).
+//
+// Usage: frameid -t [-v]
+//   Self-test: draws a known sequence of strips with the firmware's encoder into a synthetic
+//   capture, with dropped, duplicated, torn and corrupted frames, and checks that the report
+//   counts each of them exactly. Exits with 1 if it does not.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_id.h"
+
+typedef struct
+{
+    FILE* in;
+    bool y4m;
+    int width;
+    int height;
+    size_t chroma_bytes; // Y4M chroma planes following the luma plane
+    double fps;
+} capture_t;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t unreadable;
+    uint32_t torn;
+    uint32_t duplicated;
+    uint32_t dropped;
+    uint32_t out_of_order;
+    bool have_previous;
+    uint32_t previous;
+
+    // Least squares fit of capture time against frame number, over new frames only
+    uint32_t first_id;
+    uint32_t samples;
+    double sum_x, sum_y, sum_xx, sum_xy;
+    double* times;
+    uint32_t* ids;
+    uint32_t capacity;
+} stats_t;
+
+static bool read_token(FILE* in, char* token, size_t size)
+{
+    int c;
+    do
+    {
+        c = fgetc(in);
+        if (c == '#')
+        {
+            while (c != '\n' && c != EOF)
+                c = fgetc(in);
+        }
+    } while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+
+    size_t n = 0;
+    while (c != EOF && c != ' ' && c != '\t' && c != '\n' && c != '\r')
+    {
+        if (n + 1 < size)
+            token[n++] = (char)c;
+        c = fgetc(in);
+    }
+    token[n] = '\0';
+    return n > 0;
+}
+
+static bool open_y4m(capture_t* cap)
+{
+    char line[256];
+    if (!fgets(line, sizeof(line), cap->in))
+        return false;
+
+    char colour[16] = "420";
+    for (char* tok = strtok(line, " \n"); tok; tok = strtok(NULL, " \n"))
+    {
+        if (tok[0] == 'W')
+            cap->width = atoi(tok + 1);
+        else if (tok[0] == 'H')
+            cap->height = atoi(tok + 1);
+        else if (tok[0] == 'F')
+        {
+            int num = 0, den = 1;
+            if (sscanf(tok + 1, "%d:%d", &num, &den) == 2 && den > 0)
+                cap->fps = (double)num / den;
+        }
+        else if (tok[0] == 'C')
+            snprintf(colour, sizeof(colour), "%s", tok + 1);
+    }
+
+    const size_t w = cap->width, h = cap->height;
+    if (strncmp(colour, "444", 3) == 0)
+        cap->chroma_bytes = 2 * w * h;
+    else if (strncmp(colour, "422", 3) == 0)
+        cap->chroma_bytes = 2 * ((w + 1) / 2) * h;
+    else if (strncmp(colour, "mono", 4) == 0)
+        cap->chroma_bytes = 0;
+    else
+        cap->chroma_bytes = 2 * ((w + 1) / 2) * ((h + 1) / 2);
+
+    cap->y4m = true;
+    return cap->width > 0 && cap->height > 0;
+}
+
+// Read the next frame's luma plane, reallocating it when the size changes
+static bool read_frame(capture_t* cap, uint8_t** luma, size_t* luma_size)
+{
+    if (cap->y4m)
+    {
+        char line[256];
+        if (!fgets(line, sizeof(line), cap->in) || strncmp(line, "FRAME", 5) != 0)
+            return false;
+        const size_t size = (size_t)cap->width * cap->height;
+        if (*luma_size < size)
+        {
+            *luma = realloc(*luma, size);
+            *luma_size = size;
+        }
+        if (fread(*luma, 1, size, cap->in) != size)
+            return false;
+
+        // Skip the chroma planes by reading, the capture may be a pipe
+        uint8_t skip[4096];
+        for (size_t left = cap->chroma_bytes; left > 0;)
+        {
+            const size_t n = left < sizeof(skip) ? left : sizeof(skip);
+            if (fread(skip, 1, n, cap->in) != n)
+                return false;
+            left -= n;
+        }
+        return true;
+    }
+
+    char magic[8], token[32];
+    if (!read_token(cap->in, magic, sizeof(magic)) || (strcmp(magic, "P5") != 0 && strcmp(magic, "P6") != 0))
+        return false;
+    if (!read_token(cap->in, token, sizeof(token)))
+        return false;
+    cap->width = atoi(token);
+    if (!read_token(cap->in, token, sizeof(token)))
+        return false;
+    cap->height = atoi(token);
+    if (!read_token(cap->in, token, sizeof(token)) || atoi(token) > 255)
+        return false;
+
+    const bool rgb = magic[1] == '6';
+    const size_t size = (size_t)cap->width * cap->height;
+    if (*luma_size < size * 3)
+    {
+        *luma = realloc(*luma, size * 3);
+        *luma_size = size * 3;
+    }
+    if (fread(*luma, 1, rgb ? size * 3 : size, cap->in) != (rgb ? size * 3 : size))
+        return false;
+    if (rgb)
+    {
+        uint8_t* px = *luma;
+        for (size_t i = 0; i < size; ++i)
+        {
+            px[i] = (uint8_t)((px[3 * i] * 77 + px[3 * i + 1] * 150 + px[3 * i + 2] * 29) >> 8);
+        }
+    }
+    return true;
+}
+
+// Try the rows of one strip from the edge inwards. The strip is FRAME_ID_HEIGHT lines out of
+// at least 120, so the first 1/40 of the picture height is inside it at any scale.
+static bool decode_strip(const uint8_t* luma, const capture_t* cap, bool bottom, uint32_t* frame)
+{
+    const int rows = cap->height / 40 > 0 ? cap->height / 40 : 1;
+    for (int i = 0; i < rows; ++i)
+    {
+        const int y = bottom ? cap->height - 1 - i : i;
+        if (frame_id_decode(&luma[(size_t)y * cap->width], cap->width, frame))
+            return true;
+    }
+    return false;
+}
+
+static void add_sample(stats_t* stats, uint32_t id, double t)
+{
+    if (stats->samples == 0)
+        stats->first_id = id;
+    if (stats->samples == stats->capacity)
+    {
+        stats->capacity = stats->capacity ? stats->capacity * 2 : 1024;
+        stats->times = realloc(stats->times, stats->capacity * sizeof(double));
+        stats->ids = realloc(stats->ids, stats->capacity * sizeof(uint32_t));
+    }
+    const double x = (double)(id - stats->first_id);
+    stats->times[stats->samples] = t;
+    stats->ids[stats->samples] = id;
+    stats->samples++;
+    stats->sum_x += x;
+    stats->sum_y += t;
+    stats->sum_xx += x * x;
+    stats->sum_xy += x * t;
+}
+
+static void report_jitter(const stats_t* stats)
+{
+    const double n = stats->samples;
+    const double denom = n * stats->sum_xx - stats->sum_x * stats->sum_x;
+    if (stats->samples < 3 || denom == 0)
+    {
+        printf("Jitter: not enough frames\n");
+        return;
+    }
+
+    const double slope = (n * stats->sum_xy - stats->sum_x * stats->sum_y) / denom;
+    const double offset = (stats->sum_y - slope * stats->sum_x) / n;
+    double sum_sq = 0, worst = 0;
+    for (uint32_t i = 0; i < stats->samples; ++i)
+    {
+        const double residual = stats->times[i] - (offset + slope * (double)(stats->ids[i] - stats->first_id));
+        sum_sq += residual * residual;
+        if (fabs(residual) > worst)
+            worst = fabs(residual);
+    }
+
+    printf("Display rate: %.3f Hz\n", 1.0 / slope);
+    printf("Jitter: %.3f ms rms, %.3f ms max\n", 1000.0 * sqrt(sum_sq / n), 1000.0 * worst);
+}
+
+// Decode every frame of the capture and check the sequence
+static void analyse(capture_t* cap, stats_t* stats, bool verbose)
+{
+    uint8_t* luma = NULL;
+    size_t luma_size = 0;
+
+    while (read_frame(cap, &luma, &luma_size))
+    {
+        const uint32_t index = stats->frames++;
+        uint32_t top, bottom;
+        const bool top_ok = decode_strip(luma, cap, false, &top);
+        const bool bottom_ok = decode_strip(luma, cap, true, &bottom);
+
+        if (!top_ok && !bottom_ok)
+        {
+            stats->unreadable++;
+            if (verbose)
+                printf("%6u: unreadable\n", index);
+            continue;
+        }
+        if (top_ok && bottom_ok && top != bottom)
+        {
+            stats->torn++;
+            if (verbose)
+                printf("%6u: torn %u/%u\n", index, top, bottom);
+        }
+
+        // A torn frame shows the start of a frame on top and its successor below,
+        // so the top strip names the frame that appeared first
+        const uint32_t id = top_ok ? top : bottom;
+        if (verbose)
+            printf("%6u: frame %u\n", index, id);
+
+        if (stats->have_previous)
+        {
+            const int32_t step = (int32_t)(id - stats->previous);
+            if (step == 0)
+            {
+                stats->duplicated++;
+                continue;
+            }
+            if (step < 0)
+            {
+                stats->out_of_order++;
+                if (verbose)
+                    printf("%6u: went back from %u to %u\n", index, stats->previous, id);
+                stats->previous = id;
+                continue;
+            }
+            stats->dropped += (uint32_t)step - 1;
+        }
+        stats->have_previous = true;
+        stats->previous = id;
+        add_sample(stats, id, index / cap->fps);
+    }
+
+    free(luma);
+}
+
+static void report(const capture_t* cap, const stats_t* stats)
+{
+    printf("Captured frames: %u at %.3f fps, %ux%u\n", stats->frames, cap->fps, cap->width, cap->height);
+    printf("Unique frames: %u\n", stats->samples);
+    printf("Dropped: %u\n", stats->dropped);
+    printf("Duplicated: %u\n", stats->duplicated);
+    printf("Torn: %u\n", stats->torn);
+    printf("Unreadable: %u\n", stats->unreadable);
+    if (stats->out_of_order)
+        printf("Out of order: %u\n", stats->out_of_order);
+    report_jitter(stats);
+}
+
+// Self-test frames, numbered from SELF_TEST_FIRST so the sequence crosses the 32-bit wrap
+#define SELF_TEST_FIRST  0xfffffffau
+#define SELF_TEST_WIDTH  320 // The frameDisplay framebuffer, shown at twice the size
+#define SELF_TEST_HEIGHT 240
+#define CORRUPT_TOP      1
+#define CORRUPT_BOTTOM   2
+
+typedef struct
+{
+    uint32_t top; // Frame numbers relative to SELF_TEST_FIRST
+    uint32_t bottom;
+    uint8_t corrupt;
+} test_frame_t;
+
+static const test_frame_t test_frames[] = {
+    {0, 0, 0},
+    {1, 1, 0},
+    {2, 2, 0},
+    {3, 3, 0},
+    {4, 4, 0},
+    {7, 7, 0}, // 5 and 6 dropped
+    {8, 8, 0},
+    {8, 8, 0}, // Duplicated
+    {9, 10, 0}, // Torn
+    {10, 10, 0},
+    {11, 11, CORRUPT_TOP | CORRUPT_BOTTOM}, // Unreadable
+    {11, 11, CORRUPT_TOP}, // Read from the bottom strip
+    {12, 12, CORRUPT_BOTTOM},
+    {15, 15, 0}, // 13 and 14 dropped
+    {15, 15, 0}, // Duplicated
+    {16, 16, 0},
+};
+
+// What the report has to say about test_frames
+#define TEST_UNIQUE     13
+#define TEST_DROPPED    4
+#define TEST_DUPLICATED 2
+#define TEST_TORN       1
+#define TEST_UNREADABLE 1
+
+// Draw one strip the way frameDisplay does, into rows of a luma framebuffer. A corrupted strip
+// has the cells of the last checksum bit swapped, which is still valid Manchester code.
+static void draw_test_strip(uint8_t* frame, int y0, uint32_t id, bool corrupt)
+{
+    uint8_t row[SELF_TEST_WIDTH / 8];
+    frame_id_encode(id, row, SELF_TEST_WIDTH);
+    if (corrupt)
+    {
+        const int cell_width = SELF_TEST_WIDTH / FRAME_ID_CELLS;
+        for (int x = (FRAME_ID_CELLS - 2) * cell_width; x < SELF_TEST_WIDTH; ++x)
+        {
+            row[x >> 3] ^= 0x80 >> (x & 7);
+        }
+    }
+    for (int y = y0; y < y0 + FRAME_ID_HEIGHT; ++y)
+    {
+        for (int x = 0; x < SELF_TEST_WIDTH; ++x)
+        {
+            frame[y * SELF_TEST_WIDTH + x] = (row[x >> 3] & (0x80 >> (x & 7))) ? 235 : 16;
+        }
+    }
+}
+
+// Write test_frames as a 640x480 Y4M capture with some noise, decode it and check the counts
+static int self_test(bool verbose)
+{
+    static uint8_t frame[SELF_TEST_WIDTH * SELF_TEST_HEIGHT];
+    static uint8_t luma[4 * SELF_TEST_WIDTH * SELF_TEST_HEIGHT];
+    static uint8_t chroma[2 * SELF_TEST_WIDTH * SELF_TEST_HEIGHT]; // Two quarter-size planes
+    const int width = 2 * SELF_TEST_WIDTH;
+    const int height = 2 * SELF_TEST_HEIGHT;
+
+    FILE* f = tmpfile();
+    if (!f)
+    {
+        perror("tmpfile");
+        return 1;
+    }
+    fprintf(f, "YUV4MPEG2 W%d H%d F60:1 Ip C420jpeg\n", width, height);
+    memset(chroma, 128, sizeof(chroma));
+
+    uint32_t random = 2463534242u;
+    for (size_t i = 0; i < sizeof(test_frames) / sizeof(test_frames[0]); ++i)
+    {
+        const test_frame_t* t = &test_frames[i];
+        for (size_t p = 0; p < sizeof(frame); ++p)
+        {
+            frame[p] = (uint8_t)(64 + (p + i) % 128);
+        }
+        draw_test_strip(frame, 0, SELF_TEST_FIRST + t->top, t->corrupt & CORRUPT_TOP);
+        draw_test_strip(frame, SELF_TEST_HEIGHT - FRAME_ID_HEIGHT, SELF_TEST_FIRST + t->bottom,
+                        t->corrupt & CORRUPT_BOTTOM);
+
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+                const int noise = (int)(random % 17) - 8;
+                luma[y * width + x] = (uint8_t)(frame[(y / 2) * SELF_TEST_WIDTH + x / 2] + noise);
+            }
+        }
+        fprintf(f, "FRAME\n");
+        fwrite(luma, 1, sizeof(luma), f);
+        fwrite(chroma, 1, sizeof(chroma), f);
+    }
+    rewind(f);
+
+    capture_t cap = {.in = f};
+    stats_t stats = {0};
+    if (!open_y4m(&cap))
+    {
+        fprintf(stderr, "Bad Y4M header\n");
+        fclose(f);
+        return 1;
+    }
+    analyse(&cap, &stats, verbose);
+    report(&cap, &stats);
+    fclose(f);
+    free(stats.times);
+    free(stats.ids);
+
+    const bool ok = stats.frames == sizeof(test_frames) / sizeof(test_frames[0]) && stats.samples == TEST_UNIQUE &&
+                    stats.dropped == TEST_DROPPED && stats.duplicated == TEST_DUPLICATED && stats.torn == TEST_TORN &&
+                    stats.unreadable == TEST_UNREADABLE && stats.out_of_order == 0;
+    printf("Check: %s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: frameid [-r capture_fps] [-v] [capture]\n       frameid -t [-v]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    capture_t cap = {.in = stdin, .fps = 0};
+    double fps_option = 0;
+    bool verbose = false;
+    bool test = false;
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            fps_option = atof(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else if (strcmp(argv[i], "-t") == 0)
+            test = true;
+        else if (argv[i][0] == '-' && argv[i][1] != '\0')
+            usage();
+        else
+            path = argv[i];
+    }
+    if (test)
+        return self_test(verbose);
+
+    if (path && !(cap.in = fopen(path, "rb")))
+    {
+        perror(path);
+        return 1;
+    }
+
+    const int first = fgetc(cap.in);
+    ungetc(first, cap.in);
+    if (first == 'Y' && !open_y4m(&cap))
+    {
+        fprintf(stderr, "Bad Y4M header\n");
+        return 1;
+    }
+    if (fps_option > 0)
+        cap.fps = fps_option;
+    if (cap.fps <= 0)
+        cap.fps = 60;
+
+    stats_t stats = {0};
+    analyse(&cap, &stats, verbose);
+    report(&cap, &stats);
+
+    free(stats.times);
+    free(stats.ids);
+    if (cap.in != stdin)
+        fclose(cap.in);
+    return 0;
+}
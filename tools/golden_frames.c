@@ -0,0 +1,292 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Golden-image regression test for the renderers. Scripted scenarios are drawn with the
+// firmware's own drawing code (snake/game.c over common/renderer.h, and frameDisplay's digit
+// layout), every frame is signed with common/frame_crc.h as scanout signs it with
+// -DFRAME_CRC=ON, and the signatures are compared with the golden files in tools/golden. A
+// renderer change that keeps every signature draws exactly the same pixels.
+//
+// Usage: golden_frames [-u] [-p] [-v] [-d golden_dir]
+//   -u rewrites the golden files from this run, -p prints every signature, -v shows the game's
+//   log output. Exits with 1 if any frame differs from its golden signature.
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "digits_font.h"
+#include "frame_crc.h"
+#include "main.h"
+#include "renderer.h"
+
+#define MAX_FRAMES 2048
+
+typedef struct
+{
+    const char* name;
+    uint32_t (*run)(uint32_t* crcs);
+} scenario_t;
+
+static uint16_t framebuffer[FRAME_HEIGHT * FRAME_WIDTH];
+static bool verbose;
+
+// game.c is built with printf() renamed to this, see CMakeLists.txt
+int game_log(const char* format, ...)
+{
+    if (!verbose)
+        return 0;
+    va_list args;
+    va_start(args, format);
+    const int n = vprintf(format, args);
+    va_end(args);
+    return n;
+}
+
+static uint32_t sign_frame(void)
+{
+    return frame_crc_frame(framebuffer, FRAME_WIDTH, FRAME_HEIGHT);
+}
+
+// Snake drawing, as snake/main.c does it with the linear framebuffer
+void draw_border(void)
+{
+    render_fill_rect(framebuffer, 0, 0, FRAME_WIDTH, BORDER_SIZE, BORDER_COLOR);
+    render_fill_rect(framebuffer, 0, FRAME_HEIGHT - BORDER_SIZE, FRAME_WIDTH, BORDER_SIZE, BORDER_COLOR);
+    render_fill_rect(framebuffer, 0, BORDER_SIZE, BORDER_SIZE, FRAME_HEIGHT - 2 * BORDER_SIZE, BORDER_COLOR);
+    render_fill_rect(framebuffer, FRAME_WIDTH - BORDER_SIZE, BORDER_SIZE, BORDER_SIZE,
+                     FRAME_HEIGHT - 2 * BORDER_SIZE, BORDER_COLOR);
+}
+
+void draw_cell(int x, int y, uint16_t color)
+{
+    render_fill_cell(framebuffer, x, y, BLOCK_SIZE, color);
+}
+
+void draw_partial_cell(int x, int y, direction_t side, int filled, uint16_t color)
+{
+}
+
+// Steering at a given tick
+typedef struct
+{
+    uint32_t tick;
+    direction_t direction;
+} steer_t;
+
+// Down and left onto the first food, a lap of the playfield, then into the bottom border to
+// exercise a reset, and a second run that ends in the top border
+static const steer_t snake_script[] = {
+    {3, DIRECTION_DOWN},    {8, DIRECTION_LEFT},  {18, DIRECTION_DOWN},  {28, DIRECTION_RIGHT},
+    {60, DIRECTION_UP},     {77, DIRECTION_LEFT}, {92, DIRECTION_DOWN},  {125, DIRECTION_DOWN},
+    {135, DIRECTION_RIGHT}, {150, DIRECTION_UP},
+};
+
+#define SNAKE_TICKS 180
+
+// One frame per game tick, after the snakes have moved
+static uint32_t run_snake(uint32_t* crcs)
+{
+    uint32_t frames = 0;
+    render_fill_rect(framebuffer, 0, 0, FRAME_WIDTH, FRAME_HEIGHT, BACKGROUND_COLOR);
+    draw_border();
+    reset_game();
+    crcs[frames++] = sign_frame();
+
+    uint32_t next = 0;
+    for (uint32_t tick = 0; tick < SNAKE_TICKS; ++tick)
+    {
+        while (next < sizeof(snake_script) / sizeof(snake_script[0]) && snake_script[next].tick == tick)
+            steer_snake(0, snake_script[next++].direction);
+        move_snake();
+        crcs[frames++] = sign_frame();
+    }
+    return frames;
+}
+
+// frameDisplay's counter: the digits centred on a black screen, one frame per number
+#define DIGIT_SPACING 1
+
+static void draw_number(int number)
+{
+    char str[6];
+    const int num_digits = snprintf(str, sizeof(str), "%d", number);
+    const int total_width = num_digits * (DIGITS_FONT_WIDTH + DIGIT_SPACING);
+    const int x_offset = (FRAME_WIDTH - total_width) / 2;
+    const int y_offset = (FRAME_HEIGHT - DIGITS_FONT_HEIGHT) / 2;
+
+    render_fill_rect(framebuffer, x_offset, y_offset, total_width, DIGITS_FONT_HEIGHT, 0x0000);
+    for (int i = 0; i < num_digits; i++)
+    {
+        render_glyph(framebuffer, digits_font_glyph(str[i]), DIGITS_FONT_STRIDE, DIGITS_FONT_WIDTH,
+                     DIGITS_FONT_HEIGHT, x_offset + i * (DIGITS_FONT_WIDTH + DIGIT_SPACING), y_offset, 0xFFFF,
+                     0x0000);
+    }
+}
+
+static uint32_t run_digits(uint32_t* crcs)
+{
+    // Every number up to 1000, then across the rollovers to more digits
+    static const int ranges[][2] = {{0, 1000}, {9990, 10010}, {99990, 100000}};
+    uint32_t frames = 0;
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r)
+    {
+        for (int number = ranges[r][0]; number < ranges[r][1]; ++number)
+        {
+            if (number == 0)
+                memset(framebuffer, 0, sizeof(framebuffer));
+            draw_number(number);
+            crcs[frames++] = sign_frame();
+        }
+    }
+    return frames;
+}
+
+static const scenario_t scenarios[] = {
+    {"snake", run_snake},
+    {"digits", run_digits},
+};
+
+// Golden files hold one "CRC <frame> <crc>" line per frame, as scanout_poll_crc() prints them
+static uint32_t read_golden(const char* path, uint32_t* crcs)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return 0;
+
+    uint32_t frames = 0;
+    unsigned long frame, crc;
+    char line[64];
+    while (fgets(line, sizeof(line), file) && frames < MAX_FRAMES)
+    {
+        if (sscanf(line, "CRC %lu %lx", &frame, &crc) == 2 && frame == frames)
+            crcs[frames++] = (uint32_t)crc;
+    }
+    fclose(file);
+    return frames;
+}
+
+static bool write_golden(const char* path, const uint32_t* crcs, uint32_t frames)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return false;
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        fprintf(file, "CRC %u %08x\n", i, crcs[i]);
+    }
+    return fclose(file) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* dir = GOLDEN_DIR;
+    bool update = false;
+    bool print = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "upvd:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'u':
+            update = true;
+            break;
+        case 'p':
+            print = true;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'd':
+            dir = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-u] [-p] [-v] [-d golden_dir]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static uint32_t crcs[MAX_FRAMES];
+    static uint32_t golden[MAX_FRAMES];
+    int failed = 0;
+
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); ++s)
+    {
+        const scenario_t* scenario = &scenarios[s];
+        const uint32_t frames = scenario->run(crcs);
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.crc", dir, scenario->name);
+
+        if (print)
+        {
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                printf("%s: CRC %u %08x\n", scenario->name, i, crcs[i]);
+            }
+        }
+
+        if (update)
+        {
+            if (!write_golden(path, crcs, frames))
+            {
+                fprintf(stderr, "Cannot write %s\n", path);
+                return 1;
+            }
+            printf("%s: wrote %u frames to %s\n", scenario->name, frames, path);
+            continue;
+        }
+
+        const uint32_t golden_frames = read_golden(path, golden);
+        uint32_t differing = 0;
+        uint32_t first = 0;
+        for (uint32_t i = 0; i < frames && i < golden_frames; ++i)
+        {
+            if (crcs[i] != golden[i] && differing++ == 0)
+                first = i;
+        }
+
+        if (golden_frames != frames)
+        {
+            printf("%s: FAIL, %u frames drawn but %u in %s\n", scenario->name, frames, golden_frames, path);
+            ++failed;
+        }
+        else if (differing)
+        {
+            printf("%s: FAIL, %u of %u frames differ, first at frame %u (%08x, golden %08x)\n", scenario->name,
+                   differing, frames, first, crcs[first], golden[first]);
+            ++failed;
+        }
+        else
+        {
+            printf("%s: %u frames match\n", scenario->name, frames);
+        }
+    }
+    return failed ? 1 : 0;
+}
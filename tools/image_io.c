@@ -0,0 +1,161 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "image_io.h"
+
+static uint32_t crc32_table[256];
+
+static uint32_t png_crc(uint32_t crc, const uint8_t* data, size_t len)
+{
+    if (crc32_table[1] == 0)
+    {
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            crc32_table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i)
+        crc = crc32_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_be32(uint8_t* p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+static void write_chunk(FILE* file, const char* type, const uint8_t* data, uint32_t len)
+{
+    uint8_t header[8];
+    put_be32(header, len);
+    memcpy(&header[4], type, 4);
+    fwrite(header, 1, 8, file);
+    fwrite(data, 1, len, file);
+
+    uint8_t crc[4];
+    put_be32(crc, png_crc(png_crc(0, (const uint8_t*)type, 4), data, len));
+    fwrite(crc, 1, 4, file);
+}
+
+// Write an RGB565 image as an 8-bit RGB PNG. The image data is stored uncompressed
+// in deflate "stored" blocks, which keeps the writer free of a zlib dependency.
+bool image_write_png(const char* path, const uint16_t* pixels, uint32_t width, uint32_t height)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    fwrite(signature, 1, sizeof(signature), file);
+
+    uint8_t ihdr[13];
+    put_be32(&ihdr[0], width);
+    put_be32(&ihdr[4], height);
+    ihdr[8] = 8;  // Bit depth
+    ihdr[9] = 2;  // RGB
+    ihdr[10] = 0; // Deflate
+    ihdr[11] = 0; // Adaptive filtering
+    ihdr[12] = 0; // No interlace
+    write_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+
+    // Raw scanlines, each prefixed with filter type 0
+    const size_t row_bytes = 1 + (size_t)width * 3;
+    const size_t raw_size = row_bytes * height;
+    uint8_t* raw = malloc(raw_size);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        uint8_t* row = &raw[y * row_bytes];
+        row[0] = 0;
+        for (uint32_t x = 0; x < width; ++x)
+            rgb565_to_rgb888(pixels[y * width + x], &row[1 + x * 3]);
+    }
+
+    const size_t block_count = (raw_size + 65534) / 65535;
+    uint8_t* zlib = malloc(2 + raw_size + block_count * 5 + 4);
+    size_t pos = 0;
+    zlib[pos++] = 0x78;
+    zlib[pos++] = 0x01;
+    uint32_t adler_a = 1, adler_b = 0;
+    for (size_t offset = 0; offset < raw_size; offset += 65535)
+    {
+        const size_t len = raw_size - offset < 65535 ? raw_size - offset : 65535;
+        zlib[pos++] = offset + len == raw_size; // BFINAL, stored block
+        zlib[pos++] = len & 0xff;
+        zlib[pos++] = len >> 8;
+        zlib[pos++] = ~len & 0xff;
+        zlib[pos++] = (~len >> 8) & 0xff;
+        memcpy(&zlib[pos], &raw[offset], len);
+        pos += len;
+        for (size_t i = 0; i < len; ++i)
+        {
+            adler_a = (adler_a + raw[offset + i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+    }
+    put_be32(&zlib[pos], (adler_b << 16) | adler_a);
+    pos += 4;
+
+    write_chunk(file, "IDAT", zlib, pos);
+    write_chunk(file, "IEND", NULL, 0);
+
+    free(zlib);
+    free(raw);
+    return fclose(file) == 0;
+}
+
+void image_write_y4m_header(FILE* file, uint32_t width, uint32_t height, uint32_t fps)
+{
+    fprintf(file, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", width, height, fps);
+}
+
+// Append one frame as full-resolution BT.601 YCbCr
+void image_write_y4m_frame(FILE* file, const uint16_t* pixels, uint32_t width, uint32_t height)
+{
+    const size_t count = (size_t)width * height;
+    uint8_t* planes = malloc(count * 3);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t rgb[3];
+        rgb565_to_rgb888(pixels[i], rgb);
+        const int r = rgb[0], g = rgb[1], b = rgb[2];
+        planes[i] = (66 * r + 129 * g + 25 * b + 128) / 256 + 16;
+        planes[count + i] = (-38 * r - 74 * g + 112 * b + 128) / 256 + 128;
+        planes[2 * count + i] = (112 * r - 94 * g - 18 * b + 128) / 256 + 128;
+    }
+    fputs("FRAME\n", file);
+    fwrite(planes, 1, count * 3, file);
+    free(planes);
+}
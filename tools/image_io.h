@@ -0,0 +1,45 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Function declarations
+bool image_write_png(const char* path, const uint16_t* pixels, uint32_t width, uint32_t height);
+void image_write_y4m_header(FILE* file, uint32_t width, uint32_t height, uint32_t fps);
+void image_write_y4m_frame(FILE* file, const uint16_t* pixels, uint32_t width, uint32_t height);
+
+static inline void rgb565_to_rgb888(uint16_t pixel, uint8_t* rgb)
+{
+    rgb[0] = ((pixel >> 11) & 0x1f) * 255 / 31;
+    rgb[1] = ((pixel >> 5) & 0x3f) * 255 / 63;
+    rgb[2] = (pixel & 0x1f) * 255 / 31;
+}
+
+#endif // IMAGE_IO_H
@@ -0,0 +1,193 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Compare the compile-time specialised renderer (common/renderer.hpp) with plain per-pixel
+// loops like the ones it replaced, for every pixel format: first check that both draw the
+// same pixels, then time block fills, glyph blits and 8x scaled glyphs on a 320x240 frame.
+//
+// Usage: render_bench [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "renderer.hpp"
+
+using kiwi::PixelFormat;
+
+constexpr int width = 320;
+constexpr int height = 240;
+constexpr int block = 8;
+
+// Keeps the optimiser from dropping the drawing
+static volatile uint32_t sink;
+
+template <PixelFormat Format> using Screen = kiwi::Framebuffer<Format, width, height>;
+
+// Per-pixel reference, the way draw_block and draw_char used to work
+template <PixelFormat Format> struct Reference
+{
+    using Storage = typename Screen<Format>::Storage;
+
+    static void fill_block(Storage* fb, int x, int y, uint32_t colour)
+    {
+        for (int i = 0; i < block; ++i)
+            for (int j = 0; j < block; ++j)
+                Screen<Format>::set_pixel(fb, x + j, y + i, colour);
+    }
+
+    static void glyph(Storage* fb, const uint8_t* glyph, int x, int y, uint32_t fg, uint32_t bg)
+    {
+        for (int i = 0; i < 16; ++i)
+            for (int j = 0; j < 8; ++j)
+                Screen<Format>::set_pixel(fb, x + j, y + i, (glyph[i] & (0x80 >> j)) ? fg : bg);
+    }
+
+    static void glyph_scaled(Storage* fb, const uint8_t* glyph, int x, int y, int scale, uint32_t fg, uint32_t bg)
+    {
+        for (int i = 0; i < 16 * scale; ++i)
+            for (int j = 0; j < 8 * scale; ++j)
+                Screen<Format>::set_pixel(fb, x + j, y + i, (glyph[i / scale] & (0x80 >> (j / scale))) ? fg : bg);
+    }
+};
+
+template <typename F> static double time_ms(int iterations, F&& f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        f(i);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <PixelFormat Format> static bool run(const char* name, int iterations, uint32_t fg, uint32_t bg)
+{
+    using S = Screen<Format>;
+    using Storage = typename S::Storage;
+    constexpr size_t size = S::stride * height;
+    alignas(4) static Storage a[size];
+    alignas(4) static Storage b[size];
+    uint8_t glyph[16];
+    for (int i = 0; i < 16; ++i)
+        glyph[i] = (uint8_t)(i * 37 + 11);
+
+    // Same pixels from both, for every cell and for glyphs at word-aligned and unaligned positions
+    memset(a, 0, sizeof(a));
+    memset(b, 0, sizeof(b));
+    for (int cy = 0; cy < height / block; ++cy)
+        for (int cx = 0; cx < width / block; ++cx)
+        {
+            const uint32_t colour = ((cx + cy) & 1) ? fg : bg;
+            S::template fill_cell<block>(a, cx, cy, colour);
+            Reference<Format>::fill_block(b, cx * block, cy * block, colour);
+        }
+    for (int x = 0; x < 40; ++x)
+    {
+        S::template blit_glyph<8, 16>(a, glyph, 1, x * 7, x * 5, fg, bg);
+        Reference<Format>::glyph(b, glyph, x * 7, x * 5, fg, bg);
+    }
+    for (int scale = 2; scale <= 8; scale *= 2)
+        for (int x = 0; x < 6; ++x)
+        {
+            const int gx = x * 37 % (width - 8 * scale);
+            const int gy = x * 23 % (height - 16 * scale);
+            S::blit_glyph_scaled(a, glyph, 1, 8, 16, gx, gy, scale, fg, bg);
+            Reference<Format>::glyph_scaled(b, glyph, gx, gy, scale, fg, bg);
+        }
+    const bool same = memcmp(a, b, sizeof(a)) == 0;
+
+    constexpr int cells = (width / block) * (height / block);
+    const double fill_ref = time_ms(iterations, [&](int i) {
+        for (int c = 0; c < cells; ++c)
+            Reference<Format>::fill_block(b, (c % (width / block)) * block, (c / (width / block)) * block, i);
+        sink = b[i % size];
+    });
+    const double fill_tpl = time_ms(iterations, [&](int i) {
+        for (int c = 0; c < cells; ++c)
+            S::template fill_cell<block>(a, c % (width / block), c / (width / block), i);
+        sink = a[i % size];
+    });
+
+    constexpr int glyphs = (width / 8) * (height / 16);
+    const double glyph_ref = time_ms(iterations, [&](int i) {
+        for (int g = 0; g < glyphs; ++g)
+            Reference<Format>::glyph(b, glyph, (g % (width / 8)) * 8, (g / (width / 8)) * 16, fg, bg);
+        sink = b[i % size];
+    });
+    const double glyph_tpl = time_ms(iterations, [&](int i) {
+        for (int g = 0; g < glyphs; ++g)
+            S::template blit_glyph<8, 16>(a, glyph, 1, (g % (width / 8)) * 8, (g / (width / 8)) * 16, fg, bg);
+        sink = a[i % size];
+    });
+
+    // frameDisplay's large digits: as many 8x glyphs (64x128) as fit
+    constexpr int large = (width / 64) * (height / 128);
+    const double large_ref = time_ms(iterations, [&](int i) {
+        for (int g = 0; g < large; ++g)
+            Reference<Format>::glyph_scaled(b, glyph, g * 64, 0, 8, fg, bg);
+        sink = b[i % size];
+    });
+    const double large_tpl = time_ms(iterations, [&](int i) {
+        for (int g = 0; g < large; ++g)
+            S::blit_glyph_scaled(a, glyph, 1, 8, 16, g * 64, 0, 8, fg, bg);
+        sink = a[i % size];
+    });
+
+    printf("%-8s %s  block fill %7.3f -> %7.3f us/frame (%4.1fx)  glyphs %7.3f -> %7.3f us/frame (%4.1fx)  "
+           "%d 8x glyphs %7.3f -> %7.3f us/frame (%4.1fx)\n",
+           name, same ? "match" : "DIFFER", 1000 * fill_ref / iterations, 1000 * fill_tpl / iterations,
+           fill_ref / fill_tpl, 1000 * glyph_ref / iterations, 1000 * glyph_tpl / iterations, glyph_ref / glyph_tpl,
+           large, 1000 * large_ref / iterations, 1000 * large_tpl / iterations, large_ref / large_tpl);
+    return same;
+}
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+    bool ok = true;
+    ok &= run<PixelFormat::rgb565>("rgb565", iterations, 0x1ca3, 0x9f53);
+    ok &= run<PixelFormat::indexed8>("8bpp", iterations, 0x1c, 0x9f);
+    ok &= run<PixelFormat::mono1>("1bpp", iterations, 1, 0);
+
+    // 8bpp and 1bpp rows expand to RGB565 for scanout
+    alignas(4) static uint8_t indexed[width];
+    alignas(4) static uint8_t mono[width / 8];
+    alignas(4) static uint16_t line[width];
+    static const uint16_t mono_palette[2] = {0x0000, 0xffff};
+    for (int x = 0; x < width; ++x)
+        indexed[x] = (uint8_t)x;
+    for (int x = 0; x < width / 8; ++x)
+        mono[x] = (uint8_t)(x * 29);
+    Screen<PixelFormat::indexed8>::expand_row(indexed, line, kiwi::rgb332_palette.data());
+    for (int x = 0; x < width; ++x)
+        ok &= line[x] == kiwi::rgb332_palette[x & 0xff];
+    Screen<PixelFormat::mono1>::expand_row(mono, line, mono_palette);
+    for (int x = 0; x < width; ++x)
+        ok &= line[x] == ((mono[x >> 3] & (0x80 >> (x & 7))) ? 0xffff : 0x0000);
+
+    printf("Check: %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Checks the snake rewind buffer (../snake/rewind.h). Games are played with the firmware's rules,
+// steered by the greedy policy with the odd random turn so runs end and the game resets, and
+// the state at the start of every tick is pushed into the buffer and kept in full on the side.
+// Every tick still in the buffer is then rebuilt and compared with the copy, and a restore to a
+// random tick is checked to carry on recording from there. The tool prints how many ticks the
+// buffer holds, the bytes per tick and the time to rebuild a tick, and exits with 1 on any
+// mismatch.
+//
+// Usage: rewind_sim [-t ticks] [-c checks] [-s seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rewind.h"
+#include "snake_batch.h"
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t next_random(uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// Same game, whatever the body ring buffers' start index
+static bool same_state(const game_state_t* a, const game_state_t* b)
+{
+    if (memcmp(a->grid, b->grid, sizeof(a->grid)) != 0 || a->food_x != b->food_x || a->food_y != b->food_y ||
+        a->random_state != b->random_state)
+        return false;
+
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (a->joined[player] != b->joined[player] || a->alive[player] != b->alive[player] ||
+            a->direction[player] != b->direction[player] || a->snake_length[player] != b->snake_length[player])
+            return false;
+        for (uint32_t i = 0; i < a->snake_length[player]; ++i)
+        {
+            const uint32_t ia = game_segment(a, player, i);
+            const uint32_t ib = game_segment(b, player, i);
+            if (a->body_x[player][ia] != b->body_x[player][ib] || a->body_y[player][ia] != b->body_y[player][ib])
+                return false;
+        }
+    }
+    return true;
+}
+
+static void steer_players(game_state_t* game, uint32_t* random)
+{
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        direction_t direction = snake_batch_greedy_policy(game, player, NULL);
+        if (next_random(random) % 32 == 0)
+            direction = (direction_t)(next_random(random) % 4);
+        game_state_steer(game, player, direction);
+    }
+}
+
+static void move_players(game_state_t* game, uint32_t* resets)
+{
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        move_t move;
+        game_state_move(game, player, &move);
+        if (!game_is_lost(move.result))
+            continue;
+        ++*resets;
+        if (MAX_PLAYERS == 1)
+            game_state_reset(game);
+        else
+            game_state_remove(game, player);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t ticks = 20000;
+    uint32_t checks = 20;
+    uint32_t seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:c:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            ticks = atoi(optarg);
+            break;
+        case 'c':
+            checks = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-t ticks] [-c checks] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (ticks == 0 || checks == 0)
+        ticks = checks = 1;
+
+    game_state_t* history = malloc(sizeof(game_state_t) * ticks);
+    static rewind_t buffer;
+    static game_state_t game;
+    static game_state_t rebuilt;
+    if (!history)
+    {
+        fprintf(stderr, "Cannot keep %u states\n", ticks);
+        return 1;
+    }
+
+    printf("%dx%d cells, %d players, game state %zu bytes, rewind buffer %zu bytes\n", GRID_WIDTH, GRID_HEIGHT,
+           MAX_PLAYERS, sizeof(game_state_t), sizeof(rewind_t));
+
+    game_state_init(&game, seed);
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        game.joined[player] = true;
+    }
+    game_state_reset(&game);
+    rewind_init(&buffer);
+
+    uint32_t random = seed ^ 0x9e3779b9u;
+    uint32_t resets = 0;
+    uint32_t mismatches = 0;
+    uint64_t rebuilds = 0;
+    double rebuild_s = 0;
+    double rebuild_max_s = 0;
+    uint32_t kept_min = UINT32_MAX;
+
+    for (uint32_t tick = 0; tick < ticks; ++tick)
+    {
+        steer_players(&game, &random);
+        rewind_push(&buffer, &game);
+        history[tick] = game;
+        move_players(&game, &resets);
+
+        // Rebuild every tick in the buffer a few times over the run, once it has filled up
+        if ((tick + 1) % (ticks / checks ? ticks / checks : 1) != 0)
+            continue;
+        const uint32_t oldest = rewind_oldest(&buffer);
+        if (tick > REWIND_BUFFER_BYTES && rewind_ticks(&buffer) < kept_min)
+            kept_min = rewind_ticks(&buffer);
+        for (uint32_t t = oldest; t <= tick; ++t)
+        {
+            const double start = now_s();
+            const bool found = rewind_get(&buffer, t, &rebuilt);
+            const double elapsed = now_s() - start;
+            rebuild_s += elapsed;
+            rebuild_max_s = elapsed > rebuild_max_s ? elapsed : rebuild_max_s;
+            ++rebuilds;
+            if (!found || !same_state(&rebuilt, &history[t]))
+            {
+                if (mismatches++ < 10)
+                    printf("Tick %u %s\n", t, found ? "differs" : "missing");
+            }
+        }
+    }
+
+    const uint32_t kept = rewind_ticks(&buffer);
+    printf("%u ticks, %u runs lost, %u keyframes and %u deltas written, %.2f bytes per tick\n", ticks, resets,
+           buffer.keyframes_written, buffer.deltas_written, (double)buffer.bytes_written / ticks);
+    printf("Buffer holds %u ticks (%.1f s at %d ms per tick), at least %u once full\n", kept,
+           kept * SNAKE_MOVE_INTERVAL_MS / 1000.0, SNAKE_MOVE_INTERVAL_MS, kept_min == UINT32_MAX ? kept : kept_min);
+    printf("%llu ticks rebuilt, %.2f us mean, %.2f us max\n", (unsigned long long)rebuilds,
+           rebuilds ? rebuild_s / rebuilds * 1e6 : 0, rebuild_max_s * 1e6);
+
+    // Go back to a random tick, then record the ticks after it again
+    const uint32_t oldest = rewind_oldest(&buffer);
+    const uint32_t target = oldest + next_random(&random) % kept;
+    if (!rewind_restore(&buffer, target, &game) || !same_state(&game, &history[target]))
+    {
+        printf("Restore to tick %u failed\n", target);
+        ++mismatches;
+    }
+    for (uint32_t t = target; t < ticks; ++t)
+    {
+        rewind_push(&buffer, &history[t]);
+    }
+    for (uint32_t t = rewind_oldest(&buffer); t < ticks; ++t)
+    {
+        if (!rewind_get(&buffer, t, &rebuilt) || !same_state(&rebuilt, &history[t]))
+        {
+            if (mismatches++ < 10)
+                printf("Tick %u differs after restoring tick %u\n", t, target);
+        }
+    }
+
+    printf("%s\n", mismatches ? "REWIND MISMATCH" : "Every tick rebuilt exactly");
+    free(history);
+    return mismatches ? 1 : 0;
+}
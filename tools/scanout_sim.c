@@ -0,0 +1,183 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Drive the scanline queue statistics (common/scanout_stats.h) with a simulated scanout.
+// A producer queues lines the way scanout_push_frame() does, and a consumer takes one line
+// per scanline slot during the active part of each frame, like core 1. Lines the consumer
+// finds missing are counted as underruns, which is what libdvi's late_scanline_ctr counts on
+// hardware. The statistics are printed as the firmware prints them, followed by the
+// simulated truth and a check that the two agree.
+//
+// Usage: scanout_sim [-f frames] [-c line_cost_ns] [-w frame_work_us] [-s stall_us]
+//                    [-n stall_every_frames] [-d queue_depth]
+//   Defaults model the 320x240 framebuffer on 640x480p60 with an 8-entry queue, copying
+//   each line in 2 us, 200 us of main loop work between frames and no stalls. A stall of a
+//   few milliseconds every 60 frames resembles a full redraw or a burst of UART output.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scanout_stats.h"
+
+// 640x480p60: 800 pixels per line at 25.2 MHz, 525 lines per frame
+#define LINE_NS         31746
+#define LINES_PER_FRAME 525
+#define ACTIVE_LINES    480
+#define VERTICAL_REPEAT 2 // Each queued line is shown twice
+#define QUEUED_PER_FRAME (ACTIVE_LINES / VERTICAL_REPEAT)
+#define FRAME_NS        ((uint64_t)LINE_NS * LINES_PER_FRAME)
+
+typedef struct
+{
+    uint32_t depth;
+    uint32_t valid; // Lines waiting for the consumer
+    uint32_t free;  // Lines consumed and not yet reclaimed
+    uint64_t slot;  // Next consumer slot
+    uint64_t start_ns;
+    bool started;
+    uint32_t underruns;
+    uint32_t underrun_episodes; // Runs of consecutive missing lines
+    bool in_underrun;
+} sim_t;
+
+static uint64_t slot_time(const sim_t* sim, uint64_t slot)
+{
+    return sim->start_ns + (slot / QUEUED_PER_FRAME) * FRAME_NS + (slot % QUEUED_PER_FRAME) * VERTICAL_REPEAT * LINE_NS;
+}
+
+// Run the consumer up to time t
+static void consume_until(sim_t* sim, uint64_t t)
+{
+    while (sim->started && slot_time(sim, sim->slot) <= t)
+    {
+        if (sim->valid > 0)
+        {
+            --sim->valid;
+            ++sim->free;
+            sim->in_underrun = false;
+        }
+        else
+        {
+            ++sim->underruns;
+            if (!sim->in_underrun)
+                ++sim->underrun_episodes;
+            sim->in_underrun = true;
+        }
+        ++sim->slot;
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: scanout_sim [-f frames] [-c line_cost_ns] [-w frame_work_us] [-s stall_us] "
+                    "[-n stall_every_frames] [-d queue_depth]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frames = 600;
+    uint64_t line_cost_ns = 2000;
+    uint64_t work_ns = 200000;
+    uint64_t stall_ns = 0;
+    uint32_t stall_every = 60;
+    sim_t sim = {.depth = 8};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (i + 1 >= argc)
+            usage();
+        const long value = atol(argv[i + 1]);
+        if (strcmp(argv[i], "-f") == 0)
+            frames = value;
+        else if (strcmp(argv[i], "-c") == 0)
+            line_cost_ns = value;
+        else if (strcmp(argv[i], "-w") == 0)
+            work_ns = value * 1000;
+        else if (strcmp(argv[i], "-s") == 0)
+            stall_ns = value * 1000;
+        else if (strcmp(argv[i], "-n") == 0 && value > 0)
+            stall_every = value;
+        else if (strcmp(argv[i], "-d") == 0 && value > 0)
+            sim.depth = value;
+        else
+            usage();
+        ++i;
+    }
+
+    scanout_stats_t stats;
+    scanout_stats_reset(&stats);
+    uint64_t t = 0;
+
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        for (uint32_t line = 0; line < QUEUED_PER_FRAME; ++line)
+        {
+            t += line_cost_ns;
+            consume_until(&sim, t);
+
+            // queue_add_blocking: wait for the consumer to make room
+            while (sim.valid == sim.depth)
+            {
+                t = slot_time(&sim, sim.slot);
+                consume_until(&sim, t);
+            }
+
+            scanout_stats_line(&stats, sim.valid);
+            ++sim.valid;
+            if (!sim.started)
+            {
+                // Core 1 starts the DVI output once the first line is queued
+                sim.started = true;
+                sim.start_ns = t + LINE_NS;
+            }
+
+            scanout_stats_reclaim(&stats, sim.free);
+            sim.free = 0;
+        }
+        scanout_stats_frame(&stats);
+
+        // Main loop work between frames, and the occasional stall
+        t += work_ns;
+        if (stall_ns && frame % stall_every == stall_every - 1)
+            t += stall_ns;
+    }
+    stats.late_scanlines = sim.underruns;
+
+    scanout_stats_print(&stats, LINE_NS * VERTICAL_REPEAT);
+    printf("Simulated: %u underruns in %u episodes\n", sim.underruns, sim.underrun_episodes);
+
+    // Every run of missing lines ends with a line queued into an empty queue, so the
+    // producer-side count can never miss an episode
+    uint32_t histogram_lines = 0;
+    for (int i = 0; i <= SCANOUT_STATS_MAX_LEVEL; ++i)
+        histogram_lines += stats.valid_level[i];
+    const bool ok = histogram_lines == stats.lines && stats.lines == frames * QUEUED_PER_FRAME &&
+                    stats.empty_queue >= sim.underrun_episodes;
+    printf("Check: %s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_batch.h"
+
+typedef struct
+{
+    snake_batch_t* batch;
+    uint32_t first;
+    uint32_t last;
+} worker_t;
+
+// One tick of one game
+static void step_game(snake_batch_t* batch, uint32_t index)
+{
+    game_state_t* game = &batch->states[index];
+
+    for (uint8_t player = 0; player < MAX_PLAYERS; ++player)
+    {
+        if (game->alive[player])
+            game_state_steer(game, player, batch->policy(game, player, batch->policy_user));
+
+        move_t move;
+        game_state_move(game, player, &move);
+        if (move.result == MOVE_ATE)
+        {
+            ++batch->food[index];
+            if (game->snake_length[player] > batch->best_length[index])
+                batch->best_length[index] = game->snake_length[player];
+        }
+        else if (game_is_lost(move.result))
+        {
+            // As on the Pico: one player restarts the game, with more the player drops out
+            ++batch->finished[index];
+#if MAX_PLAYERS == 1
+            game_state_reset(game);
+#else
+            game_state_remove(game, player);
+#endif
+        }
+    }
+}
+
+static void* worker_main(void* arg)
+{
+    worker_t* worker = arg;
+    snake_batch_t* batch = worker->batch;
+    uint32_t seen = 0;
+
+    pthread_mutex_lock(&batch->lock);
+    while (true)
+    {
+        while (batch->generation == seen && !batch->quit)
+            pthread_cond_wait(&batch->start, &batch->lock);
+        if (batch->quit)
+            break;
+        seen = batch->generation;
+        const uint32_t ticks = batch->run_ticks;
+        pthread_mutex_unlock(&batch->lock);
+
+        for (uint32_t index = worker->first; index < worker->last; ++index)
+        {
+            for (uint32_t tick = 0; tick < ticks; ++tick)
+            {
+                step_game(batch, index);
+            }
+            batch->ticks[index] += ticks;
+        }
+
+        pthread_mutex_lock(&batch->lock);
+        if (--batch->busy == 0)
+            pthread_cond_signal(&batch->done);
+    }
+    pthread_mutex_unlock(&batch->lock);
+    free(worker);
+    return NULL;
+}
+
+// Set up games, each started from its own seed, and start the worker threads. Returns false if
+// memory or threads run out.
+bool snake_batch_init(snake_batch_t* batch, uint32_t games, uint32_t threads, uint32_t seed, snake_policy_t policy,
+                      void* policy_user)
+{
+    memset(batch, 0, sizeof(*batch));
+    if (threads == 0)
+        threads = 1;
+    if (threads > games)
+        threads = games;
+
+    batch->games = games;
+    batch->policy = policy;
+    batch->policy_user = policy_user;
+    batch->states = malloc(games * sizeof(batch->states[0]));
+    batch->ticks = calloc(games, sizeof(batch->ticks[0]));
+    batch->food = calloc(games, sizeof(batch->food[0]));
+    batch->finished = calloc(games, sizeof(batch->finished[0]));
+    batch->best_length = calloc(games, sizeof(batch->best_length[0]));
+    batch->workers = calloc(threads, sizeof(batch->workers[0]));
+    if (!batch->states || !batch->ticks || !batch->food || !batch->finished || !batch->best_length ||
+        !batch->workers)
+    {
+        snake_batch_free(batch);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < games; ++i)
+    {
+        game_state_init(&batch->states[i], seed + i * 0x9e3779b9u);
+        game_state_reset(&batch->states[i]);
+        batch->best_length[i] = INITIAL_SNAKE_LENGTH;
+    }
+
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->start, NULL);
+    pthread_cond_init(&batch->done, NULL);
+    for (uint32_t i = 0; i < threads; ++i)
+    {
+        worker_t* worker = malloc(sizeof(*worker));
+        if (!worker)
+            break;
+        worker->batch = batch;
+        worker->first = (uint64_t)games * i / threads;
+        worker->last = (uint64_t)games * (i + 1) / threads;
+        if (pthread_create(&batch->workers[i], NULL, worker_main, worker) != 0)
+        {
+            free(worker);
+            break;
+        }
+        ++batch->threads;
+    }
+    if (batch->threads != threads)
+    {
+        snake_batch_free(batch);
+        return false;
+    }
+    return true;
+}
+
+// Advance every game by ticks moves and wait for all of them
+void snake_batch_run(snake_batch_t* batch, uint32_t ticks)
+{
+    pthread_mutex_lock(&batch->lock);
+    batch->run_ticks = ticks;
+    batch->busy = batch->threads;
+    ++batch->generation;
+    pthread_cond_broadcast(&batch->start);
+    while (batch->busy > 0)
+        pthread_cond_wait(&batch->done, &batch->lock);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+void snake_batch_free(snake_batch_t* batch)
+{
+    if (batch->threads > 0)
+    {
+        pthread_mutex_lock(&batch->lock);
+        batch->quit = true;
+        pthread_cond_broadcast(&batch->start);
+        pthread_mutex_unlock(&batch->lock);
+        for (uint32_t i = 0; i < batch->threads; ++i)
+        {
+            pthread_join(batch->workers[i], NULL);
+        }
+        pthread_mutex_destroy(&batch->lock);
+        pthread_cond_destroy(&batch->start);
+        pthread_cond_destroy(&batch->done);
+    }
+    free(batch->states);
+    free(batch->ticks);
+    free(batch->food);
+    free(batch->finished);
+    free(batch->best_length);
+    free(batch->workers);
+    memset(batch, 0, sizeof(*batch));
+}
+
+// Head towards the food, never straight into a wall or a snake if another way is free
+direction_t snake_batch_greedy_policy(const game_state_t* game, uint8_t player, void* user)
+{
+    static const int dx[4] = {0, 1, 0, -1}; // Indexed by direction_t
+    static const int dy[4] = {-1, 0, 1, 0};
+
+    const int head = game->head_index[player];
+    const int x = game->body_x[player][head];
+    const int y = game->body_y[player][head];
+    const direction_t current = game->direction[player];
+
+    direction_t best = current;
+    int best_distance = -1;
+    for (int d = 0; d < 4; ++d)
+    {
+        if (d == (current + 2) % 4)
+            continue; // Reversing is not allowed
+        const int nx = x + dx[d];
+        const int ny = y + dy[d];
+        const uint8_t cell = game->grid[ny][nx];
+        if (cell != CELL_EMPTY && cell != CELL_FOOD)
+            continue;
+
+        const int distance = abs(game->food_x - nx) + abs(game->food_y - ny);
+        if (best_distance < 0 || distance < best_distance)
+        {
+            best = (direction_t)d;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
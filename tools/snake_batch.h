@@ -0,0 +1,77 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef SNAKE_BATCH_H
+#define SNAKE_BATCH_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game_state.h"
+
+// Headless batch engine: steps many snake games with the firmware's rules (snake/game_state.h)
+// on a pool of worker threads, with a policy choosing every move. There is no drawing. Each
+// worker owns a contiguous slice of the games and runs each game for a whole batch of ticks
+// before moving to the next, so a game's state stays in the core's cache. Per-game results are
+// kept in one array per field.
+
+// Chooses a player's direction before every move
+typedef direction_t (*snake_policy_t)(const game_state_t* game, uint8_t player, void* user);
+
+typedef struct
+{
+    uint32_t games;
+    game_state_t* states;
+
+    // Per-game results
+    uint64_t* ticks;       // Moves played
+    uint32_t* food;        // Food eaten
+    uint32_t* finished;    // Games lost and restarted
+    uint16_t* best_length; // Longest snake
+
+    snake_policy_t policy;
+    void* policy_user;
+
+    // Worker pool. Each run bumps generation and waits until every worker has finished it.
+    uint32_t threads;
+    pthread_t* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint32_t generation;
+    uint32_t busy;
+    uint32_t run_ticks;
+    bool quit;
+} snake_batch_t;
+
+// Function declarations
+bool snake_batch_init(snake_batch_t* batch, uint32_t games, uint32_t threads, uint32_t seed, snake_policy_t policy,
+                      void* policy_user);
+void snake_batch_run(snake_batch_t* batch, uint32_t ticks);
+void snake_batch_free(snake_batch_t* batch);
+direction_t snake_batch_greedy_policy(const game_state_t* game, uint8_t player, void* user);
+
+#endif // SNAKE_BATCH_H
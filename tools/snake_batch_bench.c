@@ -0,0 +1,148 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Scaling benchmark for the headless snake batch engine (snake_batch.h). The same set of games,
+// steered by the greedy policy, is run with 1, 2, 4, ... worker threads up to the number of
+// cores, and the games finished and ticks played per second are printed with the speedup over
+// one thread. Every run must give exactly the same results, since each game only depends on
+// its own seed.
+//
+// Usage: snake_batch_bench [-g games] [-t ticks] [-j max_threads] [-s seed]
+//   Defaults: 4096 games, 2000 ticks, all online cores.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_batch.h"
+
+typedef struct
+{
+    uint64_t ticks;
+    uint64_t food;
+    uint64_t finished;
+    uint32_t best_length;
+    uint64_t checksum; // Of every game's results, to compare runs
+} totals_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sum_results(const snake_batch_t* batch, totals_t* totals)
+{
+    *totals = (totals_t){0};
+    for (uint32_t i = 0; i < batch->games; ++i)
+    {
+        totals->ticks += batch->ticks[i];
+        totals->food += batch->food[i];
+        totals->finished += batch->finished[i];
+        if (batch->best_length[i] > totals->best_length)
+            totals->best_length = batch->best_length[i];
+        totals->checksum = totals->checksum * 1099511628211u ^ (batch->food[i] * 65536u + batch->finished[i]);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t games = 4096;
+    uint32_t ticks = 2000;
+    long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "g:t:j:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'g':
+            games = atoi(optarg);
+            break;
+        case 't':
+            ticks = atoi(optarg);
+            break;
+        case 'j':
+            max_threads = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-g games] [-t ticks] [-j max_threads] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (games == 0 || max_threads < 1)
+        max_threads = 1;
+
+    printf("%u games of %dx%d cells, %d players, %u ticks each, game state %zu bytes\n", games, GRID_WIDTH,
+           GRID_HEIGHT, MAX_PLAYERS, ticks, sizeof(game_state_t));
+
+    totals_t reference = {0};
+    double single_rate = 0;
+    int mismatches = 0;
+
+    for (long threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads)
+    {
+        snake_batch_t batch;
+        if (!snake_batch_init(&batch, games, threads, seed, snake_batch_greedy_policy, NULL))
+        {
+            fprintf(stderr, "Cannot set up %u games on %ld threads\n", games, threads);
+            return 1;
+        }
+
+        const double start = now_s();
+        snake_batch_run(&batch, ticks);
+        const double elapsed = now_s() - start;
+
+        totals_t totals;
+        sum_results(&batch, &totals);
+        snake_batch_free(&batch);
+
+        const double tick_rate = totals.ticks / elapsed;
+        if (threads == 1)
+        {
+            reference = totals;
+            single_rate = tick_rate;
+        }
+        const bool match = totals.checksum == reference.checksum && totals.ticks == reference.ticks;
+        mismatches += !match;
+
+        printf("%3ld threads: %.3f s, %10.0f games/s, %12.0f ticks/s, speedup %5.2f, efficiency %3.0f%%%s\n",
+               threads, elapsed, totals.finished / elapsed, tick_rate, tick_rate / single_rate,
+               100.0 * tick_rate / single_rate / threads, match ? "" : ", RESULTS DIFFER");
+
+        if (threads == max_threads)
+            break;
+    }
+
+    printf("%.1f food and %.2f games finished per game, longest snake %u\n", (double)reference.food / games,
+           (double)reference.finished / games, reference.best_length);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Checks the TMDS line cache (../common/tmds_cache.h) against a reference encoder. Scenes are
+// fed through the cache line by line as scanout_tmds_cache_main() does, with a simulated DMA
+// that keeps up to DVI_N_TMDS_BUFFERS lines in flight and finishes them at random times. Every
+// buffer is compared with a fresh encoding of its line when it is queued and again when the DMA
+// is done with it, so a stale hit or an entry reused while it was being sent is caught.
+//
+// Usage: tmds_cache_sim [-f frames] [-s seed]
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "digits_font.h"
+#include "display_mode.h"
+#include "renderer.h"
+#include "tmds_cache.h"
+
+#define DVI_N_TMDS_BUFFERS 3
+#define LINE_WORDS         (3 * SCANLINE_WIDTH)
+#define BLOCK_SIZE         8
+
+static uint16_t framebuffer[FRAME_HEIGHT * FRAME_WIDTH];
+static uint16_t cache_pixels[TMDS_CACHE_ENTRIES * SCANLINE_WIDTH];
+static uint32_t cache_symbols[TMDS_CACHE_ENTRIES * LINE_WORDS];
+static uint32_t random_state;
+
+static uint32_t next_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// DVI 1.0 8b/10b data encoding. The running disparity starts at zero on every line, so the
+// symbols depend on nothing but the line, which is what makes them cacheable.
+static uint32_t encode_symbol(uint32_t d, int* disparity)
+{
+    const int ones = __builtin_popcount(d);
+    const bool use_xnor = ones > 4 || (ones == 4 && !(d & 1));
+    uint32_t q_m = d & 1;
+    for (int i = 1; i < 8; ++i)
+    {
+        const uint32_t bit = ((q_m >> (i - 1)) ^ (d >> i) ^ use_xnor) & 1;
+        q_m |= bit << i;
+    }
+    if (!use_xnor)
+        q_m |= 1u << 8;
+
+    const int n1 = __builtin_popcount(q_m & 0xff);
+    const int n0 = 8 - n1;
+    const bool bit8 = q_m & 0x100;
+    uint32_t q_out;
+    if (*disparity == 0 || n1 == n0)
+    {
+        q_out = (bit8 ? 0 : 0x200) | (q_m & 0x100) | (bit8 ? q_m & 0xff : ~q_m & 0xff);
+        *disparity += bit8 ? n1 - n0 : n0 - n1;
+    }
+    else if ((*disparity > 0 && n1 > n0) || (*disparity < 0 && n0 > n1))
+    {
+        q_out = 0x200 | (q_m & 0x100) | (~q_m & 0xff);
+        *disparity += 2 * bit8 + n0 - n1;
+    }
+    else
+    {
+        q_out = (q_m & 0x100) | (q_m & 0xff);
+        *disparity += -2 * !bit8 + n1 - n0;
+    }
+    return q_out;
+}
+
+// Three channels of one word per pixel, each word the pixel's symbol twice as libdvi doubles
+// pixels horizontally
+static void reference_encode(const uint16_t* line, uint32_t* tmds)
+{
+    static const int shift[3] = {0, 5, 11}; // Blue, green, red
+    static const int bits[3] = {5, 6, 5};
+    for (int c = 0; c < 3; ++c)
+    {
+        int disparity = 0;
+        for (int x = 0; x < SCANLINE_WIDTH; ++x)
+        {
+            const uint32_t value = (line[x] >> shift[c]) & ((1u << bits[c]) - 1);
+            const uint32_t d = value << (8 - bits[c]);
+            const uint32_t first = encode_symbol(d, &disparity);
+            const uint32_t second = encode_symbol(d, &disparity);
+            tmds[c * SCANLINE_WIDTH + x] = first | second << 10;
+        }
+    }
+}
+
+// Scenes, drawn into the framebuffer one frame at a time
+
+// A snake crossing the playfield, one cell per four frames, with food that moves when eaten
+static void draw_snake(uint32_t frame)
+{
+    const int grid_w = FRAME_WIDTH / BLOCK_SIZE;
+    const int grid_h = FRAME_HEIGHT / BLOCK_SIZE;
+    render_fill_rect(framebuffer, 0, 0, FRAME_WIDTH, FRAME_HEIGHT, 0x8410);
+    render_fill_rect(framebuffer, BLOCK_SIZE, BLOCK_SIZE, FRAME_WIDTH - 2 * BLOCK_SIZE, FRAME_HEIGHT - 2 * BLOCK_SIZE,
+                     0x0000);
+
+    const int inner = (grid_w - 2) * (grid_h - 2);
+    const int head = frame / 4;
+    for (int i = 0; i < 12; ++i)
+    {
+        const int cell = (head - i + inner) % inner;
+        render_fill_cell(framebuffer, 1 + cell % (grid_w - 2), 1 + cell / (grid_w - 2), BLOCK_SIZE, 0x07E0);
+    }
+    const int food = (head / 40 * 97 + 50) % inner;
+    render_fill_cell(framebuffer, 1 + food % (grid_w - 2), 1 + food / (grid_w - 2), BLOCK_SIZE, 0xF800);
+}
+
+// frameDisplay's counter, one number per frame
+static void draw_digits(uint32_t frame)
+{
+    char str[12];
+    const int num_digits = snprintf(str, sizeof(str), "%u", (unsigned)frame);
+    const int total_width = num_digits * (DIGITS_FONT_WIDTH + 1);
+    const int x_offset = (FRAME_WIDTH - total_width) / 2;
+    const int y_offset = (FRAME_HEIGHT - DIGITS_FONT_HEIGHT) / 2;
+
+    memset(framebuffer, 0, sizeof(framebuffer));
+    for (int i = 0; i < num_digits; i++)
+    {
+        render_glyph(framebuffer, digits_font_glyph(str[i]), DIGITS_FONT_STRIDE, DIGITS_FONT_WIDTH,
+                     DIGITS_FONT_HEIGHT, x_offset + i * (DIGITS_FONT_WIDTH + 1), y_offset, 0xFFFF, 0x0000);
+    }
+}
+
+// Every line different, so every line misses and entries are replaced as soon as the DMA lets
+static void draw_noise(uint32_t frame)
+{
+    for (int i = 0; i < FRAME_WIDTH * FRAME_HEIGHT; ++i)
+    {
+        framebuffer[i] = (uint16_t)next_random();
+    }
+}
+
+typedef struct
+{
+    const char* name;
+    void (*draw)(uint32_t frame);
+} scene_t;
+
+static const scene_t scenes[] = {
+    {"snake", draw_snake},
+    {"digits", draw_digits},
+    {"noise", draw_noise},
+};
+
+// A line queued to the simulated DMA, with the pixels it was queued for
+typedef struct
+{
+    const uint32_t* tmds;
+    uint16_t pixels[SCANLINE_WIDTH];
+} sent_line_t;
+
+static sent_line_t in_flight[DVI_N_TMDS_BUFFERS];
+static uint32_t in_flight_head;
+static uint32_t in_flight_count;
+
+static bool matches_reference(const uint32_t* tmds, const uint16_t* pixels)
+{
+    static uint32_t expected[LINE_WORDS];
+    reference_encode(pixels, expected);
+    return memcmp(tmds, expected, sizeof(expected)) == 0;
+}
+
+// The DMA finishes the oldest line in flight and returns its buffer
+static bool finish_line(tmds_cache_t* cache)
+{
+    const sent_line_t* sent = &in_flight[in_flight_head];
+    const bool ok = matches_reference(sent->tmds, sent->pixels);
+    tmds_cache_release(cache, sent->tmds);
+    in_flight_head = (in_flight_head + 1) % DVI_N_TMDS_BUFFERS;
+    --in_flight_count;
+    return ok;
+}
+
+// Returns the number of buffers that did not match the reference encoding
+static uint32_t run_scene(const scene_t* scene, uint32_t frames)
+{
+    static tmds_cache_t cache;
+    tmds_cache_init(&cache, cache_pixels, cache_symbols, SCANLINE_WIDTH, LINE_WORDS, reference_encode);
+    in_flight_head = 0;
+    in_flight_count = 0;
+    uint32_t errors = 0;
+
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        scene->draw(frame);
+        for (int y = 0; y < SCANLINE_HEIGHT; ++y)
+        {
+            const uint16_t* line = &framebuffer[y / FRAME_V_REPEAT * FRAME_WIDTH];
+
+            // The DMA runs at its own pace: sometimes it has finished several lines, and when
+            // all buffers are queued core 1 waits for one
+            while (in_flight_count > 0 && (in_flight_count == DVI_N_TMDS_BUFFERS || next_random() % 3 == 0))
+                errors += !finish_line(&cache);
+
+            sent_line_t* sent = &in_flight[(in_flight_head + in_flight_count++) % DVI_N_TMDS_BUFFERS];
+            sent->tmds = tmds_cache_get(&cache, line);
+            memcpy(sent->pixels, line, sizeof(sent->pixels));
+            errors += !matches_reference(sent->tmds, sent->pixels);
+        }
+    }
+    while (in_flight_count > 0)
+        errors += !finish_line(&cache);
+
+    for (uint32_t i = 0; i < TMDS_CACHE_ENTRIES; ++i)
+    {
+        if (cache.entries[i].in_flight != 0)
+        {
+            printf("%s: entry %u still has %u lines in flight\n", scene->name, i, cache.entries[i].in_flight);
+            ++errors;
+        }
+    }
+
+    printf("%s: ", scene->name);
+    const tmds_cache_stats_t stats = *(const tmds_cache_stats_t*)&cache.stats;
+    tmds_cache_print(&stats, frames);
+    return errors;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frames = 120;
+    random_state = 2463534242u;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            frames = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            random_state = strtoul(optarg, NULL, 0) | 1;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-f frames] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    uint32_t errors = 0;
+    for (size_t s = 0; s < sizeof(scenes) / sizeof(scenes[0]); ++s)
+    {
+        errors += run_scene(&scenes[s], frames);
+    }
+
+    if (errors)
+    {
+        printf("FAIL: %u lines differ from the reference encoder\n", errors);
+        return 1;
+    }
+    printf("Every line sent matches the reference encoder\n");
+    return 0;
+}
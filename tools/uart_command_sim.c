@@ -0,0 +1,303 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024, Cytrence Technologies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Checks the UART command channel (../common/uart_command.h) on the host. uart_command.c is built
+// with its printf() going to a buffer here, bytes are delivered at the line rate of the given
+// baud rate and uart_command_poll() is called once per 60 Hz frame, as the firmware's main loop
+// does. The scenarios cover every reply, lines at and over the length limit, a burst several
+// times longer than the RX ring and a burst of more lines than the queue holds. The replies are
+// compared exactly and no byte may be dropped from the ring.
+//
+// Usage: uart_command_sim [-b baud] [-v]
+//   -v prints everything the channel prints.
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mem_report.h"
+#include "uart_command.h"
+
+#define FRAME_RATE 60
+#define SET_MAX    100
+
+static bool verbose;
+static uint32_t bytes_per_frame;
+
+static char output[1 << 16];
+static size_t output_len;
+
+static int32_t values[1024];
+static uint32_t value_count;
+
+// Everything uart_command.c prints ends up here
+int sim_printf(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int n = vsnprintf(output + output_len, sizeof(output) - output_len, format, args);
+    va_end(args);
+    if (verbose)
+        fwrite(output + output_len, 1, n, stdout);
+    output_len += n;
+    return n;
+}
+
+void mem_report_print(void)
+{
+    sim_printf("mem report\r\n");
+}
+
+static bool command_echo(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        sim_printf(i + 1 < argc ? "%s " : "%s\r\n", argv[i]);
+    }
+    return argc > 1;
+}
+
+static bool command_set(int argc, char** argv)
+{
+    int32_t value;
+    if (argc != 2 || !uart_command_parse_int(argv[1], 0, SET_MAX, &value))
+        return false;
+    if (value_count < sizeof(values) / sizeof(values[0]))
+        values[value_count++] = value;
+    return true;
+}
+
+static const uart_command_t commands[] = {
+    {"echo", "<words>", command_echo},
+    {"set", "<0..100>", command_set},
+};
+
+static void reset(void)
+{
+    uart_command_init(NULL, commands, sizeof(commands) / sizeof(commands[0]));
+    output_len = 0;
+    output[0] = '\0';
+    value_count = 0;
+}
+
+// Deliver text at the line rate, polling once per frame, then keep polling until the queue
+// has been worked off
+static void send(const char* text)
+{
+    const uint32_t length = strlen(text);
+    uint32_t sent = 0;
+    while (sent < length)
+    {
+        uint32_t n = length - sent;
+        if (n > bytes_per_frame)
+            n = bytes_per_frame;
+        uart_command_receive(text + sent, n);
+        sent += n;
+        uart_command_poll();
+    }
+    for (int i = 0; i < UART_COMMAND_QUEUE; ++i)
+    {
+        uart_command_poll();
+    }
+}
+
+static uint32_t check_output(const char* name, const char* expected)
+{
+    if (strcmp(output, expected) == 0)
+        return 0;
+    printf("%s: replies differ\n--- expected\n%s--- got\n%s---\n", name, expected, output);
+    return 1;
+}
+
+static uint32_t check_values(const char* name, const int32_t* expected, uint32_t count)
+{
+    if (value_count == count && memcmp(values, expected, count * sizeof(int32_t)) == 0)
+        return 0;
+    printf("%s: %u commands ran, expected %u\n", name, value_count, count);
+    return 1;
+}
+
+static uint32_t replies(void)
+{
+    reset();
+    send("echo hello world\r\n"
+         "set 42\n"
+         "set 500\n"
+         "bogus\n"
+         "echo 1 2 3 4 5 6\n"
+         "\r\n"
+         "   \n"
+         "sex\bt 7\n"
+         "m\n");
+    static const int32_t expected[] = {42, 7};
+    return check_output("replies", "hello world\r\nOK\r\n"
+                                   "OK\r\n"
+                                   "ERR usage: set <0..100>\r\n"
+                                   "ERR unknown command bogus, try help\r\n"
+                                   "ERR too many arguments\r\n"
+                                   "OK\r\n"
+                                   "mem report\r\nOK\r\n") +
+           check_values("replies", expected, 2);
+}
+
+static uint32_t long_lines(void)
+{
+    char input[512];
+    char expected[512];
+    char longest[UART_COMMAND_MAX_LINE + 1];
+
+    // A line of exactly UART_COMMAND_MAX_LINE characters is taken, one more is not
+    memset(longest, 'y', UART_COMMAND_MAX_LINE);
+    memcpy(longest, "echo ", 5);
+    longest[UART_COMMAND_MAX_LINE] = '\0';
+
+    reset();
+    snprintf(input, sizeof(input), "echo %0200d\nset 3\n%s\n%sy\nset 4\n", 0, longest, longest);
+    send(input);
+    snprintf(expected, sizeof(expected), "ERR line too long\r\nOK\r\n%s\r\nOK\r\nERR line too long\r\nOK\r\n",
+             longest + 5);
+    static const int32_t set[] = {3, 4};
+    return check_output("long lines", expected) + check_values("long lines", set, 2);
+}
+
+// Overlong lines between commands, several times the size of the ring, arriving without a pause
+static uint32_t long_burst(void)
+{
+    char input[4096];
+    char expected[512];
+    size_t in = 0;
+    size_t out = 0;
+    int32_t set[8];
+
+    reset();
+    for (int i = 0; i < 8; ++i)
+    {
+        memset(input + in, 'z', 400);
+        in += 400;
+        in += snprintf(input + in, sizeof(input) - in, "\nset %d\n", i);
+        out += snprintf(expected + out, sizeof(expected) - out, "ERR line too long\r\nOK\r\n");
+        set[i] = i;
+    }
+    printf("long burst: %zu bytes, ring %u\n", in, UART_COMMAND_RX_BUFFER);
+    send(input);
+    return check_output("long burst", expected) + check_values("long burst", set, 8);
+}
+
+// More lines than the queue holds: every line is either run in order or counted in the reply
+// that stands in for it
+static uint32_t many_lines(void)
+{
+    char input[4096];
+    size_t in = 0;
+    uart_command_stats_t before;
+    uart_command_stats_t after;
+
+    reset();
+    for (int i = 0; i <= SET_MAX; ++i)
+    {
+        in += snprintf(input + in, sizeof(input) - in, "set %d\n", i);
+    }
+    uart_command_get_stats(&before);
+    send(input);
+    uart_command_get_stats(&after);
+
+    uint32_t next = 0;
+    uint32_t ran = 0;
+    uint32_t lost = 0;
+    for (const char* reply = output; *reply != '\0'; reply = strchr(reply, '\n') + 1)
+    {
+        unsigned long n;
+        if (strncmp(reply, "OK\r\n", 4) == 0)
+        {
+            if (ran >= value_count || values[ran] != (int32_t)next)
+            {
+                printf("many lines: OK for set %u does not match the command run\n", next);
+                return 1;
+            }
+            ++ran;
+            ++next;
+        }
+        else if (sscanf(reply, "ERR command queue full, %lu lines lost\r", &n) == 1)
+        {
+            next += n;
+            lost += n;
+        }
+        else
+        {
+            printf("many lines: unexpected reply %.*s\n", (int)strcspn(reply, "\r\n"), reply);
+            return 1;
+        }
+    }
+    printf("many lines: %d lines, %u run, %u lost\n", SET_MAX + 1, ran, lost);
+    if (next != SET_MAX + 1 || ran != value_count || after.lost - before.lost != lost)
+    {
+        printf("many lines: %u lines accounted for, stats count %u lost\n", next, after.lost - before.lost);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t baud = 115200;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            baud = strtoul(optarg, NULL, 0);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-b baud] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    bytes_per_frame = baud / 10 / FRAME_RATE;
+    if (bytes_per_frame == 0)
+        bytes_per_frame = 1;
+    printf("%u baud, %u bytes per frame\n", baud, bytes_per_frame);
+
+    const uint32_t errors = replies() + long_lines() + long_burst() + many_lines();
+
+    uart_command_stats_t stats;
+    uart_command_get_stats(&stats);
+    printf("UART: %u bytes, %u dropped, ring peak %u of %u\n", stats.bytes, stats.dropped, stats.max_fill,
+           UART_COMMAND_RX_BUFFER);
+    if (errors || stats.dropped)
+    {
+        printf("Check: FAIL\n");
+        return 1;
+    }
+    printf("Check: OK\n");
+    return 0;
+}